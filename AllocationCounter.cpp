@@ -0,0 +1,56 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+static thread_local AllocationCount thread_allocations;
+
+AllocationCount AllocationCount::operator-(const AllocationCount& other) const
+{
+	AllocationCount result;
+	result.count = count - other.count;
+	result.bytes = bytes - other.bytes;
+	return result;
+}
+
+bool AllocationCounter::isEnabled()
+{
+#ifdef COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+AllocationCount AllocationCounter::get()
+{
+	return thread_allocations;
+}
+
+#ifdef COUNT_ALLOCATIONS
+static void* countedAlloc(size_t size)
+{
+	thread_allocations.count++;
+	thread_allocations.bytes += size;
+	void* p = std::malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	thread_allocations.count++;
+	thread_allocations.bytes += size;
+	return std::malloc(size > 0 ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
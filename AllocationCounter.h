@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+
+/*
+	Heap allocations of the calling thread (operator new), for measuring allocation churn of a piece of code:
+		AllocationCount before = AllocationCounter::get(); ...; AllocationCount used = AllocationCounter::get() - before;
+
+	Build with COUNT_ALLOCATIONS defined, it replaces global operator new / delete (program wide).
+	Otherwise nothing is replaced and isEnabled() is false (counts stay 0).
+	malloc & allocations of C libraries (stb_image) aren't seen.
+*/
+
+struct AllocationCount {
+	size_t count = 0;
+	size_t bytes = 0; // requested
+
+	AllocationCount operator-(const AllocationCount& other) const;
+};
+
+class AllocationCounter
+{
+public:
+	static bool isEnabled();
+	static AllocationCount get(); // since thread start
+};
@@ -0,0 +1,314 @@
+#include "BatchRenderer.h"
+#include "GLExtensions.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const double FRAME_TIME = 1.0 / 60.0;
+static const double LOAD_TIMEOUT = 300.0; // seconds per model / view
+
+BatchRenderer::BatchRenderer()
+{
+}
+
+bool BatchRenderer::readList(const std::string& path, std::vector<std::string>& models)
+{
+	std::ifstream file(path);
+	if (!file) {
+		std::cout << "ERROR: can't read model list " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		line.erase(line.find_last_not_of(" \t\r\n") + 1);
+		line.erase(0, line.find_first_not_of(" \t"));
+		if (line.empty() || line[0] == '#') continue;
+		models.push_back(line);
+	}
+	return true;
+}
+
+bool BatchRenderer::run(const BatchOptions& options)
+{
+	this->options = options;
+	stats = BatchStats();
+	next_asset = 0;
+	failed = 0;
+	images_written = 0;
+	encoding_done = false;
+
+#ifdef _WIN32
+	_mkdir(options.output_dir.c_str());
+#else
+	mkdir(options.output_dir.c_str(), 0755);
+#endif
+
+	// contexts are created here, each job makes its own current
+	int jobs = (int)std::min<size_t>(std::max(options.jobs, 1), std::max<size_t>(options.models.size(), 1));
+	std::vector<HeadlessContext*> contexts;
+	for (int i = 0; i < jobs; ++i) {
+		HeadlessContext* context = new HeadlessContext();
+		if (!context->create(options.gl_major, options.gl_minor)) {
+			delete context;
+			break;
+		}
+		contexts.push_back(context);
+	}
+	if (contexts.empty()) return false;
+	if (contexts.size() < (size_t)jobs) std::cout << "WARN: only " << contexts.size() << " of " << jobs << " contexts created" << std::endl;
+
+	// function pointers are the same for all contexts of one driver
+	if (!gladLoadGLLoader(contexts.back()->getLoader())) {
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		for (auto context : contexts) {
+			context->destroy();
+			delete context;
+		}
+		return false;
+	}
+	loadGLExtensions(contexts.back()->getLoader());
+	contexts.back()->release();
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < std::max(options.encoders, 1); ++i) {
+		encoder_threads.push_back(std::thread(&BatchRenderer::encoder, this));
+	}
+
+	std::vector<std::thread> workers;
+	for (auto context : contexts) {
+		workers.push_back(std::thread(&BatchRenderer::worker, this, context));
+	}
+	for (auto& worker : workers) worker.join();
+
+	{
+		std::lock_guard<std::mutex> lock(images_mutex);
+		encoding_done = true;
+	}
+	images_cv.notify_all();
+	for (auto& thread : encoder_threads) thread.join();
+	encoder_threads.clear();
+
+	for (auto context : contexts) {
+		context->destroy();
+		delete context;
+	}
+
+	stats.assets = options.models.size();
+	stats.failed = failed;
+	stats.images = images_written;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats.assets_per_minute = stats.seconds > 0.0 ? stats.assets * 60.0 / stats.seconds : 0.0;
+
+	std::cout << "Batch: " << stats.assets << " models (" << stats.failed << " failed), " << stats.images << " images in "
+		<< stats.seconds << " s, " << stats.assets_per_minute << " models/min (" << contexts.size() << " contexts)" << std::endl;
+	return true;
+}
+
+const BatchStats& BatchRenderer::getStats() const
+{
+	return stats;
+}
+
+// Job (own context)
+void BatchRenderer::worker(HeadlessContext* context)
+{
+	PROFILE_THREAD("batch job");
+	if (!context->makeCurrent()) {
+		std::cout << "ERROR: context of batch job can't be made current" << std::endl;
+		return;
+	}
+
+	RenderTarget target;
+	if (target.init(options.width, options.height)) {
+		// next model loads in background while current one is rendered
+		Asset current = startAsset();
+		while (current.scene != nullptr) {
+			Asset next = startAsset();
+			renderAsset(current, target);
+			finishAsset(current);
+			current = next;
+		}
+		target.cleanup();
+	}
+	context->release();
+}
+
+BatchRenderer::Asset BatchRenderer::startAsset()
+{
+	Asset asset;
+	asset.index = next_asset++;
+	if (asset.index >= options.models.size()) return asset;
+
+	asset.scene = new GLTFScene();
+	if (!options.scene_file.empty()) asset.scene->scene_json_file = options.scene_file;
+	asset.scene->setModels({ options.models[asset.index] });
+	asset.scene->init();
+	asset.scene->render_setup();
+	asset.scene->scene_init();
+	return asset;
+}
+
+void BatchRenderer::finishAsset(Asset& asset)
+{
+	asset.scene->cleanup();
+	delete asset.scene;
+	asset.scene = nullptr;
+}
+
+void BatchRenderer::renderFrame(Asset& asset, RenderTarget& target)
+{
+	target.bind();
+	asset.scene->render(options.width, options.height, asset.frame++ * FRAME_TIME);
+}
+
+bool BatchRenderer::waitLoaded(Asset& asset, RenderTarget& target)
+{
+	auto start = std::chrono::steady_clock::now();
+	do {
+		renderFrame(asset, target);
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > LOAD_TIMEOUT) return false;
+	} while (asset.scene->isLoading());
+	return true;
+}
+
+void BatchRenderer::renderAsset(Asset& asset, RenderTarget& target)
+{
+	PROFILE_ZONE("BatchRenderer::renderAsset");
+	const std::string& path = options.models[asset.index];
+	GLTFScene& scene = *asset.scene;
+	auto start = std::chrono::steady_clock::now();
+
+	bool loaded = waitLoaded(asset, target);
+	GLTFModel* model = scene.getModels().empty() ? nullptr : scene.getModels()[0];
+	if (!loaded || model == nullptr || model->getLoadState() == LoadState::Failed) {
+		std::cout << "ERROR: batch model " << path << (loaded ? " failed to load" : " timed out") << std::endl;
+		failed++;
+		return;
+	}
+
+	// world bounds of all mesh nodes
+	glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+	for (const MeshBounds& mb : model->getBounds()) {
+		glm::mat4 world = model->getMeshWorld(mb.node_world);
+		for (int c = 0; c < 8; ++c) {
+			glm::vec3 corner((c & 1) ? mb.max.x : mb.min.x, (c & 2) ? mb.max.y : mb.min.y, (c & 4) ? mb.max.z : mb.min.z);
+			glm::vec3 p = glm::vec3(world * glm::vec4(corner, 1.0f));
+			bmin = glm::min(bmin, p);
+			bmax = glm::max(bmax, p);
+		}
+	}
+	if (bmin.x > bmax.x) {
+		std::cout << "ERROR: batch model " << path << " has no meshes" << std::endl;
+		failed++;
+		return;
+	}
+
+	// distance where bounding sphere fits narrower field of view
+	Camera& camera = scene.getCamera();
+	glm::vec3 center = (bmin + bmax) * 0.5f;
+	float radius = std::max(glm::length(bmax - bmin) * 0.5f, 1e-4f);
+	float fov_y = glm::radians(camera.Zoom);
+	float fov_x = 2.0f * atan(tan(fov_y * 0.5f) * options.width / options.height);
+	float distance = radius / sin(std::min(fov_x, fov_y) * 0.5f);
+	scene.setDepthRange((distance - radius) * 0.5f, (distance + radius) * 2.0f);
+
+	// views are read back async, oldest is finished when all slots are in flight
+	struct PendingRead {
+		int slot;
+		int view;
+	};
+	std::deque<PendingRead> reads;
+	auto finishOldest = [&]() {
+		Image image;
+		image.path = getImagePath(asset.index, reads.front().view);
+		target.finishRead(reads.front().slot, image.pixels);
+		reads.pop_front();
+		pushImage(image);
+	};
+
+	for (int view = 0; view < options.views; ++view) {
+		float yaw = YAW + 360.0f * view / options.views;
+		glm::vec3 front;
+		front.x = cos(glm::radians(yaw)) * cos(glm::radians(options.pitch));
+		front.y = sin(glm::radians(options.pitch));
+		front.z = sin(glm::radians(yaw)) * cos(glm::radians(options.pitch));
+		camera.SetPose(center - front * distance, yaw, options.pitch);
+
+		// finer mips for this view
+		if (!waitLoaded(asset, target)) std::cout << "WARN: textures of " << path << " still streaming, view " << view << std::endl;
+
+		int slot = target.beginRead();
+		if (slot < 0) {
+			finishOldest();
+			slot = target.beginRead();
+		}
+		reads.push_back({ slot, view });
+	}
+	while (!reads.empty()) finishOldest();
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Batch: " << path << " rendered in " << ms << " ms (" << asset.frame << " frames)" << std::endl;
+}
+
+std::string BatchRenderer::getImagePath(size_t asset, int view) const
+{
+	// folder & file name, glTF exports are often just "scene.gltf"
+	std::string path = options.models[asset];
+	std::replace(path.begin(), path.end(), '\\', '/');
+	size_t slash = path.find_last_of('/');
+	std::string file = slash == std::string::npos ? path : path.substr(slash + 1);
+	file = file.substr(0, file.find_last_of('.'));
+	std::string folder;
+	if (slash != std::string::npos && slash > 0) {
+		size_t prev = path.find_last_of('/', slash - 1);
+		folder = path.substr(prev == std::string::npos ? 0 : prev + 1, slash - (prev == std::string::npos ? 0 : prev + 1));
+	}
+	if (folder == "." || folder == "..") folder.clear();
+
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "_%02d.png", view);
+	return options.output_dir + "/" + (folder.empty() ? "" : folder + "_") + file + suffix;
+}
+
+// PNG encoding
+void BatchRenderer::pushImage(Image& image)
+{
+	std::unique_lock<std::mutex> lock(images_mutex);
+	images_cv.wait(lock, [this]() { return images.size() < MAX_QUEUED_IMAGES; });
+	images.push_back(std::move(image));
+	lock.unlock();
+	images_cv.notify_all();
+}
+
+void BatchRenderer::encoder()
+{
+	PROFILE_THREAD("png encoder");
+	while (true) {
+		Image image;
+		{
+			std::unique_lock<std::mutex> lock(images_mutex);
+			images_cv.wait(lock, [this]() { return !images.empty() || encoding_done; });
+			if (images.empty()) return;
+			image = std::move(images.front());
+			images.pop_front();
+		}
+		images_cv.notify_all(); // space for renderers
+
+		PROFILE_ZONE("BatchRenderer::encode");
+		if (RenderTarget::writePNG(image.path, options.width, options.height, image.pixels)) images_written++;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "GLTFScene.h"
+#include "HeadlessContext.h"
+#include "RenderTarget.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*
+	Batch thumbnails: every model of a list is rendered offscreen from turntable views
+	and written as PNG (<output_dir>/<folder>_<file>_<view>.png).
+
+	Each job is a thread with its own headless context, taking models from the list one by one.
+	While a model is rendered, the next one is already parsed & decoded on its loader thread.
+	Frames are read back through pixel buffers and encoded to PNG by encoder threads.
+
+	Models are framed by their bounds (yaw steps around Y axis, fixed pitch), each view is rendered
+	until its textures are streamed in. Scene file still gives settings (budgets, texture modes).
+*/
+
+struct BatchOptions {
+	std::vector<std::string> models;
+	int views = 8;			// turntable views per model
+	float pitch = -20.0f;	// degrees, camera looks slightly down
+	int width = 256;
+	int height = 256;
+	int jobs = 2;			// gl contexts (threads)
+	int encoders = 2;		// png threads
+	std::string output_dir = "thumbnails";
+	std::string scene_file;	// settings, empty - GLTFScene default
+	int gl_major = 3;
+	int gl_minor = 3;
+};
+
+struct BatchStats {
+	size_t assets = 0;
+	size_t failed = 0;
+	size_t images = 0;
+	double seconds = 0.0;
+	double assets_per_minute = 0.0;
+};
+
+class BatchRenderer
+{
+public:
+	BatchRenderer();
+
+	bool run(const BatchOptions& options); // false - no context could be created
+	const BatchStats& getStats() const;
+
+	static bool readList(const std::string& path, std::vector<std::string>& models); // one path per line, # comments
+
+private:
+	struct Asset {
+		size_t index = 0;
+		GLTFScene* scene = nullptr;
+		long long frame = 0; // drives FrameData time
+	};
+
+	struct Image {
+		std::string path;
+		std::vector<unsigned char> pixels;
+	};
+
+	void worker(HeadlessContext* context);
+	Asset startAsset();
+	void finishAsset(Asset& asset);
+	void renderAsset(Asset& asset, RenderTarget& target);
+	bool waitLoaded(Asset& asset, RenderTarget& target);
+	void renderFrame(Asset& asset, RenderTarget& target);
+
+	void encoder();
+	void pushImage(Image& image);
+
+	std::string getImagePath(size_t asset, int view) const;
+
+private:
+	BatchOptions options;
+	BatchStats stats;
+
+	std::atomic<size_t> next_asset{ 0 };
+	std::atomic<size_t> failed{ 0 };
+	std::atomic<size_t> images_written{ 0 };
+
+	// png encoding
+	std::vector<std::thread> encoder_threads;
+	std::deque<Image> images;
+	std::mutex images_mutex;
+	std::condition_variable images_cv;
+	bool encoding_done = false;
+
+	static const size_t MAX_QUEUED_IMAGES = 32; // renderers wait above this
+};
@@ -0,0 +1,285 @@
+#include "Benchmark.h"
+#include "GLTFScene.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+Benchmark::Benchmark()
+{
+}
+
+bool Benchmark::load(const std::string& path)
+{
+	this->path = path;
+
+	std::ifstream f(path);
+	if (!f) {
+		std::cout << "ERROR: can't read benchmark path " << path << std::endl;
+		return false;
+	}
+	nlohmann::json json = nlohmann::json::parse(f, nullptr, false);
+	if (json.is_discarded() || !json.contains("keys") || json["keys"].empty()) {
+		std::cout << "ERROR: benchmark path " << path << " is not valid (needs \"keys\")" << std::endl;
+		return false;
+	}
+
+	if (json.contains("frames")) frames = json["frames"].get<int>();
+	if (json.contains("step")) step = json["step"].get<double>();
+	if (json.contains("warmup")) warmup = json["warmup"].get<int>();
+
+	keys.clear();
+	for (auto& k : json["keys"]) {
+		BenchmarkKey key;
+		if (k.contains("time")) key.time = k["time"].get<double>();
+		if (k.contains("pos")) {
+			std::vector<float> pos = k["pos"];
+			if (pos.size() >= 3) key.pos = glm::vec3(pos[0], pos[1], pos[2]);
+		}
+		if (k.contains("yaw")) key.yaw = k["yaw"].get<float>();
+		if (k.contains("pitch")) key.pitch = k["pitch"].get<float>();
+		keys.push_back(key);
+	}
+	std::stable_sort(keys.begin(), keys.end(), [](const BenchmarkKey& a, const BenchmarkKey& b) { return a.time < b.time; });
+
+	frames = std::max(frames, 1);
+	warmup = std::max(warmup, 0);
+	cpu_ms.reserve(frames);
+	gpu_ms.reserve(frames);
+	frame_ms.reserve(frames);
+	draw_calls.reserve(frames);
+	triangles.reserve(frames);
+
+	std::cout << "Benchmark: " << path << ", " << frames << " frames (+" << warmup << " warmup), step " << step << " s" << std::endl;
+	return true;
+}
+
+void Benchmark::cleanup()
+{
+	if (queries_created) glDeleteQueries(QUERY_RING * 2, &queries[0][0]);
+	queries_created = false;
+}
+
+bool Benchmark::isFinished() const
+{
+	return (int)cpu_ms.size() >= frames;
+}
+
+bool Benchmark::isMeasuring() const
+{
+	return measuring;
+}
+
+void Benchmark::placeCamera(GLTFScene& scene, double time)
+{
+	// linear between keys, clamped at both ends
+	size_t next = 0;
+	while (next < keys.size() && keys[next].time <= time) next++;
+
+	BenchmarkKey key;
+	if (next == 0) key = keys.front();
+	else if (next == keys.size()) key = keys.back();
+	else {
+		const BenchmarkKey& a = keys[next - 1];
+		const BenchmarkKey& b = keys[next];
+		float t = (float)((time - a.time) / (b.time - a.time));
+		key.pos = glm::mix(a.pos, b.pos, t);
+		key.yaw = glm::mix(a.yaw, b.yaw, t);
+		key.pitch = glm::mix(a.pitch, b.pitch, t);
+	}
+	scene.getCamera().SetPose(key.pos, key.yaw, key.pitch);
+}
+
+// Frame
+double Benchmark::beginFrame(GLTFScene& scene)
+{
+	if (!queries_created) {
+		glGenQueries(QUERY_RING * 2, &queries[0][0]);
+		queries_created = true;
+	}
+
+	// loading frames look at the start of the path (so its textures are streamed in)
+	if (loading) {
+		auto now = std::chrono::steady_clock::now();
+		if (loading_frames > 0) loading_frame_ms.push_back(std::chrono::duration<double, std::milli>(now - loading_frame_start).count());
+		loading_frame_start = now;
+
+		if (loading_frames > 0 && !scene.isLoading()) {
+			loading = false;
+			std::cout << "Benchmark: scene loaded after " << loading_frames << " frames, running" << std::endl;
+		}
+		else {
+			loading_frames++;
+			measuring = false;
+			placeCamera(scene, 0.0);
+			return loading_frames * step;
+		}
+	}
+
+	frame++;
+	measuring = frame >= warmup;
+	double path_time = frame * step;
+	placeCamera(scene, path_time);
+
+	frame_start = std::chrono::steady_clock::now();
+	if (measuring) {
+		if (has_last_frame) frame_ms.push_back(std::chrono::duration<double, std::milli>(frame_start - last_frame_start).count());
+		last_frame_start = frame_start;
+		has_last_frame = true;
+
+		// slot still in flight (gpu far behind): its result is needed, wait for it
+		int slot = query_index;
+		if (query_pending[slot]) readQueries(true);
+		glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+	}
+	return frame * step;
+}
+
+void Benchmark::endFrame(GLTFScene& scene)
+{
+	if (!measuring) return;
+
+	int slot = query_index;
+	glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+	query_frame[slot] = (int)cpu_ms.size();
+	query_pending[slot] = true;
+	query_index = (query_index + 1) % QUERY_RING;
+
+	cpu_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+	gpu_ms.push_back(-1.0);
+	draw_calls.push_back(scene.getRenderStats().draw_calls);
+	triangles.push_back(scene.getRenderStats().triangles);
+
+	readQueries(false);
+}
+
+void Benchmark::readQueries(bool wait)
+{
+	for (int i = 0; i < QUERY_RING; ++i) {
+		if (!query_pending[i]) continue;
+
+		if (!wait) {
+			GLint available = 0;
+			glGetQueryObjectiv(queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) continue;
+		}
+
+		GLuint64 t_begin = 0, t_end = 0;
+		glGetQueryObjectui64v(queries[i][0], GL_QUERY_RESULT, &t_begin);
+		glGetQueryObjectui64v(queries[i][1], GL_QUERY_RESULT, &t_end);
+		query_pending[i] = false;
+		gpu_ms[query_frame[i]] = (double)(t_end - t_begin) / 1e6;
+	}
+}
+
+// Report
+BenchmarkTimes Benchmark::getTimes(std::vector<double> values)
+{
+	BenchmarkTimes times;
+	if (values.empty()) return times;
+
+	std::sort(values.begin(), values.end());
+	auto percentile = [&values](double p) {
+		// nearest rank
+		size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+		return values[std::min(std::max(rank, (size_t)1), values.size()) - 1];
+	};
+
+	double sum = 0.0;
+	for (double v : values) sum += v;
+	times.mean = sum / values.size();
+	times.p50 = percentile(50.0);
+	times.p90 = percentile(90.0);
+	times.p99 = percentile(99.0);
+	times.max = values.back();
+	return times;
+}
+
+static nlohmann::json timesToJson(const BenchmarkTimes& times)
+{
+	nlohmann::json json;
+	json["mean"] = times.mean;
+	json["p50"] = times.p50;
+	json["p90"] = times.p90;
+	json["p99"] = times.p99;
+	json["max"] = times.max;
+	return json;
+}
+
+template <typename T>
+static nlohmann::json countsToJson(const std::vector<T>& values)
+{
+	double sum = 0.0;
+	T max = 0;
+	for (T v : values) {
+		sum += (double)v;
+		max = std::max(max, v);
+	}
+	nlohmann::json json;
+	json["mean"] = values.empty() ? 0.0 : sum / values.size();
+	json["max"] = max;
+	return json;
+}
+
+void Benchmark::report(int width, int height, const std::string& mode)
+{
+	readQueries(true);
+
+	std::vector<double> gpu_resolved;
+	for (double ms : gpu_ms) if (ms >= 0.0) gpu_resolved.push_back(ms);
+
+	BenchmarkTimes cpu = getTimes(cpu_ms);
+	BenchmarkTimes gpu = getTimes(gpu_resolved);
+	BenchmarkTimes wall = getTimes(frame_ms);
+	BenchmarkTimes loading_wall = getTimes(loading_frame_ms);
+	std::cout << "Benchmark (" << mode << " " << width << "x" << height << ", " << cpu_ms.size() << " frames):" << std::endl
+		<< "  cpu ms   p50 " << cpu.p50 << ", p90 " << cpu.p90 << ", p99 " << cpu.p99 << ", max " << cpu.max << std::endl
+		<< "  gpu ms   p50 " << gpu.p50 << ", p90 " << gpu.p90 << ", p99 " << gpu.p99 << ", max " << gpu.max << std::endl
+		<< "  frame ms p50 " << wall.p50 << ", p90 " << wall.p90 << ", p99 " << wall.p99 << ", max " << wall.max << std::endl
+		<< "  loading frame ms p50 " << loading_wall.p50 << ", p90 " << loading_wall.p90 << ", p99 " << loading_wall.p99
+		<< ", max " << loading_wall.max << " (" << loading_frame_ms.size() << " frames)" << std::endl
+		<< "  draw calls " << countsToJson(draw_calls)["mean"].get<double>()
+		<< ", triangles " << countsToJson(triangles)["mean"].get<double>() << " per frame" << std::endl;
+}
+
+bool Benchmark::writeReport(const std::string& out_path, int width, int height, const std::string& mode)
+{
+	readQueries(true);
+
+	std::vector<double> gpu_resolved;
+	for (double ms : gpu_ms) if (ms >= 0.0) gpu_resolved.push_back(ms);
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	const char* version = (const char*)glGetString(GL_VERSION);
+
+	nlohmann::json json;
+	json["path"] = path;
+	json["mode"] = mode;
+	json["width"] = width;
+	json["height"] = height;
+	json["frames"] = cpu_ms.size();
+	json["warmup"] = warmup;
+	json["step"] = step;
+	json["loading_frames"] = loading_frames;
+	json["renderer"] = renderer ? renderer : "";
+	json["gl_version"] = version ? version : "";
+	json["cpu_ms"] = timesToJson(getTimes(cpu_ms));
+	json["gpu_ms"] = timesToJson(getTimes(gpu_resolved));
+	json["gpu_frames"] = gpu_resolved.size();
+	json["frame_ms"] = timesToJson(getTimes(frame_ms));
+	json["loading_frame_ms"] = timesToJson(getTimes(loading_frame_ms));
+	json["draw_calls"] = countsToJson(draw_calls);
+	json["triangles"] = countsToJson(triangles);
+
+	std::ofstream f(out_path);
+	f << json.dump(4);
+	if (!f) {
+		std::cout << "ERROR: can't write benchmark result " << out_path << std::endl;
+		return false;
+	}
+	std::cout << "Benchmark result: " << out_path << std::endl;
+	return true;
+}
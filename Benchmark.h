@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class GLTFScene;
+
+
+/*
+	Flythrough benchmark: camera follows a scripted path (json) with fixed time step,
+	so every run renders the same frames. See benchmark_path.json:
+		"frames" - measured frames, "step" - seconds per frame, "warmup" - frames before measuring,
+		"keys" - camera keys { "time", "pos", "yaw", "pitch" }, interpolated linearly (clamped at the ends)
+
+	Frames rendered before the scene is loaded (models, uploads, shader variants) aren't measured,
+	only their wall times are reported separately (upload hitches next to the measured frames).
+	Per measured frame: cpu time of GLTFScene::render, gpu time (GL_TIMESTAMP queries around it,
+	read back a few frames later), wall time between frames (includes swap / readback) and draw counters.
+
+	Loop: while (!isFinished()) { time = beginFrame(scene); scene.render(w, h, time); endFrame(scene); }
+*/
+
+struct BenchmarkKey {
+	double time = 0.0;
+	glm::vec3 pos = glm::vec3(0.0f);
+	float yaw = -90.0f;
+	float pitch = 0.0f;
+};
+
+// Statistics of one frame time (ms)
+struct BenchmarkTimes {
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+class Benchmark
+{
+public:
+	Benchmark();
+
+	bool load(const std::string& path);
+	void cleanup();
+
+	bool isFinished() const;
+	bool isMeasuring() const; // frame since last beginFrame is measured
+	double beginFrame(GLTFScene& scene); // places camera, returns scene time (seconds)
+	void endFrame(GLTFScene& scene);
+
+	// after isFinished, waits for remaining gpu times
+	void report(int width, int height, const std::string& mode);
+	bool writeReport(const std::string& path, int width, int height, const std::string& mode);
+
+	static BenchmarkTimes getTimes(std::vector<double> values);
+
+private:
+	void placeCamera(GLTFScene& scene, double time);
+	void readQueries(bool wait);
+
+private:
+	std::string path;
+	std::vector<BenchmarkKey> keys;
+	int frames = 600;
+	double step = 1.0 / 60.0;
+	int warmup = 30;
+
+	// state
+	bool loading = true; // scene still loading, frames not counted
+	int loading_frames = 0;
+	std::chrono::steady_clock::time_point loading_frame_start;
+	std::vector<double> loading_frame_ms; // wall time between loading frames
+	int frame = -1; // path frame (warmup + measured), -1 - not started
+	bool measuring = false; // current frame is measured
+	std::chrono::steady_clock::time_point frame_start;
+	std::chrono::steady_clock::time_point last_frame_start;
+	bool has_last_frame = false;
+
+	// per measured frame
+	std::vector<double> cpu_ms;
+	std::vector<double> gpu_ms; // < 0 - not resolved
+	std::vector<double> frame_ms;
+	std::vector<size_t> draw_calls;
+	std::vector<size_t> triangles;
+
+	// timestamps (begin, end) per ring slot & measured frame they belong to
+	static const int QUERY_RING = 8;
+	GLuint queries[QUERY_RING][2] = {};
+	int query_frame[QUERY_RING] = {};
+	bool query_pending[QUERY_RING] = {};
+	int query_index = 0;
+	bool queries_created = false;
+};
@@ -0,0 +1,162 @@
+#include "BufferRing.h"
+#include "GLExtensions.h"
+
+#include <chrono>
+#include <iostream>
+
+BufferRing::BufferRing()
+{
+}
+
+void BufferRing::init(GLenum target, size_t frame_size, size_t alignment)
+{
+	this->target = target;
+	this->alignment = alignment > 0 ? alignment : 1;
+	this->frame_size = (frame_size + this->alignment - 1) / this->alignment * this->alignment;
+	persistent = getGLExtensions().buffer_storage;
+
+	createBuffer();
+}
+
+void BufferRing::cleanup()
+{
+	releaseBuffer();
+}
+
+void BufferRing::createBuffer()
+{
+	size_t size = frame_size * FRAMES;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, nullptr, flags);
+		mapped = (unsigned char*)glMapBufferRange(target, 0, size, flags);
+		if (mapped == nullptr) std::cout << "ERROR: persistent mapping of buffer ring failed" << std::endl;
+	}
+	else glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(target, 0);
+}
+
+void BufferRing::releaseBuffer()
+{
+	for (auto& fence : fences) {
+		if (fence != 0) glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (buffer != 0) {
+		if (mapped != nullptr) {
+			glBindBuffer(target, buffer);
+			glUnmapBuffer(target);
+			glBindBuffer(target, 0);
+		}
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	mapped = nullptr;
+	writing = false;
+}
+
+void BufferRing::reserve(size_t frame_size)
+{
+	if (frame_size <= this->frame_size) return;
+
+	// other regions may be in flight, old buffer must not be deleted under them
+	for (auto& fence : fences) {
+		if (fence != 0) glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	}
+	releaseBuffer();
+
+	// grow by half more, so it doesn't happen every frame while scene is loading
+	frame_size += frame_size / 2;
+	this->frame_size = (frame_size + alignment - 1) / alignment * alignment;
+	createBuffer();
+}
+
+// Frame
+void BufferRing::beginFrame()
+{
+	frame = (frame + 1) % FRAMES;
+	written = 0;
+	wait_ms = 0.0;
+
+	// region was used FRAMES frames ago, GPU is most likely done with it
+	GLsync& fence = fences[frame];
+	if (fence != 0) {
+		auto start = std::chrono::steady_clock::now();
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (!persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+		glBindBuffer(target, buffer);
+		mapped = (unsigned char*)glMapBufferRange(target, frame * frame_size, frame_size, flags);
+		glBindBuffer(target, 0);
+	}
+	writing = mapped != nullptr;
+}
+
+void* BufferRing::allocate(size_t bytes, size_t& offset)
+{
+	if (!writing || written + bytes > frame_size) return nullptr;
+
+	size_t region_offset = written;
+	written += bytes;
+	offset = frame * frame_size + region_offset;
+
+	// persistent mapping covers whole buffer, otherwise only current region
+	return persistent ? mapped + offset : mapped + region_offset;
+}
+
+void BufferRing::finishWrites()
+{
+	if (!writing) return;
+	writing = false;
+
+	if (!persistent) {
+		glBindBuffer(target, buffer);
+		if (written > 0) glFlushMappedBufferRange(target, 0, written);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		mapped = nullptr;
+	}
+}
+
+void BufferRing::endFrame()
+{
+	finishWrites();
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Getters
+GLuint BufferRing::getBuffer() const
+{
+	return buffer;
+}
+
+size_t BufferRing::getFrameSize() const
+{
+	return frame_size;
+}
+
+size_t BufferRing::getBytesWritten() const
+{
+	return written;
+}
+
+double BufferRing::getWaitTime() const
+{
+	return wait_ms;
+}
+
+bool BufferRing::isPersistent() const
+{
+	return persistent;
+}
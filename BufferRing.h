@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+
+/*
+	Buffer for data written by CPU every frame (frame uniforms, per-draw data).
+
+	Buffer is split into FRAMES regions, each frame writes the next one.
+	Fence after the frame's draws protects the region until GPU is done with it,
+	so data in flight is never overwritten (beginFrame waits for it, usually it's signaled).
+
+	With GL_ARB_buffer_storage the buffer is persistently mapped, otherwise
+	the region is mapped unsynchronized in beginFrame and unmapped in finishWrites
+	(fences do the synchronization, so the driver never has to).
+
+	GL thread only.
+*/
+
+class BufferRing
+{
+public:
+	BufferRing();
+
+	void init(GLenum target, size_t frame_size, size_t alignment);
+	void cleanup();
+	void reserve(size_t frame_size); // grows buffer (waits for gpu), call before beginFrame
+
+	// Frame: beginFrame -> allocate... -> finishWrites -> draws -> endFrame
+	void beginFrame();
+	void* allocate(size_t bytes, size_t& offset); // offset in buffer, nullptr if frame region is full
+	void finishWrites(); // data is visible to GL from now on
+	void endFrame();
+
+	GLuint getBuffer() const;
+	size_t getFrameSize() const;
+	size_t getBytesWritten() const; // this (or last) frame
+	double getWaitTime() const; // ms waited for fence in beginFrame
+	bool isPersistent() const;
+
+public:
+	static const int FRAMES = 3;
+
+private:
+	void createBuffer();
+	void releaseBuffer();
+
+private:
+	GLenum target = GL_ARRAY_BUFFER;
+	GLuint buffer = 0;
+	size_t frame_size = 0; // aligned
+	size_t alignment = 1;
+
+	bool persistent = false;
+	unsigned char* mapped = nullptr; // persistent - whole buffer, otherwise current region
+
+	GLsync fences[FRAMES] = {};
+	int frame = 0; // current region
+	size_t written = 0;
+	double wait_ms = 0.0;
+	bool writing = false;
+};
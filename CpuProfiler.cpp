@@ -0,0 +1,128 @@
+#include "CpuProfiler.h"
+
+#include "json.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Zones of one thread, chunks are allocated by the writer only and never freed
+struct ThreadBuffer {
+	std::atomic<CpuZone*> chunks[CpuProfiler::MAX_CHUNKS] = {};
+	std::atomic<uint64_t> written{ 0 };
+	std::string name;
+	uint32_t id = 0;
+};
+
+std::mutex registry_mutex; // registration & dump only
+std::vector<ThreadBuffer*> registry;
+thread_local ThreadBuffer* local_buffer = nullptr;
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer* getLocalBuffer()
+{
+	if (local_buffer == nullptr) {
+		ThreadBuffer* buffer = new ThreadBuffer();
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		buffer->id = (uint32_t)registry.size() + 1;
+		registry.push_back(buffer);
+		local_buffer = buffer;
+	}
+	return local_buffer;
+}
+
+}
+
+uint64_t CpuProfiler::now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void CpuProfiler::record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+	ThreadBuffer* buffer = getLocalBuffer();
+
+	uint64_t index = buffer->written.load(std::memory_order_relaxed);
+	size_t slot = (size_t)(index % (CHUNK_ZONES * MAX_CHUNKS));
+	std::atomic<CpuZone*>& chunk = buffer->chunks[slot / CHUNK_ZONES];
+
+	CpuZone* zones = chunk.load(std::memory_order_relaxed);
+	if (zones == nullptr) {
+		zones = new CpuZone[CHUNK_ZONES];
+		chunk.store(zones, std::memory_order_release);
+	}
+
+	CpuZone& zone = zones[slot % CHUNK_ZONES];
+	zone.name = name;
+	zone.start_ns = start_ns;
+	zone.end_ns = end_ns;
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::setThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer = getLocalBuffer();
+	std::lock_guard<std::mutex> lock(registry_mutex); // read by dump
+	buffer->name = name;
+}
+
+size_t CpuProfiler::getZoneCount()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	size_t count = 0;
+	for (ThreadBuffer* buffer : registry) {
+		count += (size_t)std::min<uint64_t>(buffer->written.load(std::memory_order_acquire), CHUNK_ZONES * MAX_CHUNKS);
+	}
+	return count;
+}
+
+// Complete ("X") events in microseconds, thread names as metadata
+bool CpuProfiler::writeChromeTrace(const std::string& path)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		std::cout << "ERROR: can't write cpu trace " << path << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	size_t zones = 0;
+	bool first = true;
+	file << "{\"traceEvents\":[";
+
+	for (ThreadBuffer* buffer : registry) {
+		std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->id) : buffer->name;
+		nlohmann::json meta = { { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", buffer->id }, { "args", { { "name", name } } } };
+		file << (first ? "\n" : ",\n") << meta.dump();
+		first = false;
+
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t capacity = CHUNK_ZONES * MAX_CHUNKS;
+		uint64_t begin = written > capacity ? written - capacity : 0;
+		for (uint64_t i = begin; i < written; ++i) {
+			size_t slot = (size_t)(i % capacity);
+			CpuZone* chunk = buffer->chunks[slot / CHUNK_ZONES].load(std::memory_order_acquire);
+			if (chunk == nullptr) continue;
+
+			const CpuZone& zone = chunk[slot % CHUNK_ZONES];
+			nlohmann::json event = { { "name", zone.name ? zone.name : "?" }, { "ph", "X" }, { "pid", 1 }, { "tid", buffer->id },
+				{ "ts", zone.start_ns / 1000.0 }, { "dur", (zone.end_ns - zone.start_ns) / 1000.0 } };
+			file << ",\n" << event.dump();
+			zones++;
+		}
+	}
+	file << "\n]}\n";
+
+	if (!file) {
+		std::cout << "ERROR: can't write cpu trace " << path << std::endl;
+		return false;
+	}
+	std::cout << "CPU trace: " << zones << " zones of " << registry.size() << " threads written to " << path << std::endl;
+	return true;
+}
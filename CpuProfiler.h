@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/*
+	CPU zones: RAII scopes timed with steady_clock, written to a ring buffer of the calling thread
+	(single writer, no locks on record; a thread's buffer is registered once, on its first zone).
+	writeChromeTrace dumps zones of all threads as Chrome trace json (chrome://tracing, ui.perfetto.dev).
+
+	Build with CPU_PROFILER defined, otherwise PROFILE_ZONE & PROFILE_THREAD compile to nothing.
+	Zone names must outlive the profiler (string literals). Dump while threads are idle,
+	zones written during the dump may be torn. Buffers of finished threads are kept for the dump.
+*/
+
+struct CpuZone {
+	const char* name = nullptr;
+	uint64_t start_ns = 0;
+	uint64_t end_ns = 0;
+};
+
+class CpuProfiler
+{
+public:
+	static uint64_t now(); // ns since first call
+	static void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+	static void setThreadName(const std::string& name); // calling thread, shown in trace
+
+	static bool writeChromeTrace(const std::string& path);
+	static size_t getZoneCount(); // kept in buffers of all threads
+
+public:
+	static const size_t CHUNK_ZONES = 256; // buffers grow by chunks...
+	static const size_t MAX_CHUNKS = 256; // ...up to this, then oldest zones are overwritten
+};
+
+class CpuZoneScope
+{
+public:
+	CpuZoneScope(const char* name) : name(name), start_ns(CpuProfiler::now()) {}
+	~CpuZoneScope() { CpuProfiler::record(name, start_ns, CpuProfiler::now()); }
+
+private:
+	const char* name;
+	uint64_t start_ns;
+};
+
+#ifdef CPU_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) CpuZoneScope PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) CpuProfiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,145 @@
+#include "DrawDataBuffer.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cstring>
+
+DrawDataBuffer::DrawDataBuffer()
+{
+}
+
+void DrawDataBuffer::init(size_t draws)
+{
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	chunk_stride = (size_t)max_texels / TEXELS_PER_DRAW;
+
+	// BufferRing::reserve grows by half more than asked, the whole ring has to stay addressable
+	chunk_draws = std::max<size_t>(chunk_stride * 2 / 3 / BufferRing::FRAMES, 1);
+
+	addChunk(std::min(draws, chunk_draws));
+}
+
+void DrawDataBuffer::cleanup()
+{
+	for (Chunk& chunk : chunks) {
+		if (chunk.texture != 0) glDeleteTextures(1, &chunk.texture);
+		chunk.ring.cleanup();
+	}
+	chunks.clear();
+	bound_chunk = -1;
+}
+
+void DrawDataBuffer::addChunk(size_t draws)
+{
+	chunks.emplace_back();
+	Chunk& chunk = chunks.back();
+	chunk.ring.init(GL_TEXTURE_BUFFER, draws * sizeof(DrawRecord), sizeof(DrawRecord));
+	glGenTextures(1, &chunk.texture);
+}
+
+// Frame
+void DrawDataBuffer::beginFrame(size_t draws)
+{
+	size_t needed = std::max<size_t>((draws + chunk_draws - 1) / chunk_draws, 1);
+	while (chunks.size() < needed) addChunk(chunk_draws);
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		Chunk& chunk = chunks[i];
+		if (i < needed) chunk.ring.reserve(std::min(draws - i * chunk_draws, chunk_draws) * sizeof(DrawRecord));
+
+		// whole ring is one texture buffer, draw index includes region offset
+		if (chunk.texture_buffer != chunk.ring.getBuffer()) {
+			chunk.texture_buffer = chunk.ring.getBuffer();
+			glBindTexture(GL_TEXTURE_BUFFER, chunk.texture);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, chunk.texture_buffer);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+
+		chunk.draws = 0;
+		chunk.ring.beginFrame();
+	}
+
+	this->draws = 0;
+	current = 0;
+}
+
+int DrawDataBuffer::add(const glm::mat4& world, const glm::mat3& normal_matrix, const glm::vec4& color_factor, int material)
+{
+	DrawRecord* record = nullptr;
+	size_t offset = 0;
+	for (; current < chunks.size(); ++current) {
+		Chunk& chunk = chunks[current];
+		if (chunk.draws < chunk_draws) record = (DrawRecord*)chunk.ring.allocate(sizeof(DrawRecord), offset);
+		if (record != nullptr) break;
+	}
+	if (record == nullptr) return -1;
+
+	float material_bits;
+	memcpy(&material_bits, &material, sizeof(float));
+
+	record->world = world;
+	record->normal[0] = glm::vec4(normal_matrix[0], material_bits);
+	record->normal[1] = glm::vec4(normal_matrix[1], 0.0f);
+	record->normal[2] = glm::vec4(normal_matrix[2], 0.0f);
+	record->color_factor = color_factor;
+
+	chunks[current].draws++;
+	draws++;
+	return (int)(current * chunk_stride + offset / sizeof(DrawRecord));
+}
+
+void DrawDataBuffer::finishWrites()
+{
+	for (Chunk& chunk : chunks) chunk.ring.finishWrites();
+}
+
+void DrawDataBuffer::endFrame()
+{
+	for (Chunk& chunk : chunks) chunk.ring.endFrame();
+}
+
+void DrawDataBuffer::bind(GLenum unit)
+{
+	bound_unit = unit;
+	bound_chunk = -1;
+	select(0);
+}
+
+int DrawDataBuffer::select(int draw_index)
+{
+	int chunk = draw_index / (int)chunk_stride;
+	if (chunk != bound_chunk) {
+		glActiveTexture(bound_unit);
+		glBindTexture(GL_TEXTURE_BUFFER, chunks[chunk].texture);
+		glActiveTexture(GL_TEXTURE0);
+		RenderStats::current().texture_binds++;
+		bound_chunk = chunk;
+	}
+	return draw_index % (int)chunk_stride;
+}
+
+// Getters
+size_t DrawDataBuffer::getDrawCount() const
+{
+	return draws;
+}
+
+size_t DrawDataBuffer::getChunkCount() const
+{
+	return chunks.size();
+}
+
+size_t DrawDataBuffer::getBytesWritten() const
+{
+	size_t bytes = 0;
+	for (const Chunk& chunk : chunks) bytes += chunk.ring.getBytesWritten();
+	return bytes;
+}
+
+double DrawDataBuffer::getWaitTime() const
+{
+	double ms = 0.0;
+	for (const Chunk& chunk : chunks) ms += chunk.ring.getWaitTime();
+	return ms;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "BufferRing.h"
+
+#include <vector>
+
+
+/*
+	Per-draw data of a frame (world & normal matrix, color factor, material index).
+	Written once per frame into a BufferRing, shaders read it through a texture buffer
+	(GL 3.3 has no storage buffers) with draw_index uniform: 8 RGBA32F texels per draw.
+
+	Texture buffer is limited by GL_MAX_TEXTURE_BUFFER_SIZE (65536 texels at minimum,
+	about 1800 draws per frame with the ring), frames with more draws are split into chunks,
+	each its own ring & texture. Draw index encodes the chunk, select binds its texture
+	(only when it changes, draws of a model are usually in one chunk).
+*/
+
+struct DrawRecord {
+	glm::mat4 world;
+	glm::vec4 normal[3];	// normal matrix columns, normal[0].w - material index (int bits)
+	glm::vec4 color_factor;
+};
+
+class DrawDataBuffer
+{
+public:
+	DrawDataBuffer();
+
+	void init(size_t draws);
+	void cleanup();
+
+	// Frame: beginFrame -> add... -> finishWrites -> bind, select & draw... -> endFrame
+	void beginFrame(size_t draws); // grows the rings (adds chunks) if needed
+	int add(const glm::mat4& world, const glm::mat3& normal_matrix, const glm::vec4& color_factor, int material); // draw index, -1 if more than beginFrame reserved
+	void finishWrites();
+	void endFrame();
+
+	void bind(GLenum unit); // texture buffer of the first chunk
+	int select(int draw_index); // binds chunk of the draw if needed, index for the shader
+
+	size_t getDrawCount() const; // this frame
+	size_t getChunkCount() const;
+	size_t getBytesWritten() const; // all chunks
+	double getWaitTime() const;
+
+public:
+	static const int TEXELS_PER_DRAW = sizeof(DrawRecord) / sizeof(glm::vec4);
+
+private:
+	struct Chunk {
+		BufferRing ring;
+		GLuint texture = 0;
+		GLuint texture_buffer = 0; // buffer attached to texture (ring may recreate it)
+		size_t draws = 0; // this frame
+	};
+
+	void addChunk(size_t draws);
+
+private:
+	std::vector<Chunk> chunks;
+	size_t current = 0; // chunk being written
+
+	size_t draws = 0;
+	size_t chunk_stride = 0; // records the texture buffer can address (GL_MAX_TEXTURE_BUFFER_SIZE)
+	size_t chunk_draws = 0; // draws per frame of one chunk
+
+	GLenum bound_unit = GL_TEXTURE0;
+	int bound_chunk = -1;
+};
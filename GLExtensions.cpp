@@ -0,0 +1,101 @@
+#include "GLExtensions.h"
+
+#include <cstring>
+#include <iostream>
+
+PFNGLGETTEXTUREHANDLEARBPROC glext_glGetTextureHandleARB = nullptr;
+PFNGLGETTEXTURESAMPLERHANDLEARBPROC glext_glGetTextureSamplerHandleARB = nullptr;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glext_glMakeTextureHandleResidentARB = nullptr;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glext_glMakeTextureHandleNonResidentARB = nullptr;
+PFNGLISTEXTUREHANDLERESIDENTARBPROC glext_glIsTextureHandleResidentARB = nullptr;
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = nullptr;
+PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR = nullptr;
+PFNGLPUSHDEBUGGROUPPROC glext_glPushDebugGroup = nullptr;
+PFNGLPOPDEBUGGROUPPROC glext_glPopDebugGroup = nullptr;
+
+static GLExtensions extensions;
+
+bool hasGLExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension != nullptr && strcmp(extension, name) == 0) return true;
+	}
+	return false;
+}
+
+void loadGLExtensions(GLADloadproc load)
+{
+	glGetIntegerv(GL_MAJOR_VERSION, &extensions.major);
+	glGetIntegerv(GL_MINOR_VERSION, &extensions.minor);
+	int version = extensions.major * 10 + extensions.minor;
+
+	extensions.shader_storage_buffer = version >= 43 || hasGLExtension("GL_ARB_shader_storage_buffer_object");
+
+	// Bindless textures
+	if (hasGLExtension("GL_ARB_bindless_texture")) {
+		glext_glGetTextureHandleARB = (PFNGLGETTEXTUREHANDLEARBPROC)load("glGetTextureHandleARB");
+		glext_glGetTextureSamplerHandleARB = (PFNGLGETTEXTURESAMPLERHANDLEARBPROC)load("glGetTextureSamplerHandleARB");
+		glext_glMakeTextureHandleResidentARB = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)load("glMakeTextureHandleResidentARB");
+		glext_glMakeTextureHandleNonResidentARB = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)load("glMakeTextureHandleNonResidentARB");
+		glext_glIsTextureHandleResidentARB = (PFNGLISTEXTUREHANDLERESIDENTARBPROC)load("glIsTextureHandleResidentARB");
+
+		extensions.bindless_texture = glext_glGetTextureHandleARB && glext_glGetTextureSamplerHandleARB
+			&& glext_glMakeTextureHandleResidentARB && glext_glMakeTextureHandleNonResidentARB
+			&& glext_glIsTextureHandleResidentARB;
+		if (!extensions.bindless_texture) std::cout << "WARN: GL_ARB_bindless_texture functions are missing" << std::endl;
+	}
+
+	// Immutable buffer storage (persistently mapped buffers)
+	if (version >= 44 || hasGLExtension("GL_ARB_buffer_storage")) {
+		glext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+		extensions.buffer_storage = glext_glBufferStorage != nullptr;
+	}
+
+	// Program binaries (driver may support the functions with zero formats)
+	if (version >= 41 || hasGLExtension("GL_ARB_get_program_binary")) {
+		glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+		glext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+		glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		extensions.program_binary = glext_glGetProgramBinary && glext_glProgramBinary
+			&& glext_glProgramParameteri && formats > 0;
+	}
+
+	// Parallel shader compile, driver picks number of compiler threads
+	if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+		glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+	else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+		glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+	if (glext_glMaxShaderCompilerThreadsKHR != nullptr) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		extensions.parallel_shader_compile = true;
+	}
+
+	// Debug groups (pass names in frame captures)
+	if (version >= 43 || hasGLExtension("GL_KHR_debug")) {
+		glext_glPushDebugGroup = (PFNGLPUSHDEBUGGROUPPROC)load("glPushDebugGroup");
+		glext_glPopDebugGroup = (PFNGLPOPDEBUGGROUPPROC)load("glPopDebugGroup");
+		extensions.debug_groups = glext_glPushDebugGroup && glext_glPopDebugGroup;
+	}
+
+	std::cout << "GL " << extensions.major << "." << extensions.minor
+		<< ", bindless textures: " << (extensions.bindless_texture ? "yes" : "no")
+		<< ", storage buffers: " << (extensions.shader_storage_buffer ? "yes" : "no")
+		<< ", persistent mapping: " << (extensions.buffer_storage ? "yes" : "no")
+		<< ", program binaries: " << (extensions.program_binary ? "yes" : "no")
+		<< ", parallel shader compile: " << (extensions.parallel_shader_compile ? "yes" : "no")
+		<< ", debug groups: " << (extensions.debug_groups ? "yes" : "no") << std::endl;
+}
+
+const GLExtensions& getGLExtensions()
+{
+	return extensions;
+}
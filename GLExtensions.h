@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glad/glad.h>
+
+
+/*
+	Extensions (and functions newer than 3.3) which glad doesn't load,
+	glad is generated for GL 3.3 core only.
+
+	loadGLExtensions() is called once after gladLoadGLLoader, with the same loader.
+	Functions of missing extensions stay nullptr, check getGLExtensions() first.
+*/
+
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// GL_ARB_bindless_texture
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTURESAMPLERHANDLEARBPROC)(GLuint texture, GLuint sampler);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+typedef GLboolean (APIENTRYP PFNGLISTEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+
+extern PFNGLGETTEXTUREHANDLEARBPROC glext_glGetTextureHandleARB;
+extern PFNGLGETTEXTURESAMPLERHANDLEARBPROC glext_glGetTextureSamplerHandleARB;
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glext_glMakeTextureHandleResidentARB;
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glext_glMakeTextureHandleNonResidentARB;
+extern PFNGLISTEXTUREHANDLERESIDENTARBPROC glext_glIsTextureHandleResidentARB;
+
+#define glGetTextureHandleARB glext_glGetTextureHandleARB
+#define glGetTextureSamplerHandleARB glext_glGetTextureSamplerHandleARB
+#define glMakeTextureHandleResidentARB glext_glMakeTextureHandleResidentARB
+#define glMakeTextureHandleNonResidentARB glext_glMakeTextureHandleNonResidentARB
+#define glIsTextureHandleResidentARB glext_glIsTextureHandleResidentARB
+
+// GL_ARB_buffer_storage (core in 4.4)
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+
+#define glBufferStorage glext_glBufferStorage
+
+// GL_ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+extern PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glext_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+
+#define glGetProgramBinary glext_glGetProgramBinary
+#define glProgramBinary glext_glProgramBinary
+#define glProgramParameteri glext_glProgramParameteri
+
+// GL_KHR_parallel_shader_compile (or ARB one, same enum)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR;
+
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+
+// GL_KHR_debug (core in 4.3), only debug groups are used
+#ifndef GL_DEBUG_SOURCE_APPLICATION
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#endif
+
+typedef void (APIENTRYP PFNGLPUSHDEBUGGROUPPROC)(GLenum source, GLuint id, GLsizei length, const GLchar* message);
+typedef void (APIENTRYP PFNGLPOPDEBUGGROUPPROC)(void);
+
+extern PFNGLPUSHDEBUGGROUPPROC glext_glPushDebugGroup;
+extern PFNGLPOPDEBUGGROUPPROC glext_glPopDebugGroup;
+
+#define glPushDebugGroup glext_glPushDebugGroup
+#define glPopDebugGroup glext_glPopDebugGroup
+
+struct GLExtensions {
+	int major = 0;
+	int minor = 0;
+
+	bool bindless_texture = false;		// GL_ARB_bindless_texture
+	bool shader_storage_buffer = false;	// GL 4.3 or GL_ARB_shader_storage_buffer_object
+	bool buffer_storage = false;		// GL 4.4 or GL_ARB_buffer_storage (persistent mapping)
+	bool program_binary = false;		// GL 4.1 or GL_ARB_get_program_binary, with at least one binary format
+	bool parallel_shader_compile = false;	// GL_KHR/ARB_parallel_shader_compile (GL_COMPLETION_STATUS_KHR)
+	bool debug_groups = false;			// GL 4.3 or GL_KHR_debug (glPushDebugGroup, shown by RenderDoc & co.)
+};
+
+void loadGLExtensions(GLADloadproc load);
+const GLExtensions& getGLExtensions();
+bool hasGLExtension(const char* name);
@@ -1,8 +1,14 @@
 #include "GLTFModel.h"
+#include "GLExtensions.h"
+#include "CpuProfiler.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
 #include <iostream>
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
@@ -29,25 +35,228 @@ GLTFModel::GLTFModel(tinygltf::Model& m, glm::vec3 pos = glm::vec3(0.0), glm::ve
 
 GLTFModel::~GLTFModel()
 {
+	// stop loader thread before model data is released
+	abort_loading = true;
+	if (loader_thread.joinable()) loader_thread.join();
+
 	unbind();
 
 	if (model != nullptr) delete model;
+	if (residency != nullptr) residency->getAccounting().retire(this);
+}
+
+// .glb (binary container) or .gltf
+static bool isBinaryFile(const std::string& filename)
+{
+	return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".glb") == 0;
 }
 
 bool GLTFModel::load(const char* filename)
 {
+	PROFILE_ZONE("GLTFModel::load");
 	tinygltf::TinyGLTF loader;
 	std::string err;
 	std::string warn;
 
-	bool success = loader.LoadASCIIFromFile(model, &err, &warn, filename);
+	this->filename = filename;
+	state = LoadState::Parsing;
+	if (residency != nullptr) residency->getAccounting().setName(this, filename);
+
+	bool success = isBinaryFile(filename) ? loader.LoadBinaryFromFile(model, &err, &warn, filename)
+		: loader.LoadASCIIFromFile(model, &err, &warn, filename);
 	if (!warn.empty()) std::cout << "WARN: " << warn << std::endl;
 	if (!err.empty()) std::cout << "ERROR: " << err << std::endl;
 
 	if (success) std::cout << "Loaded glTF model: " << filename << std::endl;
 	else std::cout << "Failed to load glTF model: " << filename << std::endl;
 
-	return success;
+	state = success ? LoadState::Uploading : LoadState::Failed;
+	if (!success) return false;
+	accountModel();
+
+	publishBounds();
+	return true;
+}
+
+// Image loader which keeps encoded bytes, images are decoded later by loadWorker
+static bool storeImageAsIs(tinygltf::Image* image, const int, std::string*, std::string*,
+	int, int, const unsigned char* bytes, int size, void*)
+{
+	image->image.assign(bytes, bytes + size);
+	image->as_is = true;
+	return true;
+}
+
+void GLTFModel::loadAsync(const std::string& filename, UploadScheduler& scheduler)
+{
+	this->filename = filename;
+	upload_scheduler = &scheduler;
+	state = LoadState::Queued;
+	if (residency != nullptr) residency->getAccounting().setName(this, filename);
+
+	loader_thread = std::thread(&GLTFModel::loadWorker, this, filename);
+}
+
+void GLTFModel::loadWorker(std::string filename)
+{
+	PROFILE_THREAD("loader " + filename);
+	PROFILE_ZONE("GLTFModel::loadWorker");
+
+	// Parse json & buffers, images are kept encoded
+	state = LoadState::Parsing;
+
+	tinygltf::TinyGLTF loader;
+	loader.SetImageLoader(storeImageAsIs, nullptr);
+	std::string err;
+	std::string warn;
+
+	bool success = false;
+	{
+		PROFILE_ZONE("GLTFModel::parse");
+		success = isBinaryFile(filename) ? loader.LoadBinaryFromFile(model, &err, &warn, filename)
+			: loader.LoadASCIIFromFile(model, &err, &warn, filename);
+	}
+	if (!warn.empty()) std::cout << "WARN: " << warn << std::endl;
+	if (!err.empty()) std::cout << "ERROR: " << err << std::endl;
+
+	if (!success) {
+		std::cout << "Failed to load glTF model: " << filename << std::endl;
+		state = LoadState::Failed;
+		return;
+	}
+	std::cout << "Parsed glTF model: " << filename << std::endl;
+	accountModel();
+
+	// Placeholder bounds
+	publishBounds();
+
+	// Geometry can be uploaded from now on (see update)
+	int texture_cnt = 0;
+	for (auto& tex : model->textures)
+		if (tex.source > -1) texture_cnt++;
+	pending_textures = texture_arrays ? 1 : texture_cnt; // texture array is one upload
+	initTextures();
+
+	state = LoadState::Decoding;
+	geometry_parsed = true;
+
+	// Decode images, each texture is uploaded as soon as its image is ready
+	for (size_t ii = 0; ii < model->images.size(); ++ii) {
+		if (abort_loading) return;
+		PROFILE_ZONE("GLTFModel::decodeImage");
+
+		tinygltf::Image& image = model->images[ii];
+		if (image.as_is) {
+			std::vector<unsigned char> encoded;
+			encoded.swap(image.image);
+			image.as_is = false;
+
+			if (!tinygltf::LoadImageData(&image, (int)ii, &err, &warn, 0, 0, encoded.data(), (int)encoded.size(), nullptr)) {
+				std::cout << "ERROR: failed to decode image " << ii << " of " << filename << std::endl;
+			}
+		}
+
+		// texture array is built when all images are decoded
+		if (texture_arrays) continue;
+
+		// content hash for sharing identical images between models
+		if (texture_cache != nullptr) image_hashes[ii] = TextureCache::hashImage(image);
+
+		// mips for streaming are built here, not on GL thread
+		if (stream_textures) image_mips[ii].build(image);
+
+		for (size_t ti = 0; ti < model->textures.size(); ++ti) {
+			if (model->textures[ti].source != (int)ii) continue;
+
+			if (image.image.empty()) pending_textures--; // broken image, keep fallback texture
+			else scheduleTexture(ti);
+		}
+	}
+
+	// Import stage: pack images into texture array
+	if (texture_arrays) {
+		buildAtlas();
+		scheduleAtlas();
+	}
+
+	// decoded images replaced encoded ones
+	accountModel();
+	accountMips();
+	state = LoadState::Uploading;
+}
+
+// Bounds are built on loader thread and published once, GL thread sees them complete or not at all
+void GLTFModel::publishBounds()
+{
+	std::vector<MeshBounds> result;
+	const tinygltf::Scene& scene = model->scenes[model->defaultScene];
+	for (size_t i = 0; i < scene.nodes.size(); ++i) {
+		computeBounds(model->nodes[scene.nodes[i]], glm::mat4(1.0), result);
+	}
+
+	bounds.swap(result);
+	bounds_ready.store(true, std::memory_order_release);
+}
+
+void GLTFModel::computeBounds(const tinygltf::Node& node, glm::mat4 wrld, std::vector<MeshBounds>& result)
+{
+	glm::mat4 matNextNode = wrld * getNodeMatrix(node);
+
+	if ((node.mesh >= 0) && ((size_t)node.mesh < model->meshes.size())) {
+		MeshBounds mb{ node.mesh, matNextNode, glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+
+		// POSITION accessor must have min/max (gltf spec)
+		for (auto& primitive : model->meshes[node.mesh].primitives) {
+			auto attrib = primitive.attributes.find("POSITION");
+			if (attrib == primitive.attributes.end()) continue;
+
+			const tinygltf::Accessor& accessor = model->accessors[attrib->second];
+			if (accessor.minValues.size() < 3 || accessor.maxValues.size() < 3) continue;
+
+			mb.min = glm::min(mb.min, glm::vec3(glm::make_vec3(accessor.minValues.data())));
+			mb.max = glm::max(mb.max, glm::vec3(glm::make_vec3(accessor.maxValues.data())));
+		}
+
+		if (mb.min.x <= mb.max.x) result.push_back(mb);
+	}
+
+	for (size_t i = 0; i < node.children.size(); ++i) {
+		computeBounds(model->nodes[node.children[i]], matNextNode, result);
+	}
+}
+
+void GLTFModel::update()
+{
+	if (upload_scheduler == nullptr) return;
+
+	// geometry first, textures are scheduled by loader thread
+	if (geometry_parsed && !geometry_scheduled) {
+		scheduleGeometry();
+	}
+
+	if (state == LoadState::Uploading && geometry_bound && pending_textures == 0) {
+		state = LoadState::Ready;
+		registerResidency(); // can be evicted from now on
+		std::cout << "Model ready: " << filename << std::endl;
+	}
+}
+
+LoadState GLTFModel::getLoadState() const
+{
+	return state;
+}
+
+const char* GLTFModel::getLoadStateName(LoadState state)
+{
+	switch (state) {
+	case LoadState::Queued: return "queued";
+	case LoadState::Parsing: return "parsing";
+	case LoadState::Decoding: return "decoding";
+	case LoadState::Uploading: return "uploading";
+	case LoadState::Ready: return "ready";
+	case LoadState::Failed: return "failed";
+	}
+	return "unknown";
 }
 
 // Getters
@@ -76,6 +285,17 @@ glm::vec3 GLTFModel::getScale() const
 	return scale;
 }
 
+const std::string& GLTFModel::getFilename() const
+{
+	return filename;
+}
+
+const std::vector<MeshBounds>& GLTFModel::getBounds() const
+{
+	static const std::vector<MeshBounds> no_bounds;
+	return bounds_ready.load(std::memory_order_acquire) ? bounds : no_bounds;
+}
+
 // Setters
 void GLTFModel::setModel(tinygltf::Model& m)
 {
@@ -85,102 +305,891 @@ void GLTFModel::setModel(tinygltf::Model& m)
 void GLTFModel::setPosition(double x, double y, double z)
 {
 	position = glm::vec3(x, y, z);
+	transform_dirty = true;
 }
 
 void GLTFModel::setRotation(double xr, double yr, double zr)
 {
 	rotation = glm::vec3(xr, yr, zr);
+	transform_dirty = true;
 }
 
 void GLTFModel::setScale(double xs, double ys, double zs)
 {
 	scale = glm::vec3(xs, ys, zs);
+	transform_dirty = true;
 }
 
 // Generate data
 void GLTFModel::generateBuffers()
 {
+	PROFILE_ZONE("GLTFModel::generateBuffers");
 	if (buffer_generated) {
 		std::cout << "WARN: buffers already generated!" << std::endl;
 		return;
 	}
 
 	for (size_t i = 0; i < model->bufferViews.size(); ++i) {
-		const tinygltf::BufferView& bufferView = model->bufferViews[i];
+		generateBuffer(i, 0, model->bufferViews[i].byteLength);
+	}
 
-		if (bufferView.target == 0) { // unsupported yet
-			std::cout << "WARN: bufferView.target is unsupported (0)" << std::endl;
-			continue;
-		}
+	buffer_generated = true;
+}
 
-		const tinygltf::Buffer& buffer = model->buffers[bufferView.buffer];
+// Range of buffer view, the first one (offset 0) creates buffer with storage of the whole view
+void GLTFModel::generateBuffer(size_t view_index, size_t offset, size_t size)
+{
+	const tinygltf::BufferView& bufferView = model->bufferViews[view_index];
+
+	if (bufferView.target == 0) { // unsupported yet
+		if (offset == 0) std::cout << "WARN: bufferView.target is unsupported (0)" << std::endl;
+		return;
+	}
+
+	const tinygltf::Buffer& buffer = model->buffers[bufferView.buffer];
+	const unsigned char* data = &buffer.data.at(0) + bufferView.byteOffset;
+	bool whole = offset == 0 && size == bufferView.byteLength;
 
+	if (offset == 0) {
 		GLuint bo; // it could be vbo or ebo (check target)
 		glGenBuffers(1, &bo);
-		buffer_objects[i] = bo;
+		buffer_objects[view_index] = bo;
 
 		glBindBuffer(bufferView.target, bo);
-		glBufferData(bufferView.target, bufferView.byteLength, &buffer.data.at(0) + bufferView.byteOffset, GL_STATIC_DRAW);
+		glBufferData(bufferView.target, bufferView.byteLength, whole ? data : NULL, GL_STATIC_DRAW);
+
+		// Note: buffer is deleted after vaos are created, but storage lives until vaos are deleted (see unbind)
+		if (residency != nullptr) {
+			MemoryCategory category = bufferView.target == GL_ELEMENT_ARRAY_BUFFER ? MEMORY_GPU_INDEX : MEMORY_GPU_VERTEX;
+			residency->trackBuffer(this, bo, bufferView.byteLength, category);
+		}
+	}
+	else {
+		glBindBuffer(bufferView.target, buffer_objects[view_index]);
 	}
 
-	buffer_generated = true;
+	if (!whole) glBufferSubData(bufferView.target, offset, size, data + offset);
+	RenderStats::current().buffer_bytes += size;
 }
 
 void GLTFModel::generateTextures()
 {
+	PROFILE_ZONE("GLTFModel::generateTextures");
 	if (textures_generated) {
 		std::cout << "WARN: textures already generated!" << std::endl;
 		return;
 	}
 
-	for (size_t ti = 0; ti < model->textures.size(); ++ti) { 
-		tinygltf::Texture& tex = model->textures[ti];
-		tinygltf::Sampler& sampler = model->samplers[tex.sampler];
-
-		if (tex.source > -1) {
-			GLuint texid;
-			glGenTextures(1, &texid);
-			textures.push_back(texid);
-
-			tinygltf::Image& image = model->images[tex.source];
-
-			// glActiveTexture(GL_TEXTURE0); // by default, it activated
-			glBindTexture(GL_TEXTURE_2D, texid);
-			//glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-			GLfloat min_filter = !generate_mipmaps || sampler.minFilter == -1 ? GL_LINEAR : sampler.minFilter; // GL_LINEAR == 9729 (0x2601)
-			GLfloat mag_filter = !generate_mipmaps || sampler.magFilter == -1 ? GL_LINEAR : sampler.magFilter;
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
-
-			GLenum format;
-			switch (image.component) {
-			case 1: format = GL_RED; break;
-			case 2: format = GL_RG; break;
-			case 3: format = GL_RGB; break;
-			default: format = GL_RGBA; break;
-			}
+	initTextures();
+	if (texture_arrays) {
+		buildAtlas();
+		generateAtlas();
+	}
+	else {
+		hashImages();
+		for (size_t ti = 0; ti < model->textures.size(); ++ti) {
+			generateTexture(ti);
+		}
+	}
+
+	textures_generated = true;
+}
+
+// Texture arrays
+void GLTFModel::setTextureArrays(bool enabled, int max_layer_size)
+{
+	texture_arrays = enabled;
+	this->max_layer_size = max_layer_size;
+}
+
+void GLTFModel::buildAtlas()
+{
+	// only images sampled by the renderer (base color)
+	std::vector<int> image_indices;
+	for (auto& material : model->materials) {
+		int ti = material.pbrMetallicRoughness.baseColorTexture.index;
+		if (ti < 0 || model->textures[ti].source < 0) continue;
+
+		int ii = model->textures[ti].source;
+		if (std::find(image_indices.begin(), image_indices.end(), ii) == image_indices.end())
+			image_indices.push_back(ii);
+	}
+
+	atlas.build(model->images, image_mips, image_indices, max_layer_size);
+}
+
+void GLTFModel::generateAtlas()
+{
+	RenderStats::current().texture_bytes += atlas.getUploadBytes();
+	atlas.upload();
+	trackAtlas();
+}
+
+void GLTFModel::scheduleAtlas()
+{
+	// layers in bands of rows, one upload job each, texture array is used after the last one
+	int layer_size = atlas.getLayerSize();
+	size_t row_bytes = (size_t)layer_size * 4;
+	int rows = row_bytes > 0 ? (int)std::max<size_t>(upload_scheduler->getChunkBytes() / row_bytes, 1) : 1;
+	for (int layer = 0; layer < atlas.getLayerCount(); ++layer) {
+		for (int y = 0; y < layer_size; y += rows) {
+			int count = std::min(rows, layer_size - y);
+			upload_scheduler->submit("texture array rows", row_bytes * count, this, [this, layer, y, count, row_bytes]() {
+				atlas.uploadRows(layer, y, count);
+				RenderStats::current().texture_bytes += row_bytes * count;
+			});
+		}
+	}
+
+	upload_scheduler->submit("texture array", 0, this, [this]() {
+		atlas.finishUpload();
+		trackAtlas();
+		pending_textures--;
+	});
+}
+
+void GLTFModel::trackAtlas()
+{
+	if (residency != nullptr && atlas.getTexture() != 0)
+		residency->trackTexture(this, atlas.getTexture(), atlas.getBytes() - atlas.getMipBytes(), atlas.getMipBytes());
+	accountMips(); // layers are released after upload
+}
 
-			GLenum type = GL_UNSIGNED_BYTE;
-			if (image.bits == 8) {
-				type = GL_UNSIGNED_BYTE;
+void GLTFModel::initTextures()
+{
+	// indexed by texture index, 0 if texture has no source
+	textures.assign(model->textures.size(), 0);
+	texture_streams.assign(model->textures.size(), TextureStream());
+	image_mips.assign(model->images.size(), MipChain());
+
+	borrowed_textures.assign(model->textures.size(), false);
+	texture_samplers.assign(model->textures.size(), 0);
+	image_hashes.assign(model->images.size(), ImageHash());
+
+	texture_handles.assign(model->textures.size(), 0);
+	materials_dirty = true;
+
+	upload_serials.assign(model->textures.size(), 0);
+	textures_incomplete.assign(model->textures.size(), false);
+}
+
+// Shared textures
+void GLTFModel::setTextureCache(TextureCache* cache)
+{
+	texture_cache = cache;
+}
+
+void GLTFModel::hashImages()
+{
+	if (texture_cache == nullptr) return;
+
+	for (size_t ii = 0; ii < model->images.size(); ++ii) {
+		image_hashes[ii] = TextureCache::hashImage(model->images[ii]);
+	}
+}
+
+bool GLTFModel::acquireSharedTexture(size_t texture_index)
+{
+	const tinygltf::Texture& tex = model->textures[texture_index];
+	GLuint shared = texture_cache->acquire(image_hashes[tex.source], model->images[tex.source], this);
+	if (shared == 0) return false;
+
+	textures[texture_index] = shared;
+	borrowed_textures[texture_index] = true;
+
+	// owner is kept resident while this model draws its texture
+	const void* owner = texture_cache->getOwner(shared);
+	if (owner != this && std::find(shared_owners.begin(), shared_owners.end(), owner) == shared_owners.end())
+		shared_owners.push_back(owner);
+	return true;
+}
+
+MipChain& GLTFModel::getMipChain(int image_index)
+{
+	MipChain& chain = image_mips[image_index];
+	if (!chain.isBuilt()) {
+		chain.build(model->images[image_index]);
+		accountMips();
+	}
+	return chain;
+}
+
+bool GLTFModel::generateTexture(size_t texture_index, std::function<void()> uploaded)
+{
+	tinygltf::Texture& tex = model->textures[texture_index];
+	if (tex.source < 0) return true;
+
+	// texture without sampler uses default one (repeat, linear)
+	tinygltf::Sampler sampler;
+	if (tex.sampler > -1) sampler = model->samplers[tex.sampler];
+
+	// streamed textures always have mips (cpu mip chain), so sampler filters can be used
+	bool mipmapped = generate_mipmaps || stream_textures;
+
+	// Shared sampler object, and texture if the same image is already uploaded
+	if (texture_cache != nullptr) {
+		texture_samplers[texture_index] = texture_cache->getSampler(sampler, mipmapped);
+		if (acquireSharedTexture(texture_index)) {
+			if (bindless) makeResident(texture_index);
+			return true;
+		}
+	}
+
+	GLuint texid;
+	glGenTextures(1, &texid);
+	textures[texture_index] = texid;
+
+	// glActiveTexture(GL_TEXTURE0); // by default, it activated
+	glBindTexture(GL_TEXTURE_2D, texid);
+	//glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// without texture cache, sampler state lives in the texture
+	if (texture_cache == nullptr) {
+		GLfloat min_filter = GL_LINEAR; // GL_LINEAR == 9729 (0x2601)
+		if (stream_textures) min_filter = sampler.minFilter == -1 ? GL_LINEAR_MIPMAP_LINEAR : sampler.minFilter;
+		else if (generate_mipmaps && sampler.minFilter != -1) min_filter = sampler.minFilter;
+		GLfloat mag_filter = !mipmapped || sampler.magFilter == -1 ? GL_LINEAR : sampler.magFilter;
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
+	}
+
+	if (stream_textures) {
+		// Only the coarsest mips at first, finer ones are streamed in by updateStreaming
+		TextureStream& ts = texture_streams[texture_index];
+		ts.levels = getMipChain(tex.source).getLevelCount();
+		ts.tail = std::max(0, ts.levels - initial_mips);
+		ts.base = ts.levels; // nothing resident yet
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ts.levels - 1);
+
+		// evicted model gets only what's allowed
+		int finest = std::min(std::max(ts.tail, texture_level), ts.levels - 1);
+		for (int level = ts.levels - 1; level >= finest; --level) {
+			uploadMip(texture_index, level);
+		}
+	}
+	else if (uploaded) {
+		// rows in upload jobs of their own, texture is drawn with fallback until the last one
+		glBindTexture(GL_TEXTURE_2D, 0);
+		scheduleUpload(texture_index, texture_level, [this, texture_index, uploaded]() {
+			shareTexture(texture_index);
+			uploaded();
+		});
+		return false;
+	}
+	else {
+		// evicted model gets its textures at evicted level right away
+		uploadTexture(texture_index, texture_level);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	shareTexture(texture_index);
+	return true;
+}
+
+// Texture is complete: others can borrow it, bindless handle (texture can't be changed after it's created)
+void GLTFModel::shareTexture(size_t texture_index)
+{
+	const tinygltf::Image& image = model->images[model->textures[texture_index].source];
+	if (texture_cache != nullptr && !image.image.empty()) {
+		size_t bytes = (size_t)image.width * image.height * 4;
+		if (generate_mipmaps || stream_textures) bytes += bytes / 3;
+		texture_cache->insert(image_hashes[model->textures[texture_index].source], image, textures[texture_index], this, bytes);
+	}
+
+	if (bindless) makeResident(texture_index);
+}
+
+// Bindless textures
+void GLTFModel::setBindlessTextures(bool enabled)
+{
+	bindless = enabled;
+	if (bindless) stream_textures = false; // handle freezes texture, mips can't be streamed
+}
+
+void GLTFModel::makeResident(size_t texture_index)
+{
+	GLuint texid = textures[texture_index];
+	if (texid == 0) return;
+
+	// texture & sampler pair has one handle, shared textures are resident already
+	GLuint64 handle = texture_samplers[texture_index] != 0
+		? glGetTextureSamplerHandleARB(texid, texture_samplers[texture_index])
+		: glGetTextureHandleARB(texid);
+	if (!glIsTextureHandleResidentARB(handle)) glMakeTextureHandleResidentARB(handle);
+
+	texture_handles[texture_index] = handle;
+	materials_dirty = true;
+}
+
+void GLTFModel::updateMaterialBuffer()
+{
+	materials_dirty = false;
+	if (model->materials.empty()) return;
+
+	std::vector<MaterialData> materials(model->materials.size());
+	for (size_t mi = 0; mi < model->materials.size(); ++mi) {
+		const tinygltf::PbrMetallicRoughness& pbr = model->materials[mi].pbrMetallicRoughness;
+		MaterialData& data = materials[mi];
+
+		int ti = pbr.baseColorTexture.index;
+		data.tex_diffuse = ti > -1 ? texture_handles[ti] : 0;
+		data.has_texture = data.tex_diffuse != 0 ? 1 : 0;
+		data.color_factor = glm::vec4(pbr.baseColorFactor[0], pbr.baseColorFactor[1], pbr.baseColorFactor[2], pbr.baseColorFactor[3]);
+	}
+
+	size_t bytes = materials.size() * sizeof(MaterialData);
+	if (material_buffer == 0) {
+		glGenBuffers(1, &material_buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, materials.data(), GL_DYNAMIC_DRAW);
+		if (residency != nullptr) residency->trackBuffer(this, material_buffer, bytes, MEMORY_GPU_MATERIAL);
+	}
+	else {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, materials.data());
+	}
+	RenderStats::current().buffer_bytes += bytes;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void getPixelFormat(const tinygltf::Image& image, GLenum& format, GLenum& type)
+{
+	switch (image.component) {
+	case 1: format = GL_RED; break;
+	case 2: format = GL_RG; break;
+	case 3: format = GL_RGB; break;
+	default: format = GL_RGBA; break;
+	}
+
+	type = GL_UNSIGNED_BYTE;
+	if (image.bits == 8) {
+		type = GL_UNSIGNED_BYTE;
+	}
+	else if (image.bits == 16) {
+		type = GL_UNSIGNED_SHORT;
+	}
+}
+
+void GLTFModel::uploadTexture(size_t texture_index, int level)
+{
+	GLuint texid = textures[texture_index];
+	if (texid == 0) return;
+
+	int image_index = model->textures[texture_index].source;
+	tinygltf::Image& image = model->images[image_index];
+	if (image.image.empty()) return;
+
+	upload_serials[texture_index]++; // rows in flight are stale
+	glBindTexture(GL_TEXTURE_2D, texid);
+
+	GLenum format, type;
+	getPixelFormat(image, format, type);
+
+	// Level > 0 - evicted texture, upload smaller copy of the image
+	int width, height;
+	const unsigned char* data = getImageLevel(image_index, level, width, height);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // small levels may have odd row size
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0,
+		format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	RenderStats::current().texture_bytes += (size_t)width * height * 4;
+
+	finishUpload(texture_index, level);
+}
+
+// Level 0 of non-streamed texture holds image level (texture bound): mips & accounting
+void GLTFModel::finishUpload(size_t texture_index, int level)
+{
+	int width, height;
+	getImageLevel(model->textures[texture_index].source, level, width, height);
+
+	// Mipmap
+	if (generate_mipmaps)
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+	// internal format is RGBA8, mip chain adds 1/3
+	if (residency != nullptr) {
+		size_t bytes = (size_t)width * height * 4;
+		residency->trackTexture(this, textures[texture_index], bytes, generate_mipmaps ? bytes / 3 : 0);
+	}
+	textures_incomplete[texture_index] = false;
+}
+
+const unsigned char* GLTFModel::getImageLevel(int image_index, int level, int& width, int& height)
+{
+	const tinygltf::Image& image = model->images[image_index];
+	if (level > 0) return getMipChain(image_index).getLevel(image, level, width, height);
+
+	// level 0 is the image, mip chain isn't built for it
+	width = image.width;
+	height = image.height;
+	return image.image.data();
+}
+
+// Level 0 of non-streamed texture in rows, then mips in a job of their own; done() runs when it's complete
+void GLTFModel::scheduleUpload(size_t texture_index, int image_level, std::function<void()> done)
+{
+	scheduleRows(texture_index, 0, image_level, [this, texture_index, image_level, done]() {
+		int width, height;
+		getImageLevel(model->textures[texture_index].source, image_level, width, height);
+		size_t bytes = generate_mipmaps ? (size_t)width * height * 4 / 3 : 0;
+
+		unsigned int serial = upload_serials[texture_index];
+		upload_scheduler->submit("texture mips", bytes, this, [this, texture_index, image_level, done, serial]() {
+			if (upload_serials[texture_index] != serial) return;
+
+			glBindTexture(GL_TEXTURE_2D, textures[texture_index]);
+			finishUpload(texture_index, image_level);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			done();
+		});
+	});
+}
+
+// Image level (0 - image, else cpu mip) into texture level in bands of rows, one upload job each.
+// The first band specifies the level, done() runs after the last one (texture bound).
+// Bands left are dropped when the texture is uploaded again meanwhile (serial changes)
+void GLTFModel::scheduleRows(size_t texture_index, int level, int image_level, std::function<void()> done)
+{
+	int width, height;
+	getImageLevel(model->textures[texture_index].source, image_level, width, height);
+
+	unsigned int serial = ++upload_serials[texture_index];
+	size_t row_bytes = (size_t)width * 4;
+	int rows = (int)std::max<size_t>(upload_scheduler->getChunkBytes() / std::max<size_t>(row_bytes, 1), 1);
+	for (int y = 0; y < height; y += rows) {
+		int count = std::min(rows, height - y);
+		bool last = y + count >= height;
+		upload_scheduler->submit("texture rows", row_bytes * count, this, [=]() {
+			if (upload_serials[texture_index] != serial) return;
+
+			uploadRows(texture_index, level, image_level, y, count);
+			if (last) done();
+			glBindTexture(GL_TEXTURE_2D, 0);
+		});
+	}
+}
+
+void GLTFModel::uploadRows(size_t texture_index, int level, int image_level, int y, int rows)
+{
+	int image_index = model->textures[texture_index].source;
+	const tinygltf::Image& image = model->images[image_index];
+
+	GLenum format, type;
+	getPixelFormat(image, format, type);
+
+	int width, height;
+	const unsigned char* data = getImageLevel(image_index, image_level, width, height);
+	size_t row_size = (size_t)width * image.component * (image.bits == 16 ? 2 : 1);
+
+	glBindTexture(GL_TEXTURE_2D, textures[texture_index]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (y == 0) {
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, format, type, NULL);
+
+		// level of non-streamed texture is sampled, it's drawn with fallback until the last rows
+		if (!stream_textures) textures_incomplete[texture_index] = true;
+	}
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, width, rows, format, type, data + y * row_size);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	RenderStats::current().texture_bytes += (size_t)width * rows * 4;
+}
+
+// Texture streaming (texture must be bound)
+void GLTFModel::uploadMip(size_t texture_index, int level)
+{
+	int image_index = model->textures[texture_index].source;
+	tinygltf::Image& image = model->images[image_index];
+	if (image.image.empty()) return;
+
+	GLenum format, type;
+	getPixelFormat(image, format, type);
+
+	int width, height;
+	const unsigned char* data = getMipChain(image_index).getLevel(image, level, width, height);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, format, type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	RenderStats::current().texture_bytes += (size_t)width * height * 4;
+
+	setBaseLevel(texture_index, level);
+}
+
+void GLTFModel::setBaseLevel(size_t texture_index, int level)
+{
+	TextureStream& ts = texture_streams[texture_index];
+	ts.base = level;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+	trackStreamedTexture(texture_index);
+}
+
+void GLTFModel::dropMip(size_t texture_index)
+{
+	TextureStream& ts = texture_streams[texture_index];
+	if (ts.base >= ts.levels - 1) return; // keep at least the last mip
+
+	GLenum format, type;
+	getPixelFormat(model->images[model->textures[texture_index].source], format, type);
+
+	// finer level in flight is dropped too (zero sized level releases its storage)
+	if (ts.refining) {
+		ts.refining = false;
+		upload_serials[texture_index]++;
+		glTexImage2D(GL_TEXTURE_2D, ts.base - 1, GL_RGBA, 0, 0, 0, format, type, NULL);
+	}
+
+	int level = ts.base++;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, ts.base);
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, format, type, NULL);
+
+	trackStreamedTexture(texture_index);
+}
+
+void GLTFModel::scheduleMip(size_t texture_index, int level)
+{
+	if (upload_scheduler == nullptr) {
+		glBindTexture(GL_TEXTURE_2D, textures[texture_index]);
+		uploadMip(texture_index, level);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return;
+	}
+
+	// in rows, level is below base level (not sampled) until the last ones, dropMip cancels them
+	texture_streams[texture_index].refining = true;
+	scheduleRows(texture_index, level, level, [this, texture_index, level]() {
+		texture_streams[texture_index].refining = false;
+		setBaseLevel(texture_index, level);
+	});
+}
+
+void GLTFModel::trackStreamedTexture(size_t texture_index)
+{
+	if (residency == nullptr) return;
+
+	// resident levels: base..levels-1
+	const TextureStream& ts = texture_streams[texture_index];
+	int image_index = model->textures[texture_index].source;
+	const tinygltf::Image& image = model->images[image_index];
+	const MipChain& chain = getMipChain(image_index);
+
+	size_t bytes = 0, mip_bytes = 0;
+	for (int level = ts.base; level < ts.levels; ++level) {
+		int width, height;
+		chain.getLevel(image, level, width, height);
+		(level == ts.base ? bytes : mip_bytes) += (size_t)width * height * 4;
+	}
+	residency->trackTexture(this, textures[texture_index], bytes, mip_bytes);
+}
+
+// Is bounding sphere inside of view frustum (planes from view-projection matrix)
+static bool isSphereVisible(const glm::mat4& view_proj, const glm::vec3& center, float radius)
+{
+	for (int i = 0; i < 6; ++i) {
+		int row = i / 2;
+		float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+		// glm is column major: m[column][row]
+		glm::vec4 plane;
+		for (int col = 0; col < 4; ++col)
+			plane[col] = view_proj[col][3] + sign * view_proj[col][row];
+
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius * glm::length(glm::vec3(plane)))
+			return false;
+	}
+	return true;
+}
+
+// Range of uv used by primitive (TEXCOORD_0 min/max, 1 if unknown)
+float GLTFModel::getUVExtent(const tinygltf::Primitive& primitive) const
+{
+	auto attrib = primitive.attributes.find("TEXCOORD_0");
+	if (attrib == primitive.attributes.end()) return 1.0f;
+
+	const tinygltf::Accessor& accessor = model->accessors[attrib->second];
+	if (accessor.minValues.size() < 2 || accessor.maxValues.size() < 2) return 1.0f;
+
+	double extent = std::max(accessor.maxValues[0] - accessor.minValues[0], accessor.maxValues[1] - accessor.minValues[1]);
+	return (float)std::max(extent, 1.0 / 4096.0);
+}
+
+void GLTFModel::updateStreaming(const glm::mat4& view, const glm::mat4& projection, float viewport_height)
+{
+	if (!stream_textures || texture_arrays || bindless || !geometry_bound) return;
+
+	glm::mat4 view_proj = projection * view;
+	glm::vec3 camera_pos = glm::vec3(glm::inverse(view)[3]);
+	float pixels_per_unit = projection[1][1] * viewport_height * 0.5f; // at distance 1
+
+	// Finest mip needed by visible meshes, per texture
+	std::vector<int> required(textures.size(), INT_MAX);
+	for (auto& mb : getBounds()) {
+		glm::mat4 mesh_world = getMeshWorld(mb.node_world);
+		glm::vec3 center = glm::vec3(mesh_world * glm::vec4((mb.min + mb.max) * 0.5f, 1.0f));
+		float max_scale = std::max(glm::length(glm::vec3(mesh_world[0])), std::max(glm::length(glm::vec3(mesh_world[1])), glm::length(glm::vec3(mesh_world[2]))));
+		float radius = glm::length(mb.max - mb.min) * 0.5f * max_scale;
+
+		if (!isSphereVisible(view_proj, center, radius)) continue;
+
+		float distance = std::max(glm::length(center - camera_pos) - radius, 0.01f);
+		float screen_size = 2.0f * radius * pixels_per_unit / distance; // projected diameter in pixels
+
+		for (auto& primitive : model->meshes[mb.mesh].primitives) {
+			if (primitive.material < 0) continue;
+
+			int ti = model->materials[primitive.material].pbrMetallicRoughness.baseColorTexture.index;
+			if (ti < 0 || textures[ti] == 0) continue;
+
+			// texels across the mesh vs pixels across the mesh
+			const tinygltf::Image& image = model->images[model->textures[ti].source];
+			float texels = std::max(image.width, image.height) * getUVExtent(primitive);
+			int level = (int)std::floor(std::log2(std::max(texels / std::max(screen_size, 1.0f), 1.0f)));
+			required[ti] = std::min(required[ti], level);
+		}
+	}
+
+	// Refine one level per frame (through scheduler), drop after a delay
+	for (size_t ti = 0; ti < textures.size(); ++ti) {
+		if (textures[ti] == 0) continue;
+
+		// shared texture is streamed by its owner, which gets the finest level requested by anyone
+		if (texture_cache != nullptr) {
+			if (borrowed_textures[ti]) {
+				if (required[ti] != INT_MAX) texture_cache->request(textures[ti], required[ti]);
+				continue;
 			}
-			else if (image.bits == 16) {
-				type = GL_UNSIGNED_SHORT;
+			required[ti] = std::min(required[ti], texture_cache->takeRequest(textures[ti]));
+		}
+
+		TextureStream& ts = texture_streams[ti];
+		if (ts.levels == 0) continue;
+
+		int finest = std::min(texture_level, ts.levels - 1); // evicted model is capped
+		int wanted = required[ti] == INT_MAX ? ts.tail : std::min(required[ti], ts.tail);
+		wanted = std::max(wanted, finest);
+
+		if (wanted < ts.base) {
+			ts.drop_delay = 0;
+			if (!ts.refining) scheduleMip(ti, ts.base - 1);
+		}
+		else if (wanted > ts.base) {
+			// after the delay one level is dropped per frame
+			if (++ts.drop_delay > drop_delay_frames) {
+				glBindTexture(GL_TEXTURE_2D, textures[ti]);
+				dropMip(ti);
+				glBindTexture(GL_TEXTURE_2D, 0);
 			}
+		}
+		else ts.drop_delay = 0;
+	}
+}
+
+void GLTFModel::setTextureStreaming(bool enabled, int initial_mips, int drop_delay_frames)
+{
+	stream_textures = enabled;
+	this->initial_mips = std::max(1, initial_mips);
+	this->drop_delay_frames = drop_delay_frames;
+}
+
+// Residency
+void GLTFModel::setResidencyManager(ResidencyManager* manager)
+{
+	residency = manager;
+}
+
+void GLTFModel::registerResidency()
+{
+	if (residency == nullptr) return;
+
+	// texture array & bindless textures can't be evicted per model (only accounted)
+	if (texture_arrays || bindless) {
+		residency->registerOwner(this, filename, nullptr, nullptr);
+		return;
+	}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0,
-				format, type, &image.image.at(0));
+	residency->registerOwner(this, filename,
+		[this](int level) { evictTextures(level); },
+		[this]() { restoreTextures(); });
+}
 
-			// Mipmap
-			if (generate_mipmaps)
-				glGenerateMipmap(GL_TEXTURE_2D);
+void GLTFModel::evictTextures(int level)
+{
+	texture_level = level;
+	for (size_t ti = 0; ti < textures.size(); ++ti) {
+		if (borrowed_textures[ti]) continue; // owner's memory
 
+		if (!stream_textures) {
+			uploadTexture(ti, level);
+			continue;
 		}
+
+		// streamed texture just drops finer mips
+		TextureStream& ts = texture_streams[ti];
+		if (textures[ti] == 0) continue;
+
+		glBindTexture(GL_TEXTURE_2D, textures[ti]);
+		while (ts.base < std::min(level, ts.levels - 1)) dropMip(ti);
 	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-	textures_generated = true;
+void GLTFModel::restoreTextures()
+{
+	texture_level = 0;
+
+	// streamed textures are refined by updateStreaming when camera needs them
+	if (stream_textures) {
+		residency->restored(this);
+		return;
+	}
+
+	// restore through scheduler, so it doesn't hitch the frame
+	if (upload_scheduler == nullptr) {
+		evictTextures(0);
+		residency->restored(this);
+		return;
+	}
+
+	restore_pending = 0;
+	for (size_t ti = 0; ti < textures.size(); ++ti) {
+		if (textures[ti] == 0 || borrowed_textures[ti]) continue;
+
+		// in rows, texture is drawn with fallback from the first to the last one
+		restore_pending++;
+		scheduleUpload(ti, 0, [this]() {
+			if (--restore_pending == 0) residency->restored(this);
+		});
+	}
+
+	if (restore_pending == 0) residency->restored(this);
+}
+
+// Memory accounting: capacity of arrays held by tinygltf model
+template <typename T>
+static void addArray(const std::vector<T>& array, size_t& bytes, size_t& blocks)
+{
+	if (array.capacity() == 0) return;
+	bytes += array.capacity() * sizeof(T);
+	blocks++;
+}
+
+static void addString(const std::string& text, size_t& bytes, size_t& blocks)
+{
+	if (text.capacity() <= 15) return; // short strings live in the object
+	bytes += text.capacity() + 1;
+	blocks++;
+}
+
+template <typename K, typename V>
+static void addMap(const std::map<K, V>& map, size_t& bytes, size_t& blocks)
+{
+	// tree node: value & color + 3 pointers
+	bytes += map.size() * (sizeof(std::pair<const K, V>) + 4 * sizeof(void*));
+	blocks += map.size();
+}
+
+// Structures parsed from json (buffer & image data excluded), extras & extensions aren't walked
+static void getMetadataBytes(const tinygltf::Model& m, size_t& bytes, size_t& blocks)
+{
+	addArray(m.accessors, bytes, blocks);
+	for (auto& accessor : m.accessors) {
+		addString(accessor.name, bytes, blocks);
+		addArray(accessor.minValues, bytes, blocks);
+		addArray(accessor.maxValues, bytes, blocks);
+	}
+	addArray(m.bufferViews, bytes, blocks);
+	for (auto& view : m.bufferViews) addString(view.name, bytes, blocks);
+	addArray(m.buffers, bytes, blocks);
+	for (auto& buffer : m.buffers) {
+		addString(buffer.name, bytes, blocks);
+		addString(buffer.uri, bytes, blocks);
+	}
+	addArray(m.images, bytes, blocks);
+	for (auto& image : m.images) {
+		addString(image.name, bytes, blocks);
+		addString(image.uri, bytes, blocks);
+		addString(image.mimeType, bytes, blocks);
+	}
+	addArray(m.materials, bytes, blocks);
+	for (auto& material : m.materials) {
+		addString(material.name, bytes, blocks);
+		addArray(material.emissiveFactor, bytes, blocks);
+		addArray(material.pbrMetallicRoughness.baseColorFactor, bytes, blocks);
+		addMap(material.values, bytes, blocks);
+		addMap(material.additionalValues, bytes, blocks);
+	}
+	addArray(m.meshes, bytes, blocks);
+	for (auto& mesh : m.meshes) {
+		addString(mesh.name, bytes, blocks);
+		addArray(mesh.weights, bytes, blocks);
+		addArray(mesh.primitives, bytes, blocks);
+		for (auto& primitive : mesh.primitives) {
+			addMap(primitive.attributes, bytes, blocks);
+			addArray(primitive.targets, bytes, blocks);
+			for (auto& target : primitive.targets) addMap(target, bytes, blocks);
+		}
+	}
+	addArray(m.nodes, bytes, blocks);
+	for (auto& node : m.nodes) {
+		addString(node.name, bytes, blocks);
+		addArray(node.children, bytes, blocks);
+		addArray(node.matrix, bytes, blocks);
+		addArray(node.translation, bytes, blocks);
+		addArray(node.rotation, bytes, blocks);
+		addArray(node.scale, bytes, blocks);
+		addArray(node.weights, bytes, blocks);
+	}
+	addArray(m.textures, bytes, blocks);
+	addArray(m.samplers, bytes, blocks);
+	addArray(m.scenes, bytes, blocks);
+	for (auto& scene : m.scenes) addArray(scene.nodes, bytes, blocks);
+	addArray(m.skins, bytes, blocks);
+	for (auto& skin : m.skins) addArray(skin.joints, bytes, blocks);
+	addArray(m.animations, bytes, blocks);
+	for (auto& animation : m.animations) {
+		addArray(animation.channels, bytes, blocks);
+		addArray(animation.samplers, bytes, blocks);
+	}
+	addArray(m.cameras, bytes, blocks);
+	addArray(m.lights, bytes, blocks);
+	addArray(m.extensionsUsed, bytes, blocks);
+	addArray(m.extensionsRequired, bytes, blocks);
+}
+
+void GLTFModel::accountModel()
+{
+	if (residency == nullptr) return;
+	MemoryAccounting& accounting = residency->getAccounting();
+
+	size_t bytes = 0, blocks = 0;
+	for (auto& buffer : model->buffers) addArray(buffer.data, bytes, blocks);
+	accounting.set(this, MEMORY_CPU_BUFFERS, bytes, blocks);
+
+	bytes = blocks = 0;
+	for (auto& image : model->images) addArray(image.image, bytes, blocks);
+	accounting.set(this, MEMORY_CPU_IMAGES, bytes, blocks);
+
+	bytes = blocks = 0;
+	getMetadataBytes(*model, bytes, blocks);
+	accounting.set(this, MEMORY_CPU_METADATA, bytes, blocks);
+}
+
+void GLTFModel::accountMips()
+{
+	if (residency == nullptr) return;
+
+	size_t bytes = atlas.getUploadBytes();
+	size_t blocks = bytes > 0 ? atlas.getLayerCount() : 0;
+	for (const MipChain& chain : image_mips) {
+		if (!chain.isBuilt()) continue;
+		bytes += chain.getBytes();
+		blocks += chain.getLevelCount() - 1;
+	}
+	residency->getAccounting().set(this, MEMORY_CPU_MIPS, bytes, blocks);
 }
 
 // Binding
@@ -193,6 +1202,82 @@ void GLTFModel::bind()
 	// generates buffers (vbo/ebo) if they have not been generated previously
 	generateBuffers();
 
+	bindNodes();
+	prepareShaders();
+	state = LoadState::Ready;
+	registerResidency();
+}
+
+void GLTFModel::bind(UploadScheduler& scheduler)
+{
+	if (textures_generated || buffer_generated) {
+		std::cout << "WARN: model already bound!" << std::endl;
+		return;
+	}
+
+	std::cout << "scheduling gltf model upload..." << std::endl;
+	upload_scheduler = &scheduler;
+	state = LoadState::Uploading;
+
+	// one job per texture and per buffer view, so big models are spread over frames
+	initTextures();
+	pending_textures = 0;
+	if (texture_arrays) {
+		buildAtlas();
+		pending_textures = 1;
+		scheduleAtlas();
+	}
+	else {
+		hashImages();
+		for (size_t ti = 0; ti < model->textures.size(); ++ti) {
+			if (model->textures[ti].source < 0) continue;
+
+			pending_textures++;
+			scheduleTexture(ti);
+		}
+	}
+
+	scheduleGeometry();
+}
+
+void GLTFModel::scheduleTexture(size_t texture_index)
+{
+	// creation & coarse mips (streaming), level 0 of other textures follows in rows (jobs of their own)
+	upload_scheduler->submit("texture", 0, this, [this, texture_index]() {
+		if (generateTexture(texture_index, [this]() { pending_textures--; })) pending_textures--;
+	});
+}
+
+void GLTFModel::scheduleGeometry()
+{
+	geometry_scheduled = true;
+
+	// big buffer views are uploaded in ranges, one job each
+	size_t chunk = upload_scheduler->getChunkBytes();
+	for (size_t i = 0; i < model->bufferViews.size(); ++i) {
+		size_t bytes = model->bufferViews[i].byteLength;
+		size_t offset = 0;
+		do {
+			size_t size = std::min(chunk, bytes - offset);
+			upload_scheduler->submit("buffer", size, this, [this, i, offset, size]() { generateBuffer(i, offset, size); });
+			offset += size;
+		} while (offset < bytes);
+	}
+
+	// jobs run in submit order, so vaos are created after all buffers exist
+	upload_scheduler->submit("vao", 0, this, [this]() {
+		buffer_generated = true;
+		bindNodes();
+		prepareShaders();
+	});
+}
+
+void GLTFModel::bindNodes()
+{
+	// vaos are created for the first node of each mesh
+	meshes_vaos.assign(model->meshes.size(), 0);
+	meshes_depth_vaos.assign(model->meshes.size(), 0);
+
 	// traverse scene nodes
 	const tinygltf::Scene& scene = model->scenes[model->defaultScene];
 	for (size_t i = 0; i < scene.nodes.size(); ++i) {
@@ -206,30 +1291,131 @@ void GLTFModel::bind()
 		glDeleteBuffers(1, &buffer_objects[it->first]);
 		buffer_objects.erase(it++);
 	}
+
+	transform_dirty = true;
+	geometry_bound = true;
+}
+
+// Shader variants
+void GLTFModel::setShaderCache(ShaderCache* cache, const std::string& program)
+{
+	shader_cache = cache;
+	shader_program = program;
+}
+
+void GLTFModel::prepareShaders()
+{
+	if (shader_cache == nullptr) return;
+
+	// submitted now (upload), not compiled on first draw
+	material_shaders.clear();
+	for (int i = 0; i <= (int)model->materials.size(); ++i) {
+		int material_index = i < (int)model->materials.size() ? i : -1;
+		material_shaders.push_back(shader_cache->precompile(shader_program, getMaterialFeatures(material_index)));
+	}
+}
+
+ShaderFeatures GLTFModel::getMaterialFeatures(int material_index) const
+{
+	// only features material really uses, so it gets the cheapest variant
+	ShaderFeatures features = 0;
+	if (material_index < 0 || material_index >= (int)model->materials.size()) return features;
+
+	const tinygltf::Material& material = model->materials[material_index];
+	if (material.pbrMetallicRoughness.baseColorTexture.index > -1) {
+		features |= SHADER_BASE_COLOR_TEXTURE;
+		if (texture_arrays) features |= SHADER_TEXTURE_ARRAY;
+	}
+	if (material.alphaMode == "MASK" || material.alphaMode == "BLEND") features |= SHADER_ALPHA_TEST;
+
+	return features;
+}
+
+Shader* GLTFModel::useMaterialShader(int material_index)
+{
+	if (material_index < 0 || material_index >= (int)material_shaders.size()) material_index = (int)material_shaders.size() - 1;
+
+	// variant is still compiling (or failed) - fallback until it's done
+	Shader* shader = material_shaders[material_index];
+	if (!shader->isValid()) shader = shader_cache->getFallback(shader_program);
+
+	if (shader != shader_current) {
+		shader->use();
+		shader_current = shader;
+	}
+	return shader;
+}
+
+bool GLTFModel::isReady() const
+{
+	return state == LoadState::Ready;
+}
+
+bool GLTFModel::isGeometryReady() const
+{
+	return geometry_bound;
 }
 
 void GLTFModel::unbind()
 {
+	// drop jobs which are still waiting for upload
+	if (upload_scheduler != nullptr) {
+		upload_scheduler->cancel(this);
+		upload_scheduler = nullptr;
+	}
+	geometry_bound = false;
+
 	for (auto& vao : meshes_vaos) {
 		glDeleteVertexArrays(1, &vao);
 	}
 	meshes_vaos.clear();
+	for (auto& vao : meshes_depth_vaos) {
+		glDeleteVertexArrays(1, &vao);
+	}
+	meshes_depth_vaos.clear();
+	meshes_world.clear();
+	meshes_model.clear();
+	meshes_normal.clear();
+	draw_indices.clear();
+	primitive_draws.clear();
+	draw_count = 0;
 
 	for (auto it = buffer_objects.cbegin(); it != buffer_objects.end(); ) {
 		tinygltf::BufferView bufferView = model->bufferViews[it->first];
 		glDeleteBuffers(1, &buffer_objects[it->first]);
 		buffer_objects.erase(it++);
 	}
+
+	for (auto& tex : textures) {
+		if (tex == 0) continue;
+
+		// shared texture is deleted by its last user
+		if (texture_cache != nullptr) texture_cache->release(tex, this);
+		else glDeleteTextures(1, &tex);
+	}
+	textures.clear();
+	shared_owners.clear();
+	atlas.release();
+	if (fallback_texture != 0) glDeleteTextures(1, &fallback_texture);
+	fallback_texture = 0;
+
+	// Note: handles are released with their textures (shared ones may still be used by others)
+	texture_handles.clear();
+	if (material_buffer != 0) glDeleteBuffers(1, &material_buffer);
+	material_buffer = 0;
+
+	// releases all accounted buffers & textures
+	if (residency != nullptr) residency->unregisterOwner(this);
 }
 
-void GLTFModel::traverseNode(tinygltf::Node& node, glm::mat4 wrld)
+glm::mat4 GLTFModel::getNodeMatrix(const tinygltf::Node& node)
 {
 	glm::vec3 trsl = glm::vec3(0.0);
 	if (node.translation.size() > 0) trsl = glm::make_vec3(node.translation.data());
 
 	glm::quat rot = glm::quat(1., 0., 0., 0.);
 	if (node.rotation.size() > 0) {
-		double* rv = node.rotation.data();
+		const double* rv = node.rotation.data();
 		rot = glm::quat(rv[3], rv[0], rv[1], rv[2]); // should be make_quat
 	}
 
@@ -249,14 +1435,22 @@ void GLTFModel::traverseNode(tinygltf::Node& node, glm::mat4 wrld)
 	matScl = glm::scale(matScl, scl);
 
 	// multiply all mat together
-	glm::mat4 matNextNode = wrld * matWrld * matTrsl * matRot * matScl;
+	return matWrld * matTrsl * matRot * matScl;
+}
+
+void GLTFModel::traverseNode(tinygltf::Node& node, glm::mat4 wrld)
+{
+	PROFILE_ZONE("GLTFModel::traverseNode");
+	glm::mat4 matNextNode = wrld * getNodeMatrix(node);
 
 	// If node has mesh, bind it
 	if ((node.mesh >= 0) && (node.mesh < model->meshes.size())) { // there, mesh is index
 		// save matrices for mesh
 		meshes_world.push_back(matNextNode);
+		draw_count += model->meshes[node.mesh].primitives.size();
+		addPrimitiveDraws(node.mesh, (int)meshes_world.size() - 1);
 
-		bindMesh(model->meshes[node.mesh]);
+		if (meshes_vaos[node.mesh] == 0) bindMesh(node.mesh);
 	}
 
 	// if has children, traverse nodes
@@ -266,8 +1460,43 @@ void GLTFModel::traverseNode(tinygltf::Node& node, glm::mat4 wrld)
 	}
 }
 
-void GLTFModel::bindMesh(tinygltf::Mesh& mesh)
+void GLTFModel::addPrimitiveDraws(int mesh_index, int node_index)
+{
+	const tinygltf::Mesh& mesh = model->meshes[mesh_index];
+	for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+		const tinygltf::Primitive& primitive = mesh.primitives[i];
+
+		PrimitiveDraw draw;
+		draw.mesh = mesh_index;
+		draw.node = node_index;
+		draw.primitive = (int)i;
+		if (primitive.material > -1 && primitive.material < (int)model->materials.size()) {
+			const tinygltf::Material& material = model->materials[primitive.material];
+			if (material.alphaMode == "MASK") draw.pass = AlphaPass::Mask;
+			else if (material.alphaMode == "BLEND") draw.pass = AlphaPass::Blend;
+			draw.double_sided = material.doubleSided;
+		}
+
+		// POSITION min/max (gltf spec), for back to front sorting & frustum culling
+		auto attrib = primitive.attributes.find("POSITION");
+		if (attrib != primitive.attributes.end()) {
+			const tinygltf::Accessor& accessor = model->accessors[attrib->second];
+			if (accessor.minValues.size() >= 3 && accessor.maxValues.size() >= 3) {
+				glm::vec3 min = glm::make_vec3(accessor.minValues.data());
+				glm::vec3 max = glm::make_vec3(accessor.maxValues.data());
+				draw.center = (min + max) * 0.5f;
+				draw.radius = glm::length(max - min) * 0.5f;
+			}
+		}
+
+		primitive_draws.push_back(draw);
+	}
+}
+
+void GLTFModel::bindMesh(int mesh_index)
 {
+	PROFILE_ZONE("GLTFModel::bindMesh");
+	tinygltf::Mesh& mesh = model->meshes[mesh_index];
 	/*
 		BufferView:
 		buffer		- (uint) buffer index
@@ -279,8 +1508,7 @@ void GLTFModel::bindMesh(tinygltf::Mesh& mesh)
 	GLuint VAO; // gen & bind vao for mesh
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
-	meshes_vaos.push_back(VAO);
-	std::cout << " -> bind mesh: " << debug_vao_cnt++ << std::endl;
+	meshes_vaos[mesh_index] = VAO;
 
 	//generateBuffers();
 	for (size_t i = 0; i < model->bufferViews.size(); ++i) {
@@ -354,83 +1582,329 @@ void GLTFModel::bindMesh(tinygltf::Mesh& mesh)
 		}
 	}
 
+	// Position only vao (depth pre-pass), same buffers as above
+	GLuint depth_vao;
+	glGenVertexArrays(1, &depth_vao);
+	glBindVertexArray(depth_vao);
+	meshes_depth_vaos[mesh_index] = depth_vao;
+
+	for (auto& primitive : mesh.primitives) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_objects.at(model->accessors[primitive.indices].bufferView));
+
+		auto attrib = primitive.attributes.find("POSITION");
+		if (attrib == primitive.attributes.end()) continue;
+
+		const tinygltf::Accessor& accessor = model->accessors[attrib->second];
+		const tinygltf::BufferView& bufferView = model->bufferViews[accessor.bufferView];
+		int byteStride = accessor.ByteStride(bufferView);
+		if (byteStride == -1 || bufferView.target != GL_ARRAY_BUFFER) continue;
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffer_objects[accessor.bufferView]);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, accessor.type, accessor.componentType,
+			accessor.normalized ? GL_TRUE : GL_FALSE,
+			byteStride, BUFFER_OFFSET(accessor.byteOffset));
+	}
+
 	glBindVertexArray(0); // unbind vao
 }
 
-// Render
-void GLTFModel::draw(Shader& shader)
+// White 1x1 texture, used until real texture is uploaded
+GLuint GLTFModel::getFallbackTexture()
 {
-	const tinygltf::Scene& scene = model->scenes[model->defaultScene];
-	for (size_t i = 0; i < scene.nodes.size(); ++i) {
-		drawNode(shader, model->nodes[scene.nodes[i]]);
+	if (fallback_texture == 0) {
+		const unsigned char white[4] = { 255, 255, 255, 255 };
+		glGenTextures(1, &fallback_texture);
+		glBindTexture(GL_TEXTURE_2D, fallback_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		if (residency != nullptr) residency->trackTexture(this, fallback_texture, 4, 0);
+	}
+	return fallback_texture;
+}
+
+// Per-draw data
+size_t GLTFModel::getDrawCount() const
+{
+	return geometry_bound ? draw_count : 0;
+}
+
+void GLTFModel::writeDrawData(DrawDataBuffer& draw_data, const glm::mat4& view_proj)
+{
+	PROFILE_ZONE("GLTFModel::writeDrawData");
+	draw_indices.clear();
+	frame_draw_data = &draw_data;
+	if (!geometry_bound) return;
+
+	updateTransforms();
+	RenderStats& stats = RenderStats::current();
+
+	// one record per primitive, in primitive_draws order (-1 - culled)
+	for (auto& draw : primitive_draws) {
+		const tinygltf::Primitive& primitive = model->meshes[draw.mesh].primitives[draw.primitive];
+		const glm::mat4& mesh_model = meshes_model[draw.node];
+
+		if (draw.radius >= 0.0f) {
+			glm::vec3 center = glm::vec3(mesh_model * glm::vec4(draw.center, 1.0f));
+			float max_scale = std::max(glm::length(glm::vec3(mesh_model[0])), std::max(glm::length(glm::vec3(mesh_model[1])), glm::length(glm::vec3(mesh_model[2]))));
+			if (!isSphereVisible(view_proj, center, draw.radius * max_scale)) {
+				draw_indices.push_back(-1);
+				stats.primitives_culled++;
+				continue;
+			}
+		}
+		stats.primitives_visible++;
+
+		glm::vec4 color_factor(1.0f);
+		if (primitive.material > -1) {
+			const std::vector<double>& cf = model->materials[primitive.material].pbrMetallicRoughness.baseColorFactor;
+			color_factor = glm::vec4(cf[0], cf[1], cf[2], cf[3]);
+		}
+		draw_indices.push_back(draw_data.add(mesh_model, meshes_normal[draw.node], color_factor, primitive.material));
 	}
 }
 
-void GLTFModel::drawNode(Shader& shader,tinygltf::Node& node)
+void GLTFModel::collectBlendDraws(const glm::mat4& view, std::vector<BlendDraw>& draws)
 {
-	// if node has mesh - draw it
-	if ((node.mesh >= 0) && (node.mesh < model->meshes.size())) {
-		// set matrices for shader
-		//glm::scale(meshes_world[node.mesh], glm::vec3(0.1,0.1,0.1))
-		shader.setMat4("model", getMeshWorld(node.mesh));
+	if (!geometry_bound || draw_indices.size() != primitive_draws.size()) return;
+
+	for (size_t i = 0; i < primitive_draws.size(); ++i) {
+		const PrimitiveDraw& draw = primitive_draws[i];
+		if (draw.pass != AlphaPass::Blend || draw_indices[i] < 0) continue;
 
-		glBindVertexArray(meshes_vaos[node.mesh]);
+		// distance of primitive bounds center along view direction
+		glm::vec4 center = view * meshes_model[draw.node] * glm::vec4(draw.center, 1.0f);
+		draws.push_back(BlendDraw{ this, i, -center.z });
+	}
+}
 
-		drawMesh(shader, model->meshes[node.mesh]);
+// Render
+void GLTFModel::draw(AlphaPass pass)
+{
+	PROFILE_ZONE("GLTFModel::draw");
+	if (!beginDraw()) return;
 
-		glBindVertexArray(0);
+	for (size_t i = 0; i < primitive_draws.size(); ++i) {
+		if (primitive_draws[i].pass == pass) drawPrimitive(i);
 	}
 
-	// recursively draw node and children nodes
-	for (size_t i = 0; i < node.children.size(); i++) {
-		drawNode(shader, model->nodes[node.children[i]]);
+	endDraw();
+}
+
+void GLTFModel::drawPrimitives(const std::vector<size_t>& indices)
+{
+	PROFILE_ZONE("GLTFModel::drawPrimitives");
+	if (!beginDraw()) return;
+
+	for (size_t index : indices) {
+		if (index < primitive_draws.size()) drawPrimitive(index);
 	}
+
+	endDraw();
 }
 
-void GLTFModel::drawMesh(Shader& shader, tinygltf::Mesh& mesh)
+void GLTFModel::drawDepth(Shader& shader)
 {
-	for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-		tinygltf::Primitive primitive = mesh.primitives[i];
-		tinygltf::Accessor indexAccessor = model->accessors[primitive.indices];
+	PROFILE_ZONE("GLTFModel::drawDepth");
+	// opaque geometry only, no materials
+	if (!geometry_bound) return;
+
+	vao_current = 0;
+	culling = true;
+
+	for (size_t i = 0; i < primitive_draws.size(); ++i) {
+		const PrimitiveDraw& draw = primitive_draws[i];
+		int draw_index = i < draw_indices.size() ? draw_indices[i] : -1;
+		if (draw.pass != AlphaPass::Opaque || draw_index < 0) continue;
 
-		// Apply material
-		proccessMaterial(shader, primitive);
-		
-		// Draw
+		const tinygltf::Primitive& primitive = model->meshes[draw.mesh].primitives[draw.primitive];
+		const tinygltf::Accessor& indexAccessor = model->accessors[primitive.indices];
+
+		if (meshes_depth_vaos[draw.mesh] != vao_current) {
+			vao_current = meshes_depth_vaos[draw.mesh];
+			glBindVertexArray(vao_current);
+			RenderStats::current().vao_binds++;
+		}
+		setCulling(!draw.double_sided);
+
+		shader.setInt("draw_index", frame_draw_data->select(draw_index));
 		glDrawElements(primitive.mode, indexAccessor.count,
 			indexAccessor.componentType,
 			BUFFER_OFFSET(indexAccessor.byteOffset));
+		RenderStats::current().countDraw(primitive.mode, indexAccessor.count);
+	}
 
-		// Unbind
-		glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	setCulling(true);
+}
+
+bool GLTFModel::beginDraw()
+{
+	// not uploaded yet
+	if (!geometry_bound || shader_cache == nullptr) return false;
+	if (material_shaders.empty()) prepareShaders();
+
+	if (residency != nullptr) {
+		residency->touch(this);
+		for (auto owner : shared_owners) residency->touch(owner);
+	}
+
+	shader_current = nullptr;
+	vao_current = 0;
+	culling = true; // pass starts with back face culling
+
+	// Bindless: all materials of the model in one buffer, textures are never bound
+	if (bindless) {
+		if (materials_dirty) updateMaterialBuffer();
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, material_buffer);
+	}
+
+	// Texture array is bound once for the whole model
+	if (texture_arrays) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.getTexture());
+		RenderStats::current().texture_binds++;
+	}
+	return true;
+}
+
+void GLTFModel::endDraw()
+{
+	glBindVertexArray(0);
+	setCulling(true);
+
+	if (texture_arrays) glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	else if (texture_cache != nullptr && !bindless) glBindSampler(0, 0);
+}
+
+void GLTFModel::drawPrimitive(size_t index)
+{
+	// Per-draw data, -1 - culled
+	int draw_index = index < draw_indices.size() ? draw_indices[index] : -1;
+	if (draw_index < 0) return;
+
+	const PrimitiveDraw& draw = primitive_draws[index];
+	const tinygltf::Primitive& primitive = model->meshes[draw.mesh].primitives[draw.primitive];
+	const tinygltf::Accessor& indexAccessor = model->accessors[primitive.indices];
+
+	// matrices are in per-draw data (writeDrawData)
+	if (meshes_vaos[draw.mesh] != vao_current) {
+		vao_current = meshes_vaos[draw.mesh];
+		glBindVertexArray(vao_current);
+		RenderStats::current().vao_binds++;
 	}
+
+	// doubleSided materials are drawn without culling
+	setCulling(!draw.double_sided);
+
+	// Shader variant of material, program is switched only when it differs
+	Shader& shader = *useMaterialShader(primitive.material);
+	shader.setInt("draw_index", frame_draw_data->select(draw_index));
+
+	// Apply material
+	proccessMaterial(shader, primitive);
+
+	// Draw
+	glDrawElements(primitive.mode, indexAccessor.count,
+		indexAccessor.componentType,
+		BUFFER_OFFSET(indexAccessor.byteOffset));
+	RenderStats::current().countDraw(primitive.mode, indexAccessor.count);
+
+	// Unbind
+	if (!texture_arrays && !bindless) glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GLTFModel::setCulling(bool enabled)
+{
+	if (culling == enabled) return;
+
+	culling = enabled;
+	if (culling) glEnable(GL_CULL_FACE);
+	else glDisable(GL_CULL_FACE);
 }
 
-void GLTFModel::proccessMaterial(Shader& shader, tinygltf::Primitive& primitive)
+void GLTFModel::proccessMaterial(Shader& shader, const tinygltf::Primitive& primitive)
 {
-	tinygltf::Material material = model->materials[primitive.material];
+	if (primitive.material < 0 || primitive.material >= (int)model->materials.size()) return;
+	const tinygltf::Material& material = model->materials[primitive.material];
+
+	// MASK - gltf cutoff, BLEND - only fully transparent texels are dropped (they'd still write depth)
+	if (material.alphaMode == "MASK") shader.setFloat("alpha_cutoff", (float)material.alphaCutoff);
+	else if (material.alphaMode == "BLEND") shader.setFloat("alpha_cutoff", 0.05f);
+
+	// Bindless: texture & color factor are in material buffer, material index in draw data
+	if (bindless) return;
 
 	// Texture bind
 	int tex_base_index = material.pbrMetallicRoughness.baseColorTexture.index;
-	if (tex_base_index > -1) {
+	if (texture_arrays) {
+		// no bind, just region of texture array
+		AtlasRegion region;
+		if (tex_base_index > -1 && atlas.getTexture() != 0) region = atlas.getRegion(model->textures[tex_base_index].source);
+
+		shader.setFloat("tex_layer", (float)region.layer);
+		if (region.layer >= 0) {
+			int sampler_index = model->textures[tex_base_index].sampler;
+			bool clamp = sampler_index > -1 && model->samplers[sampler_index].wrapS == GL_CLAMP_TO_EDGE;
+			shader.setVec4("uv_transform", region.uv_transform);
+			shader.setInt("tex_wrap", clamp ? 1 : 0);
+		}
+	}
+	else if (tex_base_index > -1) {
 		GLuint tex_base = textures[tex_base_index];
+		if (tex_base == 0 || textures_incomplete[tex_base_index]) tex_base = getFallbackTexture(); // not uploaded yet
 
-		glActiveTexture(GL_TEXTURE0); // to change index just +1 (any number)
-		shader.setInt("tex_diffuse", 0); // 0 is sampler index
+		glActiveTexture(GL_TEXTURE0); // tex_diffuse sampler is 0 (set once per variant)
 		glBindTexture(GL_TEXTURE_2D, tex_base);
+		RenderStats::current().texture_binds++;
+
+		// fallback has no mips, it's sampled with its own parameters
+		if (texture_cache != nullptr)
+			glBindSampler(0, tex_base == textures[tex_base_index] ? texture_samplers[tex_base_index] : 0);
 	}
 
-	// Color Factor
-	std::vector<double>* cf = &material.pbrMetallicRoughness.baseColorFactor;
-	shader.setVec4("color_factor", (*cf)[0], (*cf)[1], (*cf)[2], (*cf)[3]);
-	
+	// Note: color factor is in per-draw data
+
 	// WIP: there could be other parameters, like roughness, metallic ect
-	// also, I ignore "alphaMode" (render_setup -> enable blend), and doubleSided (for optimization)
 }
 
-glm::mat4 GLTFModel::getMeshWorld(int mesh_index)
+// Transforms
+void GLTFModel::updateTransforms()
 {
-	glm::mat4 mesh_world = glm::translate(meshes_world[mesh_index], getPosition());
+	// only when model transform changed (or meshes were bound)
+	if (!transform_dirty) return;
+	transform_dirty = false;
+
+	meshes_model.resize(meshes_world.size());
+	meshes_normal.resize(meshes_world.size());
+	for (size_t i = 0; i < meshes_world.size(); ++i) {
+		meshes_model[i] = getMeshWorld(meshes_world[i]);
+		meshes_normal[i] = getNormalMatrix(meshes_model[i]);
+	}
+}
+
+glm::mat3 GLTFModel::getNormalMatrix(const glm::mat4& world)
+{
+	glm::mat3 m = glm::mat3(world);
+
+	// Rotation & uniform scale: inverse transpose is the matrix itself divided by scale^2
+	float sx = glm::dot(m[0], m[0]);
+	float sy = glm::dot(m[1], m[1]);
+	float sz = glm::dot(m[2], m[2]);
+	float eps = 1e-4f * sx;
+	bool uniform = std::abs(sx - sy) < eps && std::abs(sx - sz) < eps;
+	bool orthogonal = std::abs(glm::dot(m[0], m[1])) < eps && std::abs(glm::dot(m[0], m[2])) < eps
+		&& std::abs(glm::dot(m[1], m[2])) < eps;
+	if (uniform && orthogonal && sx > 0.0f) return m * (1.0f / sx);
+
+	// non-uniform scale or shear
+	return glm::transpose(glm::inverse(m));
+}
+
+glm::mat4 GLTFModel::getMeshWorld(const glm::mat4& node_world) const
+{
+	glm::mat4 mesh_world = glm::translate(node_world, getPosition());
 	mesh_world = glm::rotate(mesh_world, glm::radians(getRotation().x), glm::vec3(1, 0, 0));
 	mesh_world = glm::rotate(mesh_world, glm::radians(getRotation().y), glm::vec3(0, 1, 0));
 	mesh_world = glm::rotate(mesh_world, glm::radians(getRotation().z), glm::vec3(0, 0, 1));
@@ -438,5 +1912,4 @@ glm::mat4 GLTFModel::getMeshWorld(int mesh_index)
 
 	return mesh_world;
 
-}
-
+}
\ No newline at end of file
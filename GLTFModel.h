@@ -6,8 +6,59 @@
 
 #include <glm/glm.hpp>
 
-#include "Shader.h"
+#include <atomic>
+#include <thread>
 
+#include "ShaderCache.h"
+#include "DrawDataBuffer.h"
+#include "MipChain.h"
+#include "RenderStats.h"
+#include "ResidencyManager.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "UploadScheduler.h"
+
+
+// Loading progress (loadAsync)
+enum class LoadState {
+	Queued,		// waiting for loader thread
+	Parsing,	// gltf json & buffers
+	Decoding,	// images (geometry can already be uploaded)
+	Uploading,	// everything decoded, waiting for gpu uploads
+	Ready,
+	Failed
+};
+
+// Material of bindless path (std430 layout, see passthrough_bindless.frag)
+struct MaterialData {
+	GLuint64 tex_diffuse;	// bindless handle, 0 - no texture
+	GLint has_texture;
+	GLint pad;
+	glm::vec4 color_factor;
+};
+
+// Render pass of a primitive (material alphaMode)
+enum class AlphaPass {
+	Opaque,	// no blending, no discard (keeps early depth test)
+	Mask,	// alpha test
+	Blend	// blended, sorted back to front over all models
+};
+
+// Blended primitive of a model, sorted by distance (see GLTFModel::collectBlendDraws)
+class GLTFModel;
+struct BlendDraw {
+	GLTFModel* model;
+	size_t primitive;	// index for GLTFModel::drawPrimitives
+	float depth;		// view space distance
+};
+
+// Bounding box of a mesh node (used as placeholder while loading)
+struct MeshBounds {
+	int mesh;
+	glm::mat4 node_world;
+	glm::vec3 min;
+	glm::vec3 max;
+};
 
 class GLTFModel
 {
@@ -18,49 +69,221 @@ public:
 
 	bool load(const char* filename);
 
+	// Background loading: parse & decode on loader thread, upload through scheduler.
+	// update() must be called every frame on GL thread.
+	void loadAsync(const std::string& filename, UploadScheduler& scheduler);
+	void update();
+
+	LoadState getLoadState() const;
+	static const char* getLoadStateName(LoadState state);
+
 	// Getters
 	tinygltf::Model* getModel() const;
 	glm::mat4 getWorld() const;
 	glm::vec3 getPosition() const;
 	glm::vec3 getRotation() const;
 	glm::vec3 getScale() const;
+	const std::string& getFilename() const;
+	const std::vector<MeshBounds>& getBounds() const; // empty until parsed
+	glm::mat4 getMeshWorld(const glm::mat4& node_world) const; // applies model transform
 
 	// Setters
 	void setModel(tinygltf::Model& m);
 	void setPosition(double x, double y, double z);
 	void setRotation(double xr, double yr, double zr);
 	void setScale(double xs, double ys, double zs);
+	void setResidencyManager(ResidencyManager* manager); // must be set before loading
+	void setTextureStreaming(bool enabled, int initial_mips, int drop_delay_frames); // before loading
+	void setTextureArrays(bool enabled, int max_layer_size); // before loading, replaces streaming
+	void setTextureCache(TextureCache* cache); // before loading, shares textures & samplers between models
+	void setBindlessTextures(bool enabled); // before loading, needs GL_ARB_bindless_texture, replaces streaming
+	void setShaderCache(ShaderCache* cache, const std::string& program); // before loading, variants are compiled on upload
 	
 	// In-scene
 	void bind();
+	void bind(UploadScheduler& scheduler); // upload spread over frames
 	void unbind();
-	void draw(Shader& shader);
+	void draw(AlphaPass pass); // after writeDrawData
+	void drawPrimitives(const std::vector<size_t>& indices); // blend pass, in given order
+	void collectBlendDraws(const glm::mat4& view, std::vector<BlendDraw>& draws); // after writeDrawData
+	void drawDepth(Shader& shader); // depth pre-pass of opaque primitives, shader is in use
+
+	// Per-draw data (matrices, material), written once per frame before draw
+	// Primitives outside of view frustum get no data, so they aren't drawn this frame
+	void writeDrawData(DrawDataBuffer& draw_data, const glm::mat4& view_proj);
+	size_t getDrawCount() const; // primitives of the model (upper bound of draws per frame)
+
+	// Texture streaming: picks mip per texture from screen size of meshes, once per frame
+	void updateStreaming(const glm::mat4& view, const glm::mat4& projection, float viewport_height);
+
+	bool isReady() const; // all gpu data uploaded
+	bool isGeometryReady() const; // can be drawn, textures may be missing yet
 
 private:
+	void loadWorker(std::string filename);
+	void publishBounds();
+	void computeBounds(const tinygltf::Node& node, glm::mat4 wrld, std::vector<MeshBounds>& result);
+
+	void scheduleTexture(size_t texture_index);
+	void scheduleGeometry();
+
+	void registerResidency();
+	void evictTextures(int level);
+	void restoreTextures();
+	void accountModel(); // cpu memory of tinygltf model
+	void accountMips();
+
 	void generateBuffers();
+	void generateBuffer(size_t view_index, size_t offset, size_t size);
 	void generateTextures();
+	void initTextures();
+	bool generateTexture(size_t texture_index, std::function<void()> uploaded = nullptr); // false - rows are uploaded by jobs, then uploaded() runs
+	void shareTexture(size_t texture_index);
+	void uploadTexture(size_t texture_index, int level);
+	void finishUpload(size_t texture_index, int level);
+	const unsigned char* getImageLevel(int image_index, int level, int& width, int& height);
+	void scheduleUpload(size_t texture_index, int image_level, std::function<void()> done);
+	void scheduleRows(size_t texture_index, int level, int image_level, std::function<void()> done);
+	void uploadRows(size_t texture_index, int level, int image_level, int y, int rows);
 
+	void hashImages();
+	bool acquireSharedTexture(size_t texture_index);
+
+	void makeResident(size_t texture_index);
+	void updateMaterialBuffer();
+
+	MipChain& getMipChain(int image_index);
+	void uploadMip(size_t texture_index, int level);
+	void setBaseLevel(size_t texture_index, int level);
+	void dropMip(size_t texture_index);
+	void scheduleMip(size_t texture_index, int level);
+	void trackStreamedTexture(size_t texture_index);
+	float getUVExtent(const tinygltf::Primitive& primitive) const;
+
+	void buildAtlas();
+	void generateAtlas();
+	void scheduleAtlas();
+	void trackAtlas();
+	void bindNodes();
+	void prepareShaders();
+	ShaderFeatures getMaterialFeatures(int material_index) const;
+	Shader* useMaterialShader(int material_index);
+
+	static glm::mat4 getNodeMatrix(const tinygltf::Node& node);
 	void traverseNode(tinygltf::Node& node, glm::mat4 wrld);
-	void bindMesh(tinygltf::Mesh& mesh);
+	void bindMesh(int mesh_index);
+
+	void addPrimitiveDraws(int mesh_index, int node_index);
 
-	void drawNode(Shader& shader, tinygltf::Node& node);
-	void drawMesh(Shader& shader, tinygltf::Mesh& mesh);
+	bool beginDraw();
+	void endDraw();
+	void drawPrimitive(size_t index);
+	void setCulling(bool enabled);
 
-	void proccessMaterial(Shader& shader, tinygltf::Primitive& primitive);
-	glm::mat4 getMeshWorld(int mesh_index);
+	void proccessMaterial(Shader& shader, const tinygltf::Primitive& primitive);
+	GLuint getFallbackTexture();
+
+	void updateTransforms();
+	static glm::mat3 getNormalMatrix(const glm::mat4& world);
 
 private:
 	std::map<int, GLuint> buffer_objects; // vbo & ebo map
 
 	std::vector<GLuint> textures;
-	std::vector<GLuint> meshes_vaos;
-	std::vector<glm::mat4> meshes_world;
+	std::vector<unsigned int> upload_serials; // per texture, row uploads in flight are dropped when it changes
+	std::vector<bool> textures_incomplete; // level 0 is being uploaded in rows (drawn with fallback)
+	std::vector<GLuint> meshes_vaos; // by mesh, shared by nodes of the same mesh
+	std::vector<GLuint> meshes_depth_vaos; // position only
+	std::vector<glm::mat4> meshes_world; // by mesh node (traversal order)
+
+	// node & model transform, recomputed only when transform changes
+	std::vector<glm::mat4> meshes_model;
+	std::vector<glm::mat3> meshes_normal;
+	bool transform_dirty = true;
+
+	// every primitive of mesh nodes, in node order
+	struct PrimitiveDraw {
+		int mesh = 0;
+		int node = 0; // meshes_world index
+		int primitive = 0;
+		AlphaPass pass = AlphaPass::Opaque;
+		bool double_sided = false;
+		glm::vec3 center = glm::vec3(0.0f); // bounds center, mesh space
+		float radius = -1.0f; // bounding sphere, mesh space (< 0 - unknown, never culled)
+	};
+	std::vector<PrimitiveDraw> primitive_draws;
+
+	size_t draw_count = 0; // primitives of all mesh nodes
+	std::vector<int> draw_indices; // this frame, per primitive_draws entry
+	DrawDataBuffer* frame_draw_data = nullptr; // draw_indices point into it
+
+	// state while drawing
+	GLuint vao_current = 0;
+	bool culling = true;
+	GLuint fallback_texture = 0; // white 1x1 until real texture is uploaded (per model, contexts may not share objects)
 
 	bool generate_mipmaps = false; // sometimes it requires a lot of time
 	bool textures_generated = false; // to avoid multiple generations
 	bool buffer_generated = false;
+	bool geometry_bound = false; // vaos created
+
+	UploadScheduler* upload_scheduler = nullptr; // set when bound through scheduler
+
+	// async loading
+	std::string filename;
+	std::thread loader_thread;
+	std::atomic<LoadState> state{ LoadState::Queued };
+	std::atomic<bool> geometry_parsed{ false };
+	std::atomic<bool> abort_loading{ false };
+	std::atomic<int> pending_textures{ 0 };
+	bool geometry_scheduled = false;
+	std::vector<MeshBounds> bounds; // written once before bounds_ready
+	std::atomic<bool> bounds_ready{ false };
+
+	// residency
+	ResidencyManager* residency = nullptr;
+	int texture_level = 0; // evicted mips, textures are uploaded at this level
+	int restore_pending = 0;
+
+	// texture streaming
+	struct TextureStream {
+		int levels = 0;		// full mip chain
+		int tail = 0;		// first level of initially uploaded mips
+		int base = 0;		// finest resident level
+		int drop_delay = 0;	// frames finer level wasn't needed
+		bool refining = false;	// upload job in flight
+	};
+	std::vector<TextureStream> texture_streams;
+	std::vector<MipChain> image_mips;
+
+	bool stream_textures = true;
+	int initial_mips = 4; // coarsest mips uploaded at first
+	int drop_delay_frames = 120;
+
+	// texture array (all base color images, material = layer + uv transform)
+	bool texture_arrays = false;
+	int max_layer_size = 2048;
+	TextureAtlas atlas;
+
+	// shared textures & samplers
+	TextureCache* texture_cache = nullptr;
+	std::vector<ImageHash> image_hashes;
+	std::vector<bool> borrowed_textures; // texture is owned by other user (not streamed/evicted here)
+	std::vector<GLuint> texture_samplers; // sampler object per texture
+	std::vector<const void*> shared_owners; // owners of borrowed textures
+
+	// bindless textures (material index per draw, no texture binds)
+	bool bindless = false;
+	std::vector<GLuint64> texture_handles;
+	GLuint material_buffer = 0; // MaterialData per gltf material
+	bool materials_dirty = false; // handles changed, buffer is rewritten on next draw
+
+	// shader variant per material (last one - default material)
+	ShaderCache* shader_cache = nullptr;
+	std::string shader_program;
+	std::vector<Shader*> material_shaders;
+	Shader* shader_current = nullptr; // in use while drawing
 
-	size_t debug_vao_cnt = 0; // debug only, print vao index in console
 
 private:
 	tinygltf::Model* model;
@@ -1,19 +1,39 @@
 #include "GLTFScene.h"
+#include "GLExtensions.h"
+#include "CpuProfiler.h"
 
 #include "json.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
+// Depth pre-pass auto mode: overdraw to turn it on/off, frames between measurements while off
+static const float DEPTH_PREPASS_ON = 2.0f;
+static const float DEPTH_PREPASS_OFF = 1.5f;
+static const int DEPTH_PREPASS_PROBE = 120;
+
+// Folder of model file (gltf exports are mostly "scene.gltf"), file name without extension otherwise
+static std::string getModelLabel(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string file = slash == std::string::npos ? path : path.substr(slash + 1);
+	if (slash != std::string::npos && slash > 0) {
+		size_t prev = path.find_last_of("/\\", slash - 1);
+		std::string folder = path.substr(prev == std::string::npos ? 0 : prev + 1, slash - (prev == std::string::npos ? 0 : prev + 1));
+		if (folder != "." && folder != "..") return folder;
+	}
+	return file.substr(0, file.find_last_of('.'));
+}
+
 GLTFScene::GLTFScene()
 {
 	models = std::vector<GLTFModel*>();
 
 	shaders = std::map<std::string, Shader*>();
-	shader_current = nullptr;
 
 	camera.MovementSpeed = 20.;
 }
@@ -27,21 +47,131 @@ void GLTFScene::init()
 	std::vector<std::string> model_paths{};
 	for (auto& p : json["models"])
 		model_paths.push_back(p);
+	if (!custom_model_paths.empty()) model_paths = custom_model_paths;
+
+	// Texture streaming (optional)
+	bool stream_textures = true;
+	int initial_mips = 4;
+	int drop_delay = 120;
+	if (json.contains("texture_streaming")) {
+		auto& streaming = json["texture_streaming"];
+		if (streaming.contains("enabled")) stream_textures = streaming["enabled"].get<bool>();
+		if (streaming.contains("initial_mips")) initial_mips = streaming["initial_mips"].get<int>();
+		if (streaming.contains("drop_delay")) drop_delay = streaming["drop_delay"].get<int>();
+	}
+
+	// Texture arrays (optional), disables streaming
+	bool texture_arrays = false;
+	int max_layer_size = 2048;
+	if (json.contains("texture_arrays")) {
+		auto& arrays = json["texture_arrays"];
+		if (arrays.contains("enabled")) texture_arrays = arrays["enabled"].get<bool>();
+		if (arrays.contains("max_layer_size")) max_layer_size = arrays["max_layer_size"].get<int>();
+	}
+
+	// Bindless textures (optional), disables streaming
+	bool bindless_textures = false;
+	if (json.contains("bindless_textures")) bindless_textures = json["bindless_textures"].get<bool>();
+
+	// Program binary cache (optional), skips compilation of programs linked by previous runs
+	bool program_binary_cache = true;
+	if (json.contains("program_binary_cache")) program_binary_cache = json["program_binary_cache"].get<bool>();
+	if (program_binary_cache) {
+		program_binaries.init("./shader_cache");
+		shader_cache.setBinaryCache(&program_binaries);
+	}
+
+	// Load shaders, bindless one decides if bindless path is usable at all
+	shaders["bounds"] = new Shader("./shaders/bounds.vert", "./shaders/bounds.frag", {},
+		program_binary_cache ? &program_binaries : nullptr);
+	shaders["depth"] = new Shader("./shaders/depth.vert", "./shaders/depth.frag", {},
+		program_binary_cache ? &program_binaries : nullptr);
+
+	// Depth pre-pass (optional): "off", "on" or "auto"
+	if (json.contains("depth_prepass")) {
+		std::string mode = json["depth_prepass"].get<std::string>();
+		if (mode == "on") setDepthPrepass(DepthPrepass::On);
+		else if (mode == "auto") setDepthPrepass(DepthPrepass::Auto);
+		else setDepthPrepass(DepthPrepass::Off);
+	}
+
+	// Model shader variants (per material features), all share frame data, draw data & texture unit 0
+	shader_cache.setSetup([](Shader& shader) {
+		shader.setUniformBlock("FrameData", 0);
+		shader.setInt("draw_data", 1);
+		shader.setInt("tex_diffuse", 0);
+		shader.setInt("tex_array", 0);
+	});
+
+	texture_binding = texture_arrays ? TextureBinding::Arrays : TextureBinding::Classic;
+	if (bindless_textures) {
+		const GLExtensions& ext = getGLExtensions();
+		if (ext.bindless_texture && ext.shader_storage_buffer) {
+			shader_cache.addProgram("passthrough", "./shaders/passthrough.vert", "./shaders/passthrough_bindless.frag");
+			if (shader_cache.getFallback("passthrough")->isValid()) texture_binding = TextureBinding::Bindless;
+		}
+
+		if (texture_binding != TextureBinding::Bindless)
+			std::cout << "WARN: bindless textures are not available, using "
+				<< (texture_arrays ? "texture arrays" : "texture binds") << std::endl;
+	}
+	if (texture_binding != TextureBinding::Bindless)
+		shader_cache.addProgram("passthrough", "./shaders/passthrough.vert", "./shaders/passthrough.frag");
+
+	texture_cache.setResidencyManager(&residency);
 
 	// Note: we are using pointers so model will not disappear after
-	// we left the init method
+	// we left the init method.
+	// Models are loaded in background, failed ones stay in list (state "failed")
+	// so transforms still match model indices
 	for (std::string model_path : model_paths) {
 		GLTFModel* gtlf_model = new GLTFModel();
-		if (gtlf_model->load(model_path.c_str())) {
-			models.push_back(gtlf_model);
-		}
-		else {
-			delete gtlf_model;
-		}
+		gtlf_model->setResidencyManager(&residency);
+		gtlf_model->setTextureStreaming(stream_textures, initial_mips, drop_delay);
+		if (texture_binding == TextureBinding::Arrays) gtlf_model->setTextureArrays(true, max_layer_size);
+		else gtlf_model->setTextureCache(&texture_cache);
+		gtlf_model->setBindlessTextures(texture_binding == TextureBinding::Bindless);
+		gtlf_model->setShaderCache(&shader_cache, "passthrough");
+		gtlf_model->loadAsync(model_path, upload_scheduler);
+		models.push_back(gtlf_model);
+		model_labels.push_back(getModelLabel(model_path));
+	}
+
+	// Upload budget per frame (optional)
+	if (json.contains("upload_budget")) {
+		auto& budget = json["upload_budget"];
+		if (budget.contains("time_ms")) upload_scheduler.setTimeBudget(budget["time_ms"].get<double>());
+		if (budget.contains("bytes")) upload_scheduler.setByteBudget(budget["bytes"].get<size_t>());
 	}
 
-	// Load shaders
-	shaders["passthrough"] = new Shader("./shaders/passthrough.vert", "./shaders/passthrough.frag");
+	// Gpu profiler (optional), per frame dump: .csv or .json
+	if (json.contains("gpu_profiler")) {
+		auto& profiler = json["gpu_profiler"];
+		if (profiler.contains("enabled")) gpu_profiler.setEnabled(profiler["enabled"].get<bool>());
+		if (profiler.contains("dump") && !profiler["dump"].get<std::string>().empty())
+			gpu_profiler.openDump(profiler["dump"].get<std::string>());
+	}
+
+	// Render stats summary in console (optional), 0 - off
+	if (json.contains("render_stats")) {
+		auto& stats = json["render_stats"];
+		if (stats.contains("log_every")) render_stats_log.setInterval(stats["log_every"].get<int>());
+	}
+
+	// Gpu memory budget (optional), 0 - unlimited
+	if (json.contains("gpu_budget_mb")) {
+		residency.setBudget(json["gpu_budget_mb"].get<size_t>() * 1024 * 1024);
+	}
+
+	// Memory report on exit (optional), F8 prints it any time
+	if (json.contains("memory_report")) {
+		memory_report = json["memory_report"].get<bool>();
+	}
+}
+
+void GLTFScene::setModels(const std::vector<std::string>& paths)
+{
+	custom_model_paths = paths;
 }
 
 void GLTFScene::processInput(GLFWwindow* window, float delta)
@@ -57,6 +187,34 @@ void GLTFScene::processInput(GLFWwindow* window, float delta)
 	}
 	else input_pressed_f5 = false;
 
+	// Depth pre-pass mode
+	bool f6 = glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS;
+	if (f6 && !input_pressed_f6) {
+		const char* names[] = { "off", "on", "auto" };
+		int mode = ((int)depth_prepass + 1) % 3;
+		setDepthPrepass((DepthPrepass)mode);
+
+		const std::vector<PassResult>& results = pass_queries.getResults();
+		std::cout << "Depth pre-pass: " << names[mode] << " (overdraw " << overdraw << ", last frame gpu ms: depth "
+			<< results[PASS_DEPTH].ms << ", opaque " << results[PASS_OPAQUE].ms << ", mask " << results[PASS_MASK].ms
+			<< ", blend " << results[PASS_BLEND].ms << ")" << std::endl;
+	}
+	input_pressed_f6 = f6;
+
+	// Gpu profiler
+	bool f7 = glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS;
+	if (f7 && !input_pressed_f7) {
+		if (gpu_profiler.isEnabled()) gpu_profiler.report();
+		gpu_profiler.setEnabled(!gpu_profiler.isEnabled());
+		std::cout << "GPU profiler: " << (gpu_profiler.isEnabled() ? "on" : "off") << std::endl;
+	}
+	input_pressed_f7 = f7;
+
+	// Memory report
+	bool f8 = glfwGetKey(window, GLFW_KEY_F8) == GLFW_PRESS;
+	if (f8 && !input_pressed_f8) residency.getAccounting().report();
+	input_pressed_f8 = f8;
+
 	// CAMERA
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) camera.ProcessKeyboard(FORWARD, delta);
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) camera.ProcessKeyboard(BACKWARD, delta);
@@ -69,6 +227,49 @@ Camera& GLTFScene::getCamera()
 	return camera;
 }
 
+UploadScheduler& GLTFScene::getUploadScheduler()
+{
+	return upload_scheduler;
+}
+
+ResidencyManager& GLTFScene::getResidencyManager()
+{
+	return residency;
+}
+
+TextureCache& GLTFScene::getTextureCache()
+{
+	return texture_cache;
+}
+
+TextureBinding GLTFScene::getTextureBinding() const
+{
+	return texture_binding;
+}
+
+size_t GLTFScene::getFrameBytesWritten() const
+{
+	return frame_ring.getBytesWritten() + draw_data.getBytesWritten();
+}
+
+double GLTFScene::getFrameSyncWait() const
+{
+	return frame_ring.getWaitTime() + draw_data.getWaitTime();
+}
+
+const std::vector<GLTFModel*>& GLTFScene::getModels() const
+{
+	return models;
+}
+
+bool GLTFScene::isLoading() const
+{
+	for (auto& model : models) {
+		if (!model->isReady() && model->getLoadState() != LoadState::Failed) return true;
+	}
+	return !upload_scheduler.idle() || shader_cache.getPendingCount() > 0;
+}
+
 // RENDER HERE
 void GLTFScene::render_setup()
 {
@@ -76,7 +277,8 @@ void GLTFScene::render_setup()
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
 
-	glEnable(GL_BLEND);
+	// blending is enabled only for the blend pass
+	glDisable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); 
@@ -84,38 +286,367 @@ void GLTFScene::render_setup()
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 
-	// Set shader
-	shader_current = shaders["passthrough"];
-	shader_current->use();
+	// Frame data (uniform block 0) & per-draw data (texture unit 1) are shared by all shaders
+	// (model shader variants get them from shader_cache setup)
+	GLint ubo_alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+	frame_ring.init(GL_UNIFORM_BUFFER, sizeof(FrameData), ubo_alignment);
+	draw_data.init(1024);
 
-	// Bind models
-	for (auto& model : models) {
-		model->bind();
+	for (auto& shd : shaders) {
+		shd.second->use();
+		shd.second->setUniformBlock("FrameData", 0);
+		shd.second->setInt("draw_data", 1);
 	}
+	pass_queries.init(PASS_COUNT);
+	gpu_profiler.init();
+
+	// Models are uploaded in render, within frame budget
+	upload_scheduler.init();
+	setupBounds();
 }
 
 void GLTFScene::render(GLFWwindow* window)
 {
-	// Clear
-	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	// Camera
 	GLint window_width, window_height;
 	glfwGetWindowSize(window, &window_width, &window_height);
+	render(window_width, window_height, glfwGetTime());
+}
 
+void GLTFScene::render(int width, int height, double time)
+{
+	PROFILE_ZONE("GLTFScene::render");
+	gpu_profiler.beginFrame();
+
+	// Uploads, shader variants which finished compiling
+	{
+		GpuScope scope(gpu_profiler, "uploads");
+		upload_scheduler.process();
+		shader_cache.update();
+	}
+
+	// Clear
+	{
+		GpuScope scope(gpu_profiler, "clear");
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	// Camera
 	glm::mat4 view = camera.GetViewMatrix();
-	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)window_width / (float)window_height, 0.1f, 1000.0f);
+	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, z_near, z_far);
+
+	writeFrameData(view, projection, time);
+
+	// Per-draw data of all models, written before any draw
+	size_t draws = 0;
+	for (auto& model : models) {
+		model->update();
+		model->updateStreaming(view, projection, (float)height);
+		draws += model->getDrawCount();
+	}
+
+	draw_data.beginFrame(draws);
+	glm::mat4 view_proj = projection * view;
+	for (auto& model : models) {
+		model->writeDrawData(draw_data, view_proj);
+	}
+	draw_data.finishWrites();
+	draw_data.bind(GL_TEXTURE1);
+
+	// Models: opaque primitives of all models first, then alpha tested ones (models switch shader variants themselves)
+	pass_queries.beginFrame();
+	updateDepthPrepass();
+	drawOpaque();
+
+	pass_queries.begin(PASS_MASK);
+	{
+		GpuScope scope(gpu_profiler, "mask");
+		for (size_t i = 0; i < models.size(); ++i) {
+			if (!models[i]->isGeometryReady()) continue;
+			GpuScope model_scope(gpu_profiler, model_labels[i]);
+			models[i]->draw(AlphaPass::Mask);
+		}
+	}
+	pass_queries.end(PASS_MASK);
+
+	bool has_placeholders = false;
+	bool all_loaded = true;
+	for (auto& model : models) {
+		if (!model->isGeometryReady() && model->getLoadState() != LoadState::Failed) has_placeholders = true;
+		if (!model->isReady() && model->getLoadState() != LoadState::Failed) all_loaded = false;
+	}
+
+	if (all_loaded && !texture_cache_reported) {
+		reportTextureCache();
+		reportShaderCache();
+	}
+
+	// Placeholders (bounding boxes) of models which are still loading
+	if (has_placeholders) {
+		GpuScope scope(gpu_profiler, "placeholders");
+		Shader* bounds_shader = shaders["bounds"];
+		bounds_shader->use();
+
+		for (auto& model : models) {
+			if (!model->isGeometryReady() && model->getLoadState() != LoadState::Failed)
+				drawBounds(*bounds_shader, *model);
+		}
+	}
+
+	// Blended primitives last, back to front
+	pass_queries.begin(PASS_BLEND);
+	{
+		GpuScope scope(gpu_profiler, "blend"); // sorted over all models, no per-model scopes
+		drawBlended(view);
+	}
+	pass_queries.end(PASS_BLEND);
+
+	// Stats of this frame (counted since the last one), per-frame data is written directly into mapped buffers
+	RenderStats& stats = RenderStats::current();
+	stats.buffer_bytes += getFrameBytesWritten();
+	render_stats = stats;
+	stats.reset();
+	render_stats_log.add(render_stats);
+
+	// Frame & draw data of this frame are protected until gpu is done with them
+	draw_data.endFrame();
+	frame_ring.endFrame();
+
+	// Evict least recently drawn models if over gpu budget
+	residency.update();
+
+	gpu_profiler.endFrame();
+}
+
+void GLTFScene::drawOpaque()
+{
+	PROFILE_ZONE("GLTFScene::drawOpaque");
+	if (depth_prepass_active) {
+		// depth only: position stream, no color writes
+		pass_queries.begin(PASS_DEPTH);
+		GpuScope scope(gpu_profiler, "depth");
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		Shader* depth_shader = shaders["depth"];
+		depth_shader->use();
+		for (size_t i = 0; i < models.size(); ++i) {
+			if (!models[i]->isGeometryReady()) continue;
+			GpuScope model_scope(gpu_profiler, model_labels[i]);
+			models[i]->drawDepth(*depth_shader);
+		}
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		pass_queries.end(PASS_DEPTH);
+
+		// every opaque pixel is shaded once
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	pass_queries.begin(PASS_OPAQUE);
+	{
+		GpuScope scope(gpu_profiler, "opaque");
+		for (size_t i = 0; i < models.size(); ++i) {
+			if (!models[i]->isGeometryReady()) continue;
+			GpuScope model_scope(gpu_profiler, model_labels[i]);
+			models[i]->draw(AlphaPass::Opaque);
+		}
+	}
+	pass_queries.end(PASS_OPAQUE);
+
+	if (depth_prepass_active) {
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+}
 
-	shader_current->setMat4("view", view);
-	shader_current->setMat4("projection", projection);
+void GLTFScene::updateDepthPrepass()
+{
+	// overdraw = fragments passing depth test in pre-pass / pixels shaded after it
+	const std::vector<PassResult>& results = pass_queries.getResults();
+	if (pass_queries.hasNewResults() && results[PASS_DEPTH].valid && results[PASS_OPAQUE].samples > 0) {
+		overdraw = (float)results[PASS_DEPTH].samples / (float)results[PASS_OPAQUE].samples;
+
+		// hysteresis, so it doesn't flip every probe
+		if (!depth_prepass_auto && overdraw > DEPTH_PREPASS_ON) depth_prepass_auto = true;
+		else if (depth_prepass_auto && overdraw < DEPTH_PREPASS_OFF) depth_prepass_auto = false;
+	}
+
+	switch (depth_prepass) {
+	case DepthPrepass::On: depth_prepass_active = true; break;
+	case DepthPrepass::Off: depth_prepass_active = false; break;
+	case DepthPrepass::Auto:
+		// while off, one pre-pass frame now and then measures overdraw
+		frames_since_probe++;
+		depth_prepass_active = depth_prepass_auto || frames_since_probe >= DEPTH_PREPASS_PROBE;
+		if (depth_prepass_active) frames_since_probe = 0;
+		break;
+	}
+}
+
+void GLTFScene::drawBlended(const glm::mat4& view)
+{
+	PROFILE_ZONE("GLTFScene::drawBlended");
+	blend_draws.clear();
+	for (auto& model : models) {
+		if (model->isGeometryReady()) model->collectBlendDraws(view, blend_draws);
+	}
+	if (blend_draws.empty()) return;
 
-	// Models
-	for (size_t model_index = 0; model_index < models.size(); ++model_index) {
-		GLTFModel* model = models.at(model_index);
+	// farthest first, over all models
+	std::stable_sort(blend_draws.begin(), blend_draws.end(),
+		[](const BlendDraw& a, const BlendDraw& b) { return a.depth > b.depth; });
 
-		model->draw(*shader_current);
+	// depth is tested, not written (blended surfaces behind each other stay visible)
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+
+	// consecutive primitives of the same model are drawn in one call
+	std::vector<size_t> primitives;
+	for (size_t i = 0; i < blend_draws.size(); ++i) {
+		primitives.push_back(blend_draws[i].primitive);
+		if (i + 1 == blend_draws.size() || blend_draws[i + 1].model != blend_draws[i].model) {
+			blend_draws[i].model->drawPrimitives(primitives);
+			primitives.clear();
+		}
 	}
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+
+void GLTFScene::setDepthRange(float z_near, float z_far)
+{
+	this->z_near = z_near;
+	this->z_far = z_far;
+}
+
+void GLTFScene::setDepthPrepass(DepthPrepass mode)
+{
+	depth_prepass = mode;
+	frames_since_probe = DEPTH_PREPASS_PROBE; // auto measures right away
+}
+
+DepthPrepass GLTFScene::getDepthPrepass() const
+{
+	return depth_prepass;
+}
+
+bool GLTFScene::isDepthPrepassActive() const
+{
+	return depth_prepass_active;
+}
+
+float GLTFScene::getOverdraw() const
+{
+	return overdraw;
+}
+
+const std::vector<PassResult>& GLTFScene::getPassResults() const
+{
+	return pass_queries.getResults();
+}
+
+const RenderStats& GLTFScene::getRenderStats() const
+{
+	return render_stats;
+}
+
+GpuProfiler& GLTFScene::getGpuProfiler()
+{
+	return gpu_profiler;
+}
+
+void GLTFScene::writeFrameData(const glm::mat4& view, const glm::mat4& projection, double time)
+{
+	frame_ring.beginFrame();
+	size_t offset = 0;
+	FrameData* data = (FrameData*)frame_ring.allocate(sizeof(FrameData), offset);
+	if (data != nullptr) {
+		data->view = view;
+		data->projection = projection;
+		data->view_proj = projection * view;
+		data->camera_pos = glm::vec4(camera.Position, 1.0f);
+		data->time = glm::vec4((float)time, (float)(time - last_time), 0.0f, 0.0f);
+	}
+	frame_ring.finishWrites();
+	last_time = time;
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, frame_ring.getBuffer(), offset, sizeof(FrameData));
+}
+
+void GLTFScene::setupBounds()
+{
+	// unit cube, drawn as lines
+	const float vertices[] = {
+		0, 0, 0,	1, 0, 0,	1, 1, 0,	0, 1, 0,
+		0, 0, 1,	1, 0, 1,	1, 1, 1,	0, 1, 1
+	};
+	const GLushort indices[] = {
+		0, 1,	1, 2,	2, 3,	3, 0,
+		4, 5,	5, 6,	6, 7,	7, 4,
+		0, 4,	1, 5,	2, 6,	3, 7
+	};
+
+	glGenVertexArrays(1, &bounds_vao);
+	glBindVertexArray(bounds_vao);
+
+	glGenBuffers(1, &bounds_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, bounds_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &bounds_ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bounds_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), BUFFER_OFFSET(0));
+
+	glBindVertexArray(0);
+}
+
+void GLTFScene::drawBounds(Shader& shader, GLTFModel& model)
+{
+	glBindVertexArray(bounds_vao);
+	RenderStats::current().vao_binds++;
+
+	const std::vector<MeshBounds>& bounds = model.getBounds();
+	if (bounds.empty()) {
+		// not parsed yet, only position is known
+		glm::mat4 box = glm::translate(model.getMeshWorld(glm::mat4(1.0)), glm::vec3(-0.5));
+		shader.setMat4("model", box);
+		shader.setVec4("color", 0.6f, 0.6f, 0.6f, 1.0f);
+		glDrawElements(GL_LINES, 24, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0));
+		RenderStats::current().countDraw(GL_LINES, 24);
+	}
+	else {
+		shader.setVec4("color", 1.0f, 0.8f, 0.2f, 1.0f);
+		for (auto& mb : bounds) {
+			glm::mat4 box = glm::translate(model.getMeshWorld(mb.node_world), mb.min);
+			box = glm::scale(box, mb.max - mb.min);
+			shader.setMat4("model", box);
+			glDrawElements(GL_LINES, 24, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0));
+			RenderStats::current().countDraw(GL_LINES, 24);
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+void GLTFScene::reportTextureCache()
+{
+	texture_cache_reported = true;
+	if (texture_binding == TextureBinding::Arrays) return;
+
+	const TextureCacheStats& stats = texture_cache.getStats();
+	std::cout << "Texture cache: " << stats.textures << " textures, " << stats.shared << " shared, "
+		<< stats.samplers << " samplers, saved " << stats.saved_bytes / (1024 * 1024) << " MB" << std::endl;
+}
+
+void GLTFScene::reportShaderCache()
+{
+	const ProgramBinaryStats& stats = program_binaries.getStats();
+	std::cout << "Shader cache: " << shader_cache.getVariantCount() << " variants, program binaries: "
+		<< stats.hits << " hits, " << stats.misses << " misses, saved " << stats.saved_ms << " ms" << std::endl;
 }
 
 void GLTFScene::scene_init()
@@ -127,6 +658,8 @@ void GLTFScene::scene_init()
 // Utilities
 void GLTFScene::reload_models_transform()
 {
+	if (!custom_model_paths.empty()) return; // transforms of scene file are for its models
+
 	std::ifstream f(scene_json_file);
 	nlohmann::json json = nlohmann::json::parse(f);
 
@@ -162,12 +695,27 @@ void GLTFScene::reload_models_transform()
 
 void GLTFScene::cleanup()
 {
+	// clean frame data
+	frame_ring.cleanup();
+	pass_queries.cleanup();
+	gpu_profiler.cleanup();
+	draw_data.cleanup();
+
+	// clean placeholders
+	glDeleteVertexArrays(1, &bounds_vao);
+	glDeleteBuffers(1, &bounds_vbo);
+	glDeleteBuffers(1, &bounds_ebo);
+
 	// clean models
+	if (memory_report) residency.getAccounting().report();
+	upload_scheduler.cleanup();
 	for (auto& m : models) {
 		delete m;
 	}
+	texture_cache.cleanup();
 
 	// clean shaders
+	shader_cache.cleanup();
 	for (auto& shd : shaders) {
 		delete shd.second;
 	}
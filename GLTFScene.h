@@ -6,8 +6,17 @@
 
 #include "camera.h"
 #include "Shader.h"
+#include "ShaderCache.h"
 
 #include "GLTFModel.h"
+#include "ResidencyManager.h"
+#include "TextureCache.h"
+#include "BufferRing.h"
+#include "DrawDataBuffer.h"
+#include "GpuProfiler.h"
+#include "PassQueries.h"
+#include "RenderStats.h"
+#include "UploadScheduler.h"
 
 
 /*
@@ -15,21 +24,57 @@
 	Camera - Mouse
 	Quit - Escape
 	F5 - reload scene file (scene_json_file)
+	F6 - depth pre-pass: off / on / auto
+	F7 - gpu profiler: on / print averages & off
 
 	drop your models into "model" folder
 	drop your shaders into "shaders" folder
 */
 
+// How materials get their textures (picked at runtime, see init)
+enum class TextureBinding {
+	Classic,	// texture bind per material
+	Arrays,		// texture array per model
+	Bindless	// GL_ARB_bindless_texture handles in material buffer
+};
+
+// Depth-only pass of opaque geometry before shading (shading then tests GL_EQUAL)
+enum class DepthPrepass {
+	Off,
+	On,
+	Auto	// on while measured overdraw is high
+};
+
+// Render passes with gpu time & samples (see getPassResults)
+enum RenderPass {
+	PASS_DEPTH,
+	PASS_OPAQUE,
+	PASS_MASK,
+	PASS_BLEND,
+	PASS_COUNT
+};
+
+// Per-frame uniforms (std140, see FrameData block in shaders)
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 view_proj;
+	glm::vec4 camera_pos;
+	glm::vec4 time; // x - seconds, y - delta
+};
+
 class GLTFScene
 {
 public:
 	GLTFScene();
 
 	void init();
+	void setModels(const std::vector<std::string>& paths); // before init, replaces "models" of scene file (no "transform" then)
 	void processInput(GLFWwindow* window, float delta);
 
 	void render_setup();
 	void render(GLFWwindow* window);
+	void render(int width, int height, double time); // into bound framebuffer, time in seconds (see FrameData)
 
 	void scene_init();
 	void reload_models_transform();
@@ -37,19 +82,83 @@ public:
 	void cleanup();
 
 	Camera& getCamera();
+	UploadScheduler& getUploadScheduler();
+	ResidencyManager& getResidencyManager(); // gpu memory counters
+	TextureCache& getTextureCache(); // shared textures & samplers
+	TextureBinding getTextureBinding() const;
+	size_t getFrameBytesWritten() const; // frame & per-draw data of last frame
+	double getFrameSyncWait() const; // ms waited for gpu before writing them
+	void setDepthRange(float z_near, float z_far); // projection near & far planes
+	void setDepthPrepass(DepthPrepass mode);
+	DepthPrepass getDepthPrepass() const;
+	bool isDepthPrepassActive() const; // last frame
+	float getOverdraw() const; // opaque fragments per visible pixel, measured by pre-pass frames
+	const std::vector<PassResult>& getPassResults() const; // by RenderPass, a few frames old
+	const RenderStats& getRenderStats() const; // last frame, models & placeholders
+	GpuProfiler& getGpuProfiler(); // gpu time of passes & models
+	const std::vector<GLTFModel*>& getModels() const; // check getLoadState() for progress
+	bool isLoading() const; // models, uploads or shader variants still pending (final image not shown yet)
 
 public:
-	const std::string scene_json_file = "./scene_setup.json";
+	std::string scene_json_file = "./scene_setup.json"; // before init
 
 private:
+	void setupBounds();
+	void drawBounds(Shader& shader, GLTFModel& model);
+	void reportTextureCache();
+	void reportShaderCache();
+	void writeFrameData(const glm::mat4& view, const glm::mat4& projection, double time);
+	void drawBlended(const glm::mat4& view);
+	void drawOpaque();
+	void updateDepthPrepass();
+
+private:
+	TextureBinding texture_binding = TextureBinding::Classic; // see scene_setup.json
+
 	// to handle single pressing
 	bool input_pressed_f5 = false;
+	bool input_pressed_f6 = false;
+	bool input_pressed_f7 = false;
+	bool input_pressed_f8 = false;
 
 private:
 	Camera camera;
+	float z_near = 0.1f;
+	float z_far = 1000.0f;
 	std::vector<GLTFModel*> models;
+	std::vector<std::string> custom_model_paths; // see setModels
+	std::vector<std::string> model_labels; // gpu profiler scopes, by model
+
+	UploadScheduler upload_scheduler; // gpu uploads spread over frames
+	ResidencyManager residency; // gpu memory budget & memory accounting
+	bool memory_report = false; // at cleanup, see scene_setup.json
+	TextureCache texture_cache; // textures & samplers shared between models
+
+	// data written by cpu every frame (triple buffered)
+	BufferRing frame_ring; // FrameData uniform block
+	DrawDataBuffer draw_data; // per-draw matrices & materials
+	std::vector<BlendDraw> blend_draws; // this frame, sorted back to front
+	RenderStats render_stats; // last frame
+	RenderStatsLog render_stats_log; // see scene_setup.json
+
+	// depth pre-pass, auto mode measures overdraw with a pre-pass frame every DEPTH_PREPASS_PROBE frames
+	DepthPrepass depth_prepass = DepthPrepass::Off;
+	bool depth_prepass_auto = false; // auto mode decided to use it
+	bool depth_prepass_active = false;
+	float overdraw = 0.0f;
+	int frames_since_probe = 0;
+	PassQueries pass_queries;
+	GpuProfiler gpu_profiler;
+	double last_time = 0.0;
+	bool texture_cache_reported = false;
+
+	// placeholder box for models which are still loading
+	GLuint bounds_vao = 0;
+	GLuint bounds_vbo = 0;
+	GLuint bounds_ebo = 0;
 
 	std::map<std::string, Shader*> shaders;
-	Shader* shader_current;
+	ShaderCache shader_cache; // model shader variants
+	ProgramBinaryCache program_binaries; // linked programs of previous runs
 };
 
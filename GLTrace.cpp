@@ -0,0 +1,1269 @@
+#include "GLTrace.h"
+#include "Benchmark.h"
+#include "GLExtensions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+static const char TRACE_MAGIC[8] = { 'G', 'L', 'T', 'R', 'A', 'C', 'E', 1 };
+static const uint64_t NO_DATA = ~0ull; // blob of nullptr
+
+// Recorded calls (ids are part of the file format, append only)
+enum TraceCall : uint16_t {
+	CALL_FRAME,
+	CALL_ACTIVE_TEXTURE,
+	CALL_BLEND_FUNC,
+	CALL_COLOR_MASK,
+	CALL_CULL_FACE,
+	CALL_DEPTH_FUNC,
+	CALL_DEPTH_MASK,
+	CALL_DISABLE,
+	CALL_ENABLE,
+	CALL_PIXEL_STOREI,
+	CALL_POLYGON_MODE,
+	CALL_VIEWPORT,
+	CALL_CLEAR_COLOR,
+	CALL_CLEAR,
+	CALL_GEN_BUFFERS,
+	CALL_DELETE_BUFFERS,
+	CALL_BIND_BUFFER,
+	CALL_BIND_BUFFER_BASE,
+	CALL_BIND_BUFFER_RANGE,
+	CALL_BUFFER_DATA,
+	CALL_BUFFER_SUB_DATA,
+	CALL_MAP_BUFFER_RANGE,
+	CALL_FLUSH_MAPPED_BUFFER_RANGE,
+	CALL_UNMAP_BUFFER,
+	CALL_GEN_VERTEX_ARRAYS,
+	CALL_DELETE_VERTEX_ARRAYS,
+	CALL_BIND_VERTEX_ARRAY,
+	CALL_ENABLE_VERTEX_ATTRIB_ARRAY,
+	CALL_VERTEX_ATTRIB_POINTER,
+	CALL_GEN_TEXTURES,
+	CALL_DELETE_TEXTURES,
+	CALL_BIND_TEXTURE,
+	CALL_TEX_PARAMETERI,
+	CALL_TEX_PARAMETERF,
+	CALL_TEX_IMAGE_2D,
+	CALL_TEX_IMAGE_3D,
+	CALL_TEX_SUB_IMAGE_3D,
+	CALL_TEX_BUFFER,
+	CALL_GENERATE_MIPMAP,
+	CALL_GEN_SAMPLERS,
+	CALL_DELETE_SAMPLERS,
+	CALL_BIND_SAMPLER,
+	CALL_SAMPLER_PARAMETERI,
+	CALL_CREATE_SHADER,
+	CALL_DELETE_SHADER,
+	CALL_SHADER_SOURCE,
+	CALL_COMPILE_SHADER,
+	CALL_CREATE_PROGRAM,
+	CALL_DELETE_PROGRAM,
+	CALL_ATTACH_SHADER,
+	CALL_LINK_PROGRAM,
+	CALL_USE_PROGRAM,
+	CALL_GET_UNIFORM_LOCATION,
+	CALL_GET_UNIFORM_BLOCK_INDEX,
+	CALL_UNIFORM_BLOCK_BINDING,
+	CALL_UNIFORM_1I,
+	CALL_UNIFORM_1F,
+	CALL_UNIFORM_2F,
+	CALL_UNIFORM_3F,
+	CALL_UNIFORM_4F,
+	CALL_UNIFORM_2FV,
+	CALL_UNIFORM_3FV,
+	CALL_UNIFORM_4FV,
+	CALL_UNIFORM_MATRIX_2FV,
+	CALL_UNIFORM_MATRIX_3FV,
+	CALL_UNIFORM_MATRIX_4FV,
+	CALL_DRAW_ELEMENTS,
+	CALL_GEN_FRAMEBUFFERS,
+	CALL_DELETE_FRAMEBUFFERS,
+	CALL_BIND_FRAMEBUFFER,
+	CALL_GEN_RENDERBUFFERS,
+	CALL_DELETE_RENDERBUFFERS,
+	CALL_BIND_RENDERBUFFER,
+	CALL_RENDERBUFFER_STORAGE,
+	CALL_FRAMEBUFFER_RENDERBUFFER,
+	CALL_READ_PIXELS,
+	CALL_GEN_QUERIES,
+	CALL_DELETE_QUERIES,
+	CALL_BEGIN_QUERY,
+	CALL_END_QUERY,
+	CALL_QUERY_COUNTER,
+	CALL_GET_QUERY_OBJECTIV,
+	CALL_GET_QUERY_OBJECTUI64V,
+	CALL_FENCE_SYNC,
+	CALL_DELETE_SYNC,
+	CALL_CLIENT_WAIT_SYNC,
+	CALL_GET_SYNCIV,
+	CALL_PUSH_DEBUG_GROUP,
+	CALL_POP_DEBUG_GROUP,
+	CALL_COUNT
+};
+
+// Bytes of pixel data read by GL (rows padded to alignment, except the last one)
+static size_t getImageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint alignment)
+{
+	if (width <= 0 || height <= 0 || depth <= 0) return 0;
+
+	size_t components = 4;
+	if (format == GL_RED) components = 1;
+	else if (format == GL_RG) components = 2;
+	else if (format == GL_RGB) components = 3;
+
+	size_t component_size = 1;
+	if (type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT) component_size = 2;
+	else if (type == GL_FLOAT || type == GL_UNSIGNED_INT || type == GL_INT) component_size = 4;
+
+	size_t row = (size_t)width * components * component_size;
+	size_t stride = (row + alignment - 1) / alignment * alignment;
+	return stride * ((size_t)height * depth - 1) + row;
+}
+
+// Capture
+
+static struct {
+	std::ofstream file;
+	bool capturing = false;
+	GLADloadproc loader = nullptr;
+	size_t calls = 0;
+	size_t frames = 0;
+
+	GLint unpack_alignment = 4;
+	std::map<GLenum, GLuint> bound_buffers; // by target
+
+	struct Mapping {
+		unsigned char* data = nullptr;
+		GLbitfield access = 0;
+		GLsizeiptr length = 0;
+	};
+	std::map<GLenum, Mapping> mappings; // by target
+
+	bool extensions_read = false;
+	std::vector<std::string> extensions; // reported ones
+} capture;
+
+// Extensions whose calls are recorded (others are hidden)
+static const char* trace_extensions[] = { "GL_KHR_debug" };
+
+static void put(const void* data, size_t size)
+{
+	capture.file.write((const char*)data, size);
+}
+
+static void put32(uint32_t value)
+{
+	put(&value, sizeof(value));
+}
+
+static void put64(uint64_t value)
+{
+	put(&value, sizeof(value));
+}
+
+static void putFloat(float value)
+{
+	put(&value, sizeof(value));
+}
+
+static void putBlob(const void* data, size_t size)
+{
+	put64(data != nullptr ? size : NO_DATA);
+	if (data != nullptr) put(data, size);
+}
+
+static void putString(const char* text, GLint length)
+{
+	size_t size = length >= 0 ? (size_t)length : strlen(text);
+	putBlob(text, size);
+}
+
+static void putCall(TraceCall call)
+{
+	uint16_t id = call;
+	put(&id, sizeof(id));
+	capture.calls++;
+}
+
+#define TRACE_REAL(name) static decltype(glad_##name) real_##name = nullptr
+#define TRACE_REAL_EXT(name) static decltype(glext_##name) real_##name = nullptr
+
+// Filtered by trace_extensions, GL 3.3
+TRACE_REAL(glGetIntegerv);
+TRACE_REAL(glGetStringi);
+
+static void readExtensions()
+{
+	if (capture.extensions_read) return;
+	capture.extensions_read = true;
+
+	GLint count = 0;
+	real_glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		const char* name = (const char*)real_glGetStringi(GL_EXTENSIONS, i);
+		if (name == nullptr) continue;
+		for (const char* allowed : trace_extensions) {
+			if (strcmp(name, allowed) == 0) capture.extensions.push_back(name);
+		}
+	}
+}
+
+static void APIENTRY trace_glGetIntegerv(GLenum pname, GLint* data)
+{
+	if (pname == GL_NUM_EXTENSIONS) {
+		readExtensions();
+		*data = (GLint)capture.extensions.size();
+		return;
+	}
+	real_glGetIntegerv(pname, data);
+	if (pname == GL_MAJOR_VERSION || pname == GL_MINOR_VERSION) *data = 3;
+}
+
+static const GLubyte* APIENTRY trace_glGetStringi(GLenum name, GLuint index)
+{
+	if (name != GL_EXTENSIONS) return real_glGetStringi(name, index);
+	readExtensions();
+	return index < capture.extensions.size() ? (const GLubyte*)capture.extensions[index].c_str() : nullptr;
+}
+
+// State
+TRACE_REAL(glActiveTexture);
+TRACE_REAL(glBlendFunc);
+TRACE_REAL(glColorMask);
+TRACE_REAL(glCullFace);
+TRACE_REAL(glDepthFunc);
+TRACE_REAL(glDepthMask);
+TRACE_REAL(glDisable);
+TRACE_REAL(glEnable);
+TRACE_REAL(glPixelStorei);
+TRACE_REAL(glPolygonMode);
+TRACE_REAL(glViewport);
+TRACE_REAL(glClearColor);
+TRACE_REAL(glClear);
+
+static void APIENTRY trace_glActiveTexture(GLenum texture) { real_glActiveTexture(texture); putCall(CALL_ACTIVE_TEXTURE); put32(texture); }
+static void APIENTRY trace_glBlendFunc(GLenum sfactor, GLenum dfactor) { real_glBlendFunc(sfactor, dfactor); putCall(CALL_BLEND_FUNC); put32(sfactor); put32(dfactor); }
+static void APIENTRY trace_glColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+	real_glColorMask(r, g, b, a);
+	putCall(CALL_COLOR_MASK); put32(r); put32(g); put32(b); put32(a);
+}
+static void APIENTRY trace_glCullFace(GLenum mode) { real_glCullFace(mode); putCall(CALL_CULL_FACE); put32(mode); }
+static void APIENTRY trace_glDepthFunc(GLenum func) { real_glDepthFunc(func); putCall(CALL_DEPTH_FUNC); put32(func); }
+static void APIENTRY trace_glDepthMask(GLboolean flag) { real_glDepthMask(flag); putCall(CALL_DEPTH_MASK); put32(flag); }
+static void APIENTRY trace_glDisable(GLenum cap) { real_glDisable(cap); putCall(CALL_DISABLE); put32(cap); }
+static void APIENTRY trace_glEnable(GLenum cap) { real_glEnable(cap); putCall(CALL_ENABLE); put32(cap); }
+static void APIENTRY trace_glPixelStorei(GLenum pname, GLint param)
+{
+	real_glPixelStorei(pname, param);
+	putCall(CALL_PIXEL_STOREI); put32(pname); put32(param);
+	if (pname == GL_UNPACK_ALIGNMENT) capture.unpack_alignment = param;
+}
+static void APIENTRY trace_glPolygonMode(GLenum face, GLenum mode) { real_glPolygonMode(face, mode); putCall(CALL_POLYGON_MODE); put32(face); put32(mode); }
+static void APIENTRY trace_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	real_glViewport(x, y, width, height);
+	putCall(CALL_VIEWPORT); put32(x); put32(y); put32(width); put32(height);
+}
+static void APIENTRY trace_glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+	real_glClearColor(r, g, b, a);
+	putCall(CALL_CLEAR_COLOR); putFloat(r); putFloat(g); putFloat(b); putFloat(a);
+}
+static void APIENTRY trace_glClear(GLbitfield mask) { real_glClear(mask); putCall(CALL_CLEAR); put32(mask); }
+
+// Object names: count, then names
+static void putNames(TraceCall call, GLsizei n, const GLuint* names)
+{
+	putCall(call);
+	put32(n);
+	put(names, sizeof(GLuint) * n);
+}
+
+// Buffers
+TRACE_REAL(glGenBuffers);
+TRACE_REAL(glDeleteBuffers);
+TRACE_REAL(glBindBuffer);
+TRACE_REAL(glBindBufferBase);
+TRACE_REAL(glBindBufferRange);
+TRACE_REAL(glBufferData);
+TRACE_REAL(glBufferSubData);
+TRACE_REAL(glMapBufferRange);
+TRACE_REAL(glFlushMappedBufferRange);
+TRACE_REAL(glUnmapBuffer);
+
+static void APIENTRY trace_glGenBuffers(GLsizei n, GLuint* buffers) { real_glGenBuffers(n, buffers); putNames(CALL_GEN_BUFFERS, n, buffers); }
+static void APIENTRY trace_glDeleteBuffers(GLsizei n, const GLuint* buffers) { real_glDeleteBuffers(n, buffers); putNames(CALL_DELETE_BUFFERS, n, buffers); }
+static void APIENTRY trace_glBindBuffer(GLenum target, GLuint buffer)
+{
+	real_glBindBuffer(target, buffer);
+	putCall(CALL_BIND_BUFFER); put32(target); put32(buffer);
+	capture.bound_buffers[target] = buffer;
+}
+static void APIENTRY trace_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	real_glBindBufferBase(target, index, buffer);
+	putCall(CALL_BIND_BUFFER_BASE); put32(target); put32(index); put32(buffer);
+	capture.bound_buffers[target] = buffer;
+}
+static void APIENTRY trace_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	real_glBindBufferRange(target, index, buffer, offset, size);
+	putCall(CALL_BIND_BUFFER_RANGE); put32(target); put32(index); put32(buffer); put64(offset); put64(size);
+	capture.bound_buffers[target] = buffer;
+}
+static void APIENTRY trace_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	real_glBufferData(target, size, data, usage);
+	putCall(CALL_BUFFER_DATA); put32(target); put64(size); putBlob(data, size); put32(usage);
+}
+static void APIENTRY trace_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	real_glBufferSubData(target, offset, size, data);
+	putCall(CALL_BUFFER_SUB_DATA); put32(target); put64(offset); putBlob(data, size);
+}
+static void* APIENTRY trace_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	void* data = real_glMapBufferRange(target, offset, length, access);
+	putCall(CALL_MAP_BUFFER_RANGE); put32(target); put64(offset); put64(length); put32(access);
+
+	auto& mapping = capture.mappings[target];
+	mapping.data = (unsigned char*)data;
+	mapping.access = access;
+	mapping.length = length;
+	return data;
+}
+// Data written into mapped range is recorded when it becomes visible to GL
+static void APIENTRY trace_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length)
+{
+	auto& mapping = capture.mappings[target];
+	putCall(CALL_FLUSH_MAPPED_BUFFER_RANGE); put32(target); put64(offset);
+	putBlob(mapping.data != nullptr ? mapping.data + offset : nullptr, length);
+	real_glFlushMappedBufferRange(target, offset, length);
+}
+static GLboolean APIENTRY trace_glUnmapBuffer(GLenum target)
+{
+	// without explicit flush, everything written is visible at unmap
+	auto& mapping = capture.mappings[target];
+	bool written = (mapping.access & GL_MAP_WRITE_BIT) && !(mapping.access & GL_MAP_FLUSH_EXPLICIT_BIT);
+	putCall(CALL_UNMAP_BUFFER); put32(target);
+	putBlob(written ? mapping.data : nullptr, mapping.length);
+	mapping = decltype(capture.mappings)::mapped_type();
+	return real_glUnmapBuffer(target);
+}
+
+// Vertex arrays
+TRACE_REAL(glGenVertexArrays);
+TRACE_REAL(glDeleteVertexArrays);
+TRACE_REAL(glBindVertexArray);
+TRACE_REAL(glEnableVertexAttribArray);
+TRACE_REAL(glVertexAttribPointer);
+
+static void APIENTRY trace_glGenVertexArrays(GLsizei n, GLuint* arrays) { real_glGenVertexArrays(n, arrays); putNames(CALL_GEN_VERTEX_ARRAYS, n, arrays); }
+static void APIENTRY trace_glDeleteVertexArrays(GLsizei n, const GLuint* arrays) { real_glDeleteVertexArrays(n, arrays); putNames(CALL_DELETE_VERTEX_ARRAYS, n, arrays); }
+static void APIENTRY trace_glBindVertexArray(GLuint array) { real_glBindVertexArray(array); putCall(CALL_BIND_VERTEX_ARRAY); put32(array); }
+static void APIENTRY trace_glEnableVertexAttribArray(GLuint index) { real_glEnableVertexAttribArray(index); putCall(CALL_ENABLE_VERTEX_ATTRIB_ARRAY); put32(index); }
+static void APIENTRY trace_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	// pointer is offset into bound array buffer
+	real_glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	putCall(CALL_VERTEX_ATTRIB_POINTER); put32(index); put32(size); put32(type); put32(normalized); put32(stride); put64((uint64_t)(size_t)pointer);
+}
+
+// Textures & samplers
+TRACE_REAL(glGenTextures);
+TRACE_REAL(glDeleteTextures);
+TRACE_REAL(glBindTexture);
+TRACE_REAL(glTexParameteri);
+TRACE_REAL(glTexParameterf);
+TRACE_REAL(glTexImage2D);
+TRACE_REAL(glTexImage3D);
+TRACE_REAL(glTexSubImage3D);
+TRACE_REAL(glTexBuffer);
+TRACE_REAL(glGenerateMipmap);
+TRACE_REAL(glGenSamplers);
+TRACE_REAL(glDeleteSamplers);
+TRACE_REAL(glBindSampler);
+TRACE_REAL(glSamplerParameteri);
+
+static void APIENTRY trace_glGenTextures(GLsizei n, GLuint* textures) { real_glGenTextures(n, textures); putNames(CALL_GEN_TEXTURES, n, textures); }
+static void APIENTRY trace_glDeleteTextures(GLsizei n, const GLuint* textures) { real_glDeleteTextures(n, textures); putNames(CALL_DELETE_TEXTURES, n, textures); }
+static void APIENTRY trace_glBindTexture(GLenum target, GLuint texture) { real_glBindTexture(target, texture); putCall(CALL_BIND_TEXTURE); put32(target); put32(texture); }
+static void APIENTRY trace_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	real_glTexParameteri(target, pname, param);
+	putCall(CALL_TEX_PARAMETERI); put32(target); put32(pname); put32(param);
+}
+static void APIENTRY trace_glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+	real_glTexParameterf(target, pname, param);
+	putCall(CALL_TEX_PARAMETERF); put32(target); put32(pname); putFloat(param);
+}
+static void APIENTRY trace_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+	GLenum format, GLenum type, const void* pixels)
+{
+	real_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	putCall(CALL_TEX_IMAGE_2D); put32(target); put32(level); put32(internalformat); put32(width); put32(height); put32(border);
+	put32(format); put32(type); putBlob(pixels, getImageSize(width, height, 1, format, type, capture.unpack_alignment));
+}
+static void APIENTRY trace_glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth,
+	GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	real_glTexImage3D(target, level, internalformat, width, height, depth, border, format, type, pixels);
+	putCall(CALL_TEX_IMAGE_3D); put32(target); put32(level); put32(internalformat); put32(width); put32(height); put32(depth);
+	put32(border); put32(format); put32(type); putBlob(pixels, getImageSize(width, height, depth, format, type, capture.unpack_alignment));
+}
+static void APIENTRY trace_glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+	GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+	real_glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+	putCall(CALL_TEX_SUB_IMAGE_3D); put32(target); put32(level); put32(xoffset); put32(yoffset); put32(zoffset);
+	put32(width); put32(height); put32(depth); put32(format); put32(type);
+	putBlob(pixels, getImageSize(width, height, depth, format, type, capture.unpack_alignment));
+}
+static void APIENTRY trace_glTexBuffer(GLenum target, GLenum internalformat, GLuint buffer)
+{
+	real_glTexBuffer(target, internalformat, buffer);
+	putCall(CALL_TEX_BUFFER); put32(target); put32(internalformat); put32(buffer);
+}
+static void APIENTRY trace_glGenerateMipmap(GLenum target) { real_glGenerateMipmap(target); putCall(CALL_GENERATE_MIPMAP); put32(target); }
+static void APIENTRY trace_glGenSamplers(GLsizei n, GLuint* samplers) { real_glGenSamplers(n, samplers); putNames(CALL_GEN_SAMPLERS, n, samplers); }
+static void APIENTRY trace_glDeleteSamplers(GLsizei n, const GLuint* samplers) { real_glDeleteSamplers(n, samplers); putNames(CALL_DELETE_SAMPLERS, n, samplers); }
+static void APIENTRY trace_glBindSampler(GLuint unit, GLuint sampler) { real_glBindSampler(unit, sampler); putCall(CALL_BIND_SAMPLER); put32(unit); put32(sampler); }
+static void APIENTRY trace_glSamplerParameteri(GLuint sampler, GLenum pname, GLint param)
+{
+	real_glSamplerParameteri(sampler, pname, param);
+	putCall(CALL_SAMPLER_PARAMETERI); put32(sampler); put32(pname); put32(param);
+}
+
+// Shaders & programs
+TRACE_REAL(glCreateShader);
+TRACE_REAL(glDeleteShader);
+TRACE_REAL(glShaderSource);
+TRACE_REAL(glCompileShader);
+TRACE_REAL(glCreateProgram);
+TRACE_REAL(glDeleteProgram);
+TRACE_REAL(glAttachShader);
+TRACE_REAL(glLinkProgram);
+TRACE_REAL(glUseProgram);
+TRACE_REAL(glGetUniformLocation);
+TRACE_REAL(glGetUniformBlockIndex);
+TRACE_REAL(glUniformBlockBinding);
+
+static GLuint APIENTRY trace_glCreateShader(GLenum type)
+{
+	GLuint shader = real_glCreateShader(type);
+	putCall(CALL_CREATE_SHADER); put32(type); put32(shader);
+	return shader;
+}
+static void APIENTRY trace_glDeleteShader(GLuint shader) { real_glDeleteShader(shader); putCall(CALL_DELETE_SHADER); put32(shader); }
+static void APIENTRY trace_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	real_glShaderSource(shader, count, string, length);
+	putCall(CALL_SHADER_SOURCE); put32(shader); put32(count);
+	for (GLsizei i = 0; i < count; ++i) putString(string[i], length != nullptr ? length[i] : -1);
+}
+static void APIENTRY trace_glCompileShader(GLuint shader) { real_glCompileShader(shader); putCall(CALL_COMPILE_SHADER); put32(shader); }
+static GLuint APIENTRY trace_glCreateProgram()
+{
+	GLuint program = real_glCreateProgram();
+	putCall(CALL_CREATE_PROGRAM); put32(program);
+	return program;
+}
+static void APIENTRY trace_glDeleteProgram(GLuint program) { real_glDeleteProgram(program); putCall(CALL_DELETE_PROGRAM); put32(program); }
+static void APIENTRY trace_glAttachShader(GLuint program, GLuint shader) { real_glAttachShader(program, shader); putCall(CALL_ATTACH_SHADER); put32(program); put32(shader); }
+static void APIENTRY trace_glLinkProgram(GLuint program) { real_glLinkProgram(program); putCall(CALL_LINK_PROGRAM); put32(program); }
+static void APIENTRY trace_glUseProgram(GLuint program) { real_glUseProgram(program); putCall(CALL_USE_PROGRAM); put32(program); }
+// Locations differ between drivers & runs, replay looks them up by name
+static GLint APIENTRY trace_glGetUniformLocation(GLuint program, const GLchar* name)
+{
+	GLint location = real_glGetUniformLocation(program, name);
+	putCall(CALL_GET_UNIFORM_LOCATION); put32(program); putString(name, -1); put32(location);
+	return location;
+}
+static GLuint APIENTRY trace_glGetUniformBlockIndex(GLuint program, const GLchar* name)
+{
+	GLuint index = real_glGetUniformBlockIndex(program, name);
+	putCall(CALL_GET_UNIFORM_BLOCK_INDEX); put32(program); putString(name, -1); put32(index);
+	return index;
+}
+static void APIENTRY trace_glUniformBlockBinding(GLuint program, GLuint index, GLuint binding)
+{
+	real_glUniformBlockBinding(program, index, binding);
+	putCall(CALL_UNIFORM_BLOCK_BINDING); put32(program); put32(index); put32(binding);
+}
+
+// Uniforms (of program in use)
+TRACE_REAL(glUniform1i);
+TRACE_REAL(glUniform1f);
+TRACE_REAL(glUniform2f);
+TRACE_REAL(glUniform3f);
+TRACE_REAL(glUniform4f);
+TRACE_REAL(glUniform2fv);
+TRACE_REAL(glUniform3fv);
+TRACE_REAL(glUniform4fv);
+TRACE_REAL(glUniformMatrix2fv);
+TRACE_REAL(glUniformMatrix3fv);
+TRACE_REAL(glUniformMatrix4fv);
+
+static void APIENTRY trace_glUniform1i(GLint location, GLint v0) { real_glUniform1i(location, v0); putCall(CALL_UNIFORM_1I); put32(location); put32(v0); }
+static void APIENTRY trace_glUniform1f(GLint location, GLfloat v0) { real_glUniform1f(location, v0); putCall(CALL_UNIFORM_1F); put32(location); putFloat(v0); }
+static void APIENTRY trace_glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+	real_glUniform2f(location, v0, v1);
+	putCall(CALL_UNIFORM_2F); put32(location); putFloat(v0); putFloat(v1);
+}
+static void APIENTRY trace_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	real_glUniform3f(location, v0, v1, v2);
+	putCall(CALL_UNIFORM_3F); put32(location); putFloat(v0); putFloat(v1); putFloat(v2);
+}
+static void APIENTRY trace_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+	real_glUniform4f(location, v0, v1, v2, v3);
+	putCall(CALL_UNIFORM_4F); put32(location); putFloat(v0); putFloat(v1); putFloat(v2); putFloat(v3);
+}
+static void putUniform(TraceCall call, GLint location, GLsizei count, const GLfloat* value, size_t floats)
+{
+	putCall(call); put32(location); put32(count); put(value, sizeof(GLfloat) * floats * count);
+}
+static void APIENTRY trace_glUniform2fv(GLint location, GLsizei count, const GLfloat* value) { real_glUniform2fv(location, count, value); putUniform(CALL_UNIFORM_2FV, location, count, value, 2); }
+static void APIENTRY trace_glUniform3fv(GLint location, GLsizei count, const GLfloat* value) { real_glUniform3fv(location, count, value); putUniform(CALL_UNIFORM_3FV, location, count, value, 3); }
+static void APIENTRY trace_glUniform4fv(GLint location, GLsizei count, const GLfloat* value) { real_glUniform4fv(location, count, value); putUniform(CALL_UNIFORM_4FV, location, count, value, 4); }
+// matrices are recorded as given (transpose flag first)
+static void APIENTRY trace_glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	real_glUniformMatrix2fv(location, count, transpose, value);
+	putUniform(CALL_UNIFORM_MATRIX_2FV, location, count, value, 4); put32(transpose);
+}
+static void APIENTRY trace_glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	real_glUniformMatrix3fv(location, count, transpose, value);
+	putUniform(CALL_UNIFORM_MATRIX_3FV, location, count, value, 9); put32(transpose);
+}
+static void APIENTRY trace_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	real_glUniformMatrix4fv(location, count, transpose, value);
+	putUniform(CALL_UNIFORM_MATRIX_4FV, location, count, value, 16); put32(transpose);
+}
+
+// Draws (indices are offsets into element array buffer)
+TRACE_REAL(glDrawElements);
+
+static void APIENTRY trace_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	real_glDrawElements(mode, count, type, indices);
+	putCall(CALL_DRAW_ELEMENTS); put32(mode); put32(count); put32(type); put64((uint64_t)(size_t)indices);
+}
+
+// Framebuffers
+TRACE_REAL(glGenFramebuffers);
+TRACE_REAL(glDeleteFramebuffers);
+TRACE_REAL(glBindFramebuffer);
+TRACE_REAL(glGenRenderbuffers);
+TRACE_REAL(glDeleteRenderbuffers);
+TRACE_REAL(glBindRenderbuffer);
+TRACE_REAL(glRenderbufferStorage);
+TRACE_REAL(glFramebufferRenderbuffer);
+TRACE_REAL(glReadPixels);
+
+static void APIENTRY trace_glGenFramebuffers(GLsizei n, GLuint* framebuffers) { real_glGenFramebuffers(n, framebuffers); putNames(CALL_GEN_FRAMEBUFFERS, n, framebuffers); }
+static void APIENTRY trace_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) { real_glDeleteFramebuffers(n, framebuffers); putNames(CALL_DELETE_FRAMEBUFFERS, n, framebuffers); }
+static void APIENTRY trace_glBindFramebuffer(GLenum target, GLuint framebuffer) { real_glBindFramebuffer(target, framebuffer); putCall(CALL_BIND_FRAMEBUFFER); put32(target); put32(framebuffer); }
+static void APIENTRY trace_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers) { real_glGenRenderbuffers(n, renderbuffers); putNames(CALL_GEN_RENDERBUFFERS, n, renderbuffers); }
+static void APIENTRY trace_glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) { real_glDeleteRenderbuffers(n, renderbuffers); putNames(CALL_DELETE_RENDERBUFFERS, n, renderbuffers); }
+static void APIENTRY trace_glBindRenderbuffer(GLenum target, GLuint renderbuffer) { real_glBindRenderbuffer(target, renderbuffer); putCall(CALL_BIND_RENDERBUFFER); put32(target); put32(renderbuffer); }
+static void APIENTRY trace_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+	real_glRenderbufferStorage(target, internalformat, width, height);
+	putCall(CALL_RENDERBUFFER_STORAGE); put32(target); put32(internalformat); put32(width); put32(height);
+}
+static void APIENTRY trace_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+	real_glFramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+	putCall(CALL_FRAMEBUFFER_RENDERBUFFER); put32(target); put32(attachment); put32(renderbuffertarget); put32(renderbuffer);
+}
+// Into pixel pack buffer (pixels is offset) or client memory (replay reads into scratch memory)
+static void APIENTRY trace_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+{
+	real_glReadPixels(x, y, width, height, format, type, pixels);
+	bool pack_buffer = capture.bound_buffers[GL_PIXEL_PACK_BUFFER] != 0;
+	putCall(CALL_READ_PIXELS); put32(x); put32(y); put32(width); put32(height); put32(format); put32(type);
+	put32(pack_buffer); put64(pack_buffer ? (uint64_t)(size_t)pixels : 0);
+}
+
+// Queries & syncs (results are read in replay too, they may wait for gpu)
+TRACE_REAL(glGenQueries);
+TRACE_REAL(glDeleteQueries);
+TRACE_REAL(glBeginQuery);
+TRACE_REAL(glEndQuery);
+TRACE_REAL(glQueryCounter);
+TRACE_REAL(glGetQueryObjectiv);
+TRACE_REAL(glGetQueryObjectui64v);
+TRACE_REAL(glFenceSync);
+TRACE_REAL(glDeleteSync);
+TRACE_REAL(glClientWaitSync);
+TRACE_REAL(glGetSynciv);
+
+static void APIENTRY trace_glGenQueries(GLsizei n, GLuint* ids) { real_glGenQueries(n, ids); putNames(CALL_GEN_QUERIES, n, ids); }
+static void APIENTRY trace_glDeleteQueries(GLsizei n, const GLuint* ids) { real_glDeleteQueries(n, ids); putNames(CALL_DELETE_QUERIES, n, ids); }
+static void APIENTRY trace_glBeginQuery(GLenum target, GLuint id) { real_glBeginQuery(target, id); putCall(CALL_BEGIN_QUERY); put32(target); put32(id); }
+static void APIENTRY trace_glEndQuery(GLenum target) { real_glEndQuery(target); putCall(CALL_END_QUERY); put32(target); }
+static void APIENTRY trace_glQueryCounter(GLuint id, GLenum target) { real_glQueryCounter(id, target); putCall(CALL_QUERY_COUNTER); put32(id); put32(target); }
+static void APIENTRY trace_glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params)
+{
+	real_glGetQueryObjectiv(id, pname, params);
+	putCall(CALL_GET_QUERY_OBJECTIV); put32(id); put32(pname);
+}
+static void APIENTRY trace_glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+	real_glGetQueryObjectui64v(id, pname, params);
+	putCall(CALL_GET_QUERY_OBJECTUI64V); put32(id); put32(pname);
+}
+static GLsync APIENTRY trace_glFenceSync(GLenum condition, GLbitfield flags)
+{
+	GLsync sync = real_glFenceSync(condition, flags);
+	putCall(CALL_FENCE_SYNC); put32(condition); put32(flags); put64((uint64_t)(size_t)sync);
+	return sync;
+}
+static void APIENTRY trace_glDeleteSync(GLsync sync) { real_glDeleteSync(sync); putCall(CALL_DELETE_SYNC); put64((uint64_t)(size_t)sync); }
+static GLenum APIENTRY trace_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+	GLenum result = real_glClientWaitSync(sync, flags, timeout);
+	putCall(CALL_CLIENT_WAIT_SYNC); put64((uint64_t)(size_t)sync); put32(flags); put64(timeout);
+	return result;
+}
+static void APIENTRY trace_glGetSynciv(GLsync sync, GLenum pname, GLsizei count, GLsizei* length, GLint* values)
+{
+	real_glGetSynciv(sync, pname, count, length, values);
+	putCall(CALL_GET_SYNCIV); put64((uint64_t)(size_t)sync); put32(pname);
+}
+
+// KHR_debug
+TRACE_REAL_EXT(glPushDebugGroup);
+TRACE_REAL_EXT(glPopDebugGroup);
+
+static void APIENTRY trace_glPushDebugGroup(GLenum source, GLuint id, GLsizei length, const GLchar* message)
+{
+	real_glPushDebugGroup(source, id, length, message);
+	putCall(CALL_PUSH_DEBUG_GROUP); put32(source); put32(id); putString(message, length);
+}
+static void APIENTRY trace_glPopDebugGroup() { real_glPopDebugGroup(); putCall(CALL_POP_DEBUG_GROUP); }
+
+// Loader table: wrapper & where the real function goes (signatures are checked against glad's pointers)
+struct TraceProc {
+	const char* name;
+	void* proc;
+	void** real;
+};
+
+#define TRACE_PROC(name) { #name, (void*)static_cast<decltype(glad_##name)>(trace_##name), (void**)&real_##name }
+#define TRACE_PROC_EXT(name) { #name, (void*)static_cast<decltype(glext_##name)>(trace_##name), (void**)&real_##name }
+
+static const TraceProc procs[] = {
+	TRACE_PROC(glGetIntegerv), TRACE_PROC(glGetStringi),
+
+	TRACE_PROC(glActiveTexture), TRACE_PROC(glBlendFunc), TRACE_PROC(glColorMask), TRACE_PROC(glCullFace),
+	TRACE_PROC(glDepthFunc), TRACE_PROC(glDepthMask), TRACE_PROC(glDisable), TRACE_PROC(glEnable),
+	TRACE_PROC(glPixelStorei), TRACE_PROC(glPolygonMode), TRACE_PROC(glViewport), TRACE_PROC(glClearColor),
+	TRACE_PROC(glClear),
+
+	TRACE_PROC(glGenBuffers), TRACE_PROC(glDeleteBuffers), TRACE_PROC(glBindBuffer), TRACE_PROC(glBindBufferBase),
+	TRACE_PROC(glBindBufferRange), TRACE_PROC(glBufferData), TRACE_PROC(glBufferSubData), TRACE_PROC(glMapBufferRange),
+	TRACE_PROC(glFlushMappedBufferRange), TRACE_PROC(glUnmapBuffer),
+
+	TRACE_PROC(glGenVertexArrays), TRACE_PROC(glDeleteVertexArrays), TRACE_PROC(glBindVertexArray),
+	TRACE_PROC(glEnableVertexAttribArray), TRACE_PROC(glVertexAttribPointer),
+
+	TRACE_PROC(glGenTextures), TRACE_PROC(glDeleteTextures), TRACE_PROC(glBindTexture), TRACE_PROC(glTexParameteri),
+	TRACE_PROC(glTexParameterf), TRACE_PROC(glTexImage2D), TRACE_PROC(glTexImage3D), TRACE_PROC(glTexSubImage3D),
+	TRACE_PROC(glTexBuffer), TRACE_PROC(glGenerateMipmap), TRACE_PROC(glGenSamplers), TRACE_PROC(glDeleteSamplers),
+	TRACE_PROC(glBindSampler), TRACE_PROC(glSamplerParameteri),
+
+	TRACE_PROC(glCreateShader), TRACE_PROC(glDeleteShader), TRACE_PROC(glShaderSource), TRACE_PROC(glCompileShader),
+	TRACE_PROC(glCreateProgram), TRACE_PROC(glDeleteProgram), TRACE_PROC(glAttachShader), TRACE_PROC(glLinkProgram),
+	TRACE_PROC(glUseProgram), TRACE_PROC(glGetUniformLocation), TRACE_PROC(glGetUniformBlockIndex),
+	TRACE_PROC(glUniformBlockBinding),
+
+	TRACE_PROC(glUniform1i), TRACE_PROC(glUniform1f), TRACE_PROC(glUniform2f), TRACE_PROC(glUniform3f),
+	TRACE_PROC(glUniform4f), TRACE_PROC(glUniform2fv), TRACE_PROC(glUniform3fv), TRACE_PROC(glUniform4fv),
+	TRACE_PROC(glUniformMatrix2fv), TRACE_PROC(glUniformMatrix3fv), TRACE_PROC(glUniformMatrix4fv),
+
+	TRACE_PROC(glDrawElements),
+
+	TRACE_PROC(glGenFramebuffers), TRACE_PROC(glDeleteFramebuffers), TRACE_PROC(glBindFramebuffer),
+	TRACE_PROC(glGenRenderbuffers), TRACE_PROC(glDeleteRenderbuffers), TRACE_PROC(glBindRenderbuffer),
+	TRACE_PROC(glRenderbufferStorage), TRACE_PROC(glFramebufferRenderbuffer), TRACE_PROC(glReadPixels),
+
+	TRACE_PROC(glGenQueries), TRACE_PROC(glDeleteQueries), TRACE_PROC(glBeginQuery), TRACE_PROC(glEndQuery),
+	TRACE_PROC(glQueryCounter), TRACE_PROC(glGetQueryObjectiv), TRACE_PROC(glGetQueryObjectui64v),
+	TRACE_PROC(glFenceSync), TRACE_PROC(glDeleteSync), TRACE_PROC(glClientWaitSync), TRACE_PROC(glGetSynciv),
+
+	TRACE_PROC_EXT(glPushDebugGroup), TRACE_PROC_EXT(glPopDebugGroup)
+};
+
+// Wrapper of traced functions, real one of the rest (getters)
+static void* getProcAddress(const char* name)
+{
+	void* real = capture.loader(name);
+	for (const TraceProc& proc : procs) {
+		if (strcmp(proc.name, name) != 0) continue;
+		*proc.real = real;
+		return real != nullptr ? proc.proc : nullptr;
+	}
+	return real;
+}
+
+bool GLTrace::open(const std::string& path)
+{
+	capture.file.open(path, std::ios::binary | std::ios::trunc);
+	if (!capture.file.is_open()) {
+		std::cout << "ERROR: can't write trace " << path << std::endl;
+		return false;
+	}
+	put(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	capture.capturing = true;
+	capture.calls = 0;
+	capture.frames = 0;
+	return true;
+}
+
+GLADloadproc GLTrace::wrapLoader(GLADloadproc loader)
+{
+	capture.loader = loader;
+	return getProcAddress;
+}
+
+void GLTrace::endFrame(bool measured)
+{
+	if (!capture.capturing) return;
+	putCall(CALL_FRAME);
+	put32(measured ? 1 : 0);
+	capture.frames++;
+}
+
+void GLTrace::close()
+{
+	if (!capture.capturing) return;
+
+	size_t bytes = (size_t)capture.file.tellp();
+	capture.file.close();
+	capture.capturing = false;
+	std::cout << "GL trace: " << capture.frames << " frames, " << capture.calls << " calls, "
+		<< bytes / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+bool GLTrace::isCapturing()
+{
+	return capture.capturing;
+}
+
+// Replay
+
+struct TraceReader {
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+	bool ok = true;
+
+	void read(void* out, size_t bytes)
+	{
+		if (!ok || pos + bytes > size) {
+			ok = false;
+			memset(out, 0, bytes);
+			return;
+		}
+		memcpy(out, data + pos, bytes);
+		pos += bytes;
+	}
+	uint16_t u16() { uint16_t v; read(&v, sizeof(v)); return v; }
+	uint32_t u32() { uint32_t v; read(&v, sizeof(v)); return v; }
+	int32_t i32() { return (int32_t)u32(); }
+	uint64_t u64() { uint64_t v; read(&v, sizeof(v)); return v; }
+	float f32() { float v; read(&v, sizeof(v)); return v; }
+
+	// nullptr for blob of nullptr (or truncated file)
+	const unsigned char* blob(size_t& bytes)
+	{
+		uint64_t length = u64();
+		bytes = 0;
+		if (!ok || length == NO_DATA) return nullptr;
+		if (pos + length > size) {
+			ok = false;
+			return nullptr;
+		}
+		const unsigned char* blob = data + pos;
+		pos += (size_t)length;
+		bytes = (size_t)length;
+		return blob;
+	}
+	std::string string()
+	{
+		size_t bytes;
+		const unsigned char* text = blob(bytes);
+		return text != nullptr ? std::string((const char*)text, bytes) : std::string();
+	}
+	const GLfloat* floats(size_t count)
+	{
+		if (!ok || pos + count * sizeof(GLfloat) > size) {
+			ok = false;
+			return nullptr;
+		}
+		const GLfloat* values = (const GLfloat*)(data + pos); // unaligned reads are fine on supported platforms
+		pos += count * sizeof(GLfloat);
+		return values;
+	}
+};
+
+// Object names of trace -> names of replay
+enum TraceObject {
+	TRACE_BUFFER,
+	TRACE_TEXTURE,
+	TRACE_VERTEX_ARRAY,
+	TRACE_SAMPLER,
+	TRACE_SHADER,
+	TRACE_PROGRAM,
+	TRACE_QUERY,
+	TRACE_FRAMEBUFFER,
+	TRACE_RENDERBUFFER,
+	TRACE_OBJECT_COUNT
+};
+
+struct TraceReplay {
+	std::unordered_map<GLuint, GLuint> objects[TRACE_OBJECT_COUNT];
+	std::map<std::pair<GLuint, GLint>, GLint> locations; // by (program, location) of trace
+	std::map<std::pair<GLuint, GLuint>, GLuint> block_indices;
+	std::unordered_map<uint64_t, GLsync> syncs;
+	std::map<GLenum, unsigned char*> mappings; // by target
+	GLuint program = 0; // in use, trace name
+	size_t missing = 0; // names not created by the trace
+
+	GLuint get(TraceObject kind, GLuint name)
+	{
+		if (name == 0) return 0;
+		auto it = objects[kind].find(name);
+		if (it != objects[kind].end()) return it->second;
+		missing++;
+		return 0;
+	}
+
+	GLint location(GLint location)
+	{
+		if (location < 0) return location;
+		auto it = locations.find(std::make_pair(program, location));
+		return it != locations.end() ? it->second : -1;
+	}
+
+	GLsync sync(uint64_t handle)
+	{
+		auto it = syncs.find(handle);
+		return it != syncs.end() ? it->second : 0;
+	}
+};
+
+static void replayGen(TraceReader& in, TraceReplay& replay, TraceObject kind, void (APIENTRYP gen)(GLsizei, GLuint*))
+{
+	GLsizei n = in.u32();
+	std::vector<GLuint> names(n), created(n);
+	in.read(names.data(), sizeof(GLuint) * n);
+	gen(n, created.data());
+	for (GLsizei i = 0; i < n; ++i) replay.objects[kind][names[i]] = created[i];
+}
+
+static void replayDelete(TraceReader& in, TraceReplay& replay, TraceObject kind, void (APIENTRYP del)(GLsizei, const GLuint*))
+{
+	GLsizei n = in.u32();
+	std::vector<GLuint> names(n), deleted(n);
+	in.read(names.data(), sizeof(GLuint) * n);
+	for (GLsizei i = 0; i < n; ++i) {
+		deleted[i] = replay.get(kind, names[i]);
+		replay.objects[kind].erase(names[i]);
+	}
+	del(n, deleted.data());
+}
+
+// One call, false - unknown call
+static bool replayCall(TraceCall call, TraceReader& in, TraceReplay& replay, std::vector<unsigned char>& scratch)
+{
+	switch (call) {
+	// State
+	case CALL_ACTIVE_TEXTURE: glActiveTexture(in.u32()); break;
+	case CALL_BLEND_FUNC: { GLenum s = in.u32(); glBlendFunc(s, in.u32()); break; }
+	case CALL_COLOR_MASK: { GLboolean r = in.u32(), g = in.u32(), b = in.u32(), a = in.u32(); glColorMask(r, g, b, a); break; }
+	case CALL_CULL_FACE: glCullFace(in.u32()); break;
+	case CALL_DEPTH_FUNC: glDepthFunc(in.u32()); break;
+	case CALL_DEPTH_MASK: glDepthMask(in.u32()); break;
+	case CALL_DISABLE: glDisable(in.u32()); break;
+	case CALL_ENABLE: glEnable(in.u32()); break;
+	case CALL_PIXEL_STOREI: { GLenum pname = in.u32(); glPixelStorei(pname, in.i32()); break; }
+	case CALL_POLYGON_MODE: { GLenum face = in.u32(); glPolygonMode(face, in.u32()); break; }
+	case CALL_VIEWPORT: { GLint x = in.i32(), y = in.i32(); GLsizei w = in.i32(), h = in.i32(); glViewport(x, y, w, h); break; }
+	case CALL_CLEAR_COLOR: { float r = in.f32(), g = in.f32(), b = in.f32(), a = in.f32(); glClearColor(r, g, b, a); break; }
+	case CALL_CLEAR: glClear(in.u32()); break;
+
+	// Buffers
+	case CALL_GEN_BUFFERS: replayGen(in, replay, TRACE_BUFFER, glGenBuffers); break;
+	case CALL_DELETE_BUFFERS: replayDelete(in, replay, TRACE_BUFFER, glDeleteBuffers); break;
+	case CALL_BIND_BUFFER: { GLenum target = in.u32(); glBindBuffer(target, replay.get(TRACE_BUFFER, in.u32())); break; }
+	case CALL_BIND_BUFFER_BASE: {
+		GLenum target = in.u32(); GLuint index = in.u32(); GLuint buffer = replay.get(TRACE_BUFFER, in.u32());
+		glBindBufferBase(target, index, buffer);
+		break;
+	}
+	case CALL_BIND_BUFFER_RANGE: {
+		GLenum target = in.u32(); GLuint index = in.u32(); GLuint buffer = replay.get(TRACE_BUFFER, in.u32());
+		GLintptr offset = (GLintptr)in.u64(); GLsizeiptr size = (GLsizeiptr)in.u64();
+		glBindBufferRange(target, index, buffer, offset, size);
+		break;
+	}
+	case CALL_BUFFER_DATA: {
+		GLenum target = in.u32(); GLsizeiptr size = (GLsizeiptr)in.u64();
+		size_t bytes; const unsigned char* data = in.blob(bytes);
+		glBufferData(target, size, data, in.u32());
+		break;
+	}
+	case CALL_BUFFER_SUB_DATA: {
+		GLenum target = in.u32(); GLintptr offset = (GLintptr)in.u64();
+		size_t bytes; const unsigned char* data = in.blob(bytes);
+		glBufferSubData(target, offset, bytes, data);
+		break;
+	}
+	case CALL_MAP_BUFFER_RANGE: {
+		GLenum target = in.u32(); GLintptr offset = (GLintptr)in.u64(); GLsizeiptr length = (GLsizeiptr)in.u64(); GLbitfield access = in.u32();
+		replay.mappings[target] = (unsigned char*)glMapBufferRange(target, offset, length, access);
+		break;
+	}
+	case CALL_FLUSH_MAPPED_BUFFER_RANGE: {
+		GLenum target = in.u32(); GLintptr offset = (GLintptr)in.u64();
+		size_t bytes; const unsigned char* data = in.blob(bytes);
+		unsigned char* mapped = replay.mappings[target];
+		if (mapped != nullptr && data != nullptr) memcpy(mapped + offset, data, bytes);
+		glFlushMappedBufferRange(target, offset, bytes);
+		break;
+	}
+	case CALL_UNMAP_BUFFER: {
+		GLenum target = in.u32();
+		size_t bytes; const unsigned char* data = in.blob(bytes);
+		unsigned char* mapped = replay.mappings[target];
+		if (mapped != nullptr && data != nullptr) memcpy(mapped, data, bytes);
+		replay.mappings[target] = nullptr;
+		glUnmapBuffer(target);
+		break;
+	}
+
+	// Vertex arrays
+	case CALL_GEN_VERTEX_ARRAYS: replayGen(in, replay, TRACE_VERTEX_ARRAY, glGenVertexArrays); break;
+	case CALL_DELETE_VERTEX_ARRAYS: replayDelete(in, replay, TRACE_VERTEX_ARRAY, glDeleteVertexArrays); break;
+	case CALL_BIND_VERTEX_ARRAY: glBindVertexArray(replay.get(TRACE_VERTEX_ARRAY, in.u32())); break;
+	case CALL_ENABLE_VERTEX_ATTRIB_ARRAY: glEnableVertexAttribArray(in.u32()); break;
+	case CALL_VERTEX_ATTRIB_POINTER: {
+		GLuint index = in.u32(); GLint size = in.i32(); GLenum type = in.u32(); GLboolean normalized = in.u32(); GLsizei stride = in.i32();
+		glVertexAttribPointer(index, size, type, normalized, stride, (const void*)(size_t)in.u64());
+		break;
+	}
+
+	// Textures & samplers
+	case CALL_GEN_TEXTURES: replayGen(in, replay, TRACE_TEXTURE, glGenTextures); break;
+	case CALL_DELETE_TEXTURES: replayDelete(in, replay, TRACE_TEXTURE, glDeleteTextures); break;
+	case CALL_BIND_TEXTURE: { GLenum target = in.u32(); glBindTexture(target, replay.get(TRACE_TEXTURE, in.u32())); break; }
+	case CALL_TEX_PARAMETERI: { GLenum target = in.u32(), pname = in.u32(); glTexParameteri(target, pname, in.i32()); break; }
+	case CALL_TEX_PARAMETERF: { GLenum target = in.u32(), pname = in.u32(); glTexParameterf(target, pname, in.f32()); break; }
+	case CALL_TEX_IMAGE_2D: {
+		GLenum target = in.u32(); GLint level = in.i32(), internalformat = in.i32(); GLsizei w = in.i32(), h = in.i32(); GLint border = in.i32();
+		GLenum format = in.u32(), type = in.u32();
+		size_t bytes; const unsigned char* pixels = in.blob(bytes);
+		glTexImage2D(target, level, internalformat, w, h, border, format, type, pixels);
+		break;
+	}
+	case CALL_TEX_IMAGE_3D: {
+		GLenum target = in.u32(); GLint level = in.i32(), internalformat = in.i32(); GLsizei w = in.i32(), h = in.i32(), d = in.i32();
+		GLint border = in.i32(); GLenum format = in.u32(), type = in.u32();
+		size_t bytes; const unsigned char* pixels = in.blob(bytes);
+		glTexImage3D(target, level, internalformat, w, h, d, border, format, type, pixels);
+		break;
+	}
+	case CALL_TEX_SUB_IMAGE_3D: {
+		GLenum target = in.u32(); GLint level = in.i32(), x = in.i32(), y = in.i32(), z = in.i32();
+		GLsizei w = in.i32(), h = in.i32(), d = in.i32(); GLenum format = in.u32(), type = in.u32();
+		size_t bytes; const unsigned char* pixels = in.blob(bytes);
+		glTexSubImage3D(target, level, x, y, z, w, h, d, format, type, pixels);
+		break;
+	}
+	case CALL_TEX_BUFFER: { GLenum target = in.u32(), format = in.u32(); glTexBuffer(target, format, replay.get(TRACE_BUFFER, in.u32())); break; }
+	case CALL_GENERATE_MIPMAP: glGenerateMipmap(in.u32()); break;
+	case CALL_GEN_SAMPLERS: replayGen(in, replay, TRACE_SAMPLER, glGenSamplers); break;
+	case CALL_DELETE_SAMPLERS: replayDelete(in, replay, TRACE_SAMPLER, glDeleteSamplers); break;
+	case CALL_BIND_SAMPLER: { GLuint unit = in.u32(); glBindSampler(unit, replay.get(TRACE_SAMPLER, in.u32())); break; }
+	case CALL_SAMPLER_PARAMETERI: {
+		GLuint sampler = replay.get(TRACE_SAMPLER, in.u32()); GLenum pname = in.u32();
+		glSamplerParameteri(sampler, pname, in.i32());
+		break;
+	}
+
+	// Shaders & programs
+	case CALL_CREATE_SHADER: { GLenum type = in.u32(); replay.objects[TRACE_SHADER][in.u32()] = glCreateShader(type); break; }
+	case CALL_DELETE_SHADER: {
+		GLuint name = in.u32();
+		glDeleteShader(replay.get(TRACE_SHADER, name));
+		replay.objects[TRACE_SHADER].erase(name);
+		break;
+	}
+	case CALL_SHADER_SOURCE: {
+		GLuint shader = replay.get(TRACE_SHADER, in.u32()); GLsizei count = in.i32();
+		std::vector<std::string> sources(count);
+		std::vector<const GLchar*> strings(count);
+		for (GLsizei i = 0; i < count; ++i) {
+			sources[i] = in.string();
+			strings[i] = sources[i].c_str();
+		}
+		glShaderSource(shader, count, strings.data(), nullptr);
+		break;
+	}
+	case CALL_COMPILE_SHADER: glCompileShader(replay.get(TRACE_SHADER, in.u32())); break;
+	case CALL_CREATE_PROGRAM: replay.objects[TRACE_PROGRAM][in.u32()] = glCreateProgram(); break;
+	case CALL_DELETE_PROGRAM: {
+		GLuint name = in.u32();
+		glDeleteProgram(replay.get(TRACE_PROGRAM, name));
+		replay.objects[TRACE_PROGRAM].erase(name);
+		break;
+	}
+	case CALL_ATTACH_SHADER: {
+		GLuint program = replay.get(TRACE_PROGRAM, in.u32());
+		glAttachShader(program, replay.get(TRACE_SHADER, in.u32()));
+		break;
+	}
+	case CALL_LINK_PROGRAM: glLinkProgram(replay.get(TRACE_PROGRAM, in.u32())); break;
+	case CALL_USE_PROGRAM: replay.program = in.u32(); glUseProgram(replay.get(TRACE_PROGRAM, replay.program)); break;
+	case CALL_GET_UNIFORM_LOCATION: {
+		GLuint program = in.u32(); std::string name = in.string(); GLint location = in.i32();
+		if (location >= 0) replay.locations[std::make_pair(program, location)] = glGetUniformLocation(replay.get(TRACE_PROGRAM, program), name.c_str());
+		break;
+	}
+	case CALL_GET_UNIFORM_BLOCK_INDEX: {
+		GLuint program = in.u32(); std::string name = in.string(); GLuint index = in.u32();
+		replay.block_indices[std::make_pair(program, index)] = glGetUniformBlockIndex(replay.get(TRACE_PROGRAM, program), name.c_str());
+		break;
+	}
+	case CALL_UNIFORM_BLOCK_BINDING: {
+		GLuint program = in.u32(); GLuint index = in.u32(); GLuint binding = in.u32();
+		auto it = replay.block_indices.find(std::make_pair(program, index));
+		if (it != replay.block_indices.end() && it->second != GL_INVALID_INDEX)
+			glUniformBlockBinding(replay.get(TRACE_PROGRAM, program), it->second, binding);
+		break;
+	}
+
+	// Uniforms
+	case CALL_UNIFORM_1I: { GLint location = replay.location(in.i32()); glUniform1i(location, in.i32()); break; }
+	case CALL_UNIFORM_1F: { GLint location = replay.location(in.i32()); glUniform1f(location, in.f32()); break; }
+	case CALL_UNIFORM_2F: { GLint location = replay.location(in.i32()); float x = in.f32(), y = in.f32(); glUniform2f(location, x, y); break; }
+	case CALL_UNIFORM_3F: {
+		GLint location = replay.location(in.i32()); float x = in.f32(), y = in.f32(), z = in.f32();
+		glUniform3f(location, x, y, z);
+		break;
+	}
+	case CALL_UNIFORM_4F: {
+		GLint location = replay.location(in.i32()); float x = in.f32(), y = in.f32(), z = in.f32(), w = in.f32();
+		glUniform4f(location, x, y, z, w);
+		break;
+	}
+	case CALL_UNIFORM_2FV: { GLint location = replay.location(in.i32()); GLsizei count = in.i32(); glUniform2fv(location, count, in.floats(2 * count)); break; }
+	case CALL_UNIFORM_3FV: { GLint location = replay.location(in.i32()); GLsizei count = in.i32(); glUniform3fv(location, count, in.floats(3 * count)); break; }
+	case CALL_UNIFORM_4FV: { GLint location = replay.location(in.i32()); GLsizei count = in.i32(); glUniform4fv(location, count, in.floats(4 * count)); break; }
+	case CALL_UNIFORM_MATRIX_2FV: {
+		GLint location = replay.location(in.i32()); GLsizei count = in.i32(); const GLfloat* value = in.floats(4 * count);
+		glUniformMatrix2fv(location, count, in.u32(), value);
+		break;
+	}
+	case CALL_UNIFORM_MATRIX_3FV: {
+		GLint location = replay.location(in.i32()); GLsizei count = in.i32(); const GLfloat* value = in.floats(9 * count);
+		glUniformMatrix3fv(location, count, in.u32(), value);
+		break;
+	}
+	case CALL_UNIFORM_MATRIX_4FV: {
+		GLint location = replay.location(in.i32()); GLsizei count = in.i32(); const GLfloat* value = in.floats(16 * count);
+		glUniformMatrix4fv(location, count, in.u32(), value);
+		break;
+	}
+
+	// Draws
+	case CALL_DRAW_ELEMENTS: {
+		GLenum mode = in.u32(); GLsizei count = in.i32(); GLenum type = in.u32();
+		glDrawElements(mode, count, type, (const void*)(size_t)in.u64());
+		break;
+	}
+
+	// Framebuffers
+	case CALL_GEN_FRAMEBUFFERS: replayGen(in, replay, TRACE_FRAMEBUFFER, glGenFramebuffers); break;
+	case CALL_DELETE_FRAMEBUFFERS: replayDelete(in, replay, TRACE_FRAMEBUFFER, glDeleteFramebuffers); break;
+	case CALL_BIND_FRAMEBUFFER: { GLenum target = in.u32(); glBindFramebuffer(target, replay.get(TRACE_FRAMEBUFFER, in.u32())); break; }
+	case CALL_GEN_RENDERBUFFERS: replayGen(in, replay, TRACE_RENDERBUFFER, glGenRenderbuffers); break;
+	case CALL_DELETE_RENDERBUFFERS: replayDelete(in, replay, TRACE_RENDERBUFFER, glDeleteRenderbuffers); break;
+	case CALL_BIND_RENDERBUFFER: { GLenum target = in.u32(); glBindRenderbuffer(target, replay.get(TRACE_RENDERBUFFER, in.u32())); break; }
+	case CALL_RENDERBUFFER_STORAGE: {
+		GLenum target = in.u32(), format = in.u32(); GLsizei w = in.i32(), h = in.i32();
+		glRenderbufferStorage(target, format, w, h);
+		break;
+	}
+	case CALL_FRAMEBUFFER_RENDERBUFFER: {
+		GLenum target = in.u32(), attachment = in.u32(), renderbuffer_target = in.u32();
+		glFramebufferRenderbuffer(target, attachment, renderbuffer_target, replay.get(TRACE_RENDERBUFFER, in.u32()));
+		break;
+	}
+	case CALL_READ_PIXELS: {
+		GLint x = in.i32(), y = in.i32(); GLsizei w = in.i32(), h = in.i32(); GLenum format = in.u32(), type = in.u32();
+		bool pack_buffer = in.u32() != 0; uint64_t offset = in.u64();
+		void* pixels = (void*)(size_t)offset;
+		if (!pack_buffer) {
+			scratch.resize(std::max(scratch.size(), getImageSize(w, h, 1, format, type, 8) + 8));
+			pixels = scratch.data();
+		}
+		glReadPixels(x, y, w, h, format, type, pixels);
+		break;
+	}
+
+	// Queries & syncs
+	case CALL_GEN_QUERIES: replayGen(in, replay, TRACE_QUERY, glGenQueries); break;
+	case CALL_DELETE_QUERIES: replayDelete(in, replay, TRACE_QUERY, glDeleteQueries); break;
+	case CALL_BEGIN_QUERY: { GLenum target = in.u32(); glBeginQuery(target, replay.get(TRACE_QUERY, in.u32())); break; }
+	case CALL_END_QUERY: glEndQuery(in.u32()); break;
+	case CALL_QUERY_COUNTER: { GLuint id = replay.get(TRACE_QUERY, in.u32()); glQueryCounter(id, in.u32()); break; }
+	case CALL_GET_QUERY_OBJECTIV: {
+		GLuint id = replay.get(TRACE_QUERY, in.u32()); GLint value;
+		glGetQueryObjectiv(id, in.u32(), &value);
+		break;
+	}
+	case CALL_GET_QUERY_OBJECTUI64V: {
+		GLuint id = replay.get(TRACE_QUERY, in.u32()); GLuint64 value;
+		glGetQueryObjectui64v(id, in.u32(), &value);
+		break;
+	}
+	case CALL_FENCE_SYNC: {
+		GLenum condition = in.u32(); GLbitfield flags = in.u32();
+		replay.syncs[in.u64()] = glFenceSync(condition, flags);
+		break;
+	}
+	case CALL_DELETE_SYNC: {
+		uint64_t handle = in.u64();
+		glDeleteSync(replay.sync(handle));
+		replay.syncs.erase(handle);
+		break;
+	}
+	case CALL_CLIENT_WAIT_SYNC: {
+		GLsync sync = replay.sync(in.u64()); GLbitfield flags = in.u32(); GLuint64 timeout = in.u64();
+		if (sync != 0) glClientWaitSync(sync, flags, timeout);
+		break;
+	}
+	case CALL_GET_SYNCIV: {
+		GLsync sync = replay.sync(in.u64()); GLenum pname = in.u32(); GLint value; GLsizei length;
+		if (sync != 0) glGetSynciv(sync, pname, 1, &length, &value);
+		break;
+	}
+
+	// KHR_debug (skipped when replay context doesn't have it)
+	case CALL_PUSH_DEBUG_GROUP: {
+		GLenum source = in.u32(); GLuint id = in.u32(); std::string message = in.string();
+		if (getGLExtensions().debug_groups) glPushDebugGroup(source, id, (GLsizei)message.size(), message.c_str());
+		break;
+	}
+	case CALL_POP_DEBUG_GROUP: if (getGLExtensions().debug_groups) glPopDebugGroup(); break;
+
+	default: return false;
+	}
+	return true;
+}
+
+bool GLTrace::replay(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "ERROR: can't read trace " << path << std::endl;
+		return false;
+	}
+	// whole trace in memory, so timing doesn't include file reads
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	TraceReader in;
+	in.data = data.data();
+	in.size = data.size();
+	char magic[sizeof(TRACE_MAGIC)];
+	in.read(magic, sizeof(magic));
+	if (!in.ok || memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+		std::cout << "ERROR: " << path << " is not a GL trace (or other version)" << std::endl;
+		return false;
+	}
+
+	TraceReplay replay;
+	std::vector<unsigned char> scratch;
+
+	// timestamp after every frame (gpu time between frame ends), cpu time of submitting the frame's calls
+	std::vector<GLuint> timestamps;
+	std::vector<bool> measured;
+	std::vector<double> cpu_ms;
+	size_t calls = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto frame_start = start;
+	GLuint query;
+	glGenQueries(1, &query);
+	glQueryCounter(query, GL_TIMESTAMP);
+	timestamps.push_back(query);
+
+	while (in.ok && in.pos < in.size) {
+		TraceCall call = (TraceCall)in.u16();
+		if (call == CALL_FRAME) {
+			measured.push_back(in.u32() != 0);
+			auto now = std::chrono::steady_clock::now();
+			cpu_ms.push_back(std::chrono::duration<double, std::milli>(now - frame_start).count());
+
+			glGenQueries(1, &query);
+			glQueryCounter(query, GL_TIMESTAMP);
+			timestamps.push_back(query);
+			frame_start = std::chrono::steady_clock::now(); // without query calls
+			continue;
+		}
+
+		if (!replayCall(call, in, replay, scratch)) {
+			std::cout << "ERROR: unknown call " << call << " in trace at byte " << in.pos << std::endl;
+			in.ok = false;
+			break;
+		}
+		calls++;
+	}
+	glFinish();
+	double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (!in.ok) std::cout << "WARN: trace is truncated or broken, replayed " << calls << " calls" << std::endl;
+	if (replay.missing > 0) std::cout << "WARN: " << replay.missing << " object names used before creation" << std::endl;
+
+	// measured frames only (loading frames are replayed, not timed)
+	std::vector<double> cpu, gpu;
+	for (size_t i = 0; i < measured.size(); ++i) {
+		if (!measured[i]) continue;
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(timestamps[i], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(timestamps[i + 1], GL_QUERY_RESULT, &end);
+		cpu.push_back(cpu_ms[i]);
+		gpu.push_back((end - begin) / 1e6);
+	}
+	glDeleteQueries((GLsizei)timestamps.size(), timestamps.data());
+
+	std::cout << "Replay " << path << ": " << measured.size() << " frames (" << cpu.size() << " measured), "
+		<< calls << " calls, " << total_ms << " ms total" << std::endl;
+	if (!cpu.empty()) {
+		BenchmarkTimes cpu_times = Benchmark::getTimes(cpu);
+		BenchmarkTimes gpu_times = Benchmark::getTimes(gpu);
+		std::cout << "  cpu ms   mean " << cpu_times.mean << ", p50 " << cpu_times.p50 << ", p90 " << cpu_times.p90
+			<< ", p99 " << cpu_times.p99 << ", max " << cpu_times.max << std::endl;
+		std::cout << "  gpu ms   mean " << gpu_times.mean << ", p50 " << gpu_times.p50 << ", p90 " << gpu_times.p90
+			<< ", p99 " << gpu_times.p99 << ", max " << gpu_times.max << std::endl;
+	}
+	return in.ok;
+}
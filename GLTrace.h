@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+
+
+/*
+	GL call trace: the complete GL command stream of a run in a binary file,
+	replayed later (headless) with timing - same workload for comparing drivers & builds,
+	independent of scene loading code.
+
+	Capture wraps a context's loader (wrapLoader, before glad is loaded), so every call
+	is written with its payload: buffer & texture data, data written into mapped buffers
+	(at flush / unmap), shader sources, uniform names. endFrame() marks frames, measured ones
+	(after loading) are the ones replay times.
+	Trace reports GL 3.3 with GL_KHR_debug only, so the renderer takes paths whose data goes
+	through GL calls (no persistent mapping, program binaries, bindless textures).
+	Getters which don't change GL state (glGetShaderiv, glGetString, ...) aren't recorded.
+
+	Replay maps object ids, uniform locations & syncs of the trace to new ones,
+	timing: cpu time of submitting each frame, gpu time between frame ends (GL_TIMESTAMP).
+
+	File: "GLTRACE" + version byte, then calls: u16 call id, arguments (u32, u64, f32, sized blobs).
+	GL thread only.
+*/
+
+class GLTrace
+{
+public:
+	// Capture
+	static bool open(const std::string& path);
+	static GLADloadproc wrapLoader(GLADloadproc loader); // for gladLoadGLLoader & loadGLExtensions
+	static void endFrame(bool measured);
+	static void close();
+	static bool isCapturing();
+
+	// Replay, context must be current & glad loaded. Prints timing of measured frames
+	static bool replay(const std::string& path);
+};
@@ -0,0 +1,220 @@
+#include "GpuProfiler.h"
+#include "GLExtensions.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+GpuProfiler::GpuProfiler()
+{
+}
+
+void GpuProfiler::init()
+{
+	debug_groups = getGLExtensions().debug_groups;
+}
+
+void GpuProfiler::cleanup()
+{
+	closeDump();
+	for (Frame& f : frames) {
+		if (!f.queries.empty()) glDeleteQueries((GLsizei)f.queries.size(), f.queries.data());
+		f = Frame();
+	}
+	active = false;
+	open_scopes.clear();
+}
+
+void GpuProfiler::setEnabled(bool enabled)
+{
+	// recording frame finishes first
+	enabled_next = enabled;
+	if (active || this->enabled == enabled) return;
+
+	this->enabled = enabled;
+	for (Frame& f : frames) f.pending = false; // results of earlier frames are dropped
+}
+
+bool GpuProfiler::isEnabled() const
+{
+	return enabled;
+}
+
+GLuint GpuProfiler::getQuery(Frame& f)
+{
+	if (f.used_queries == f.queries.size()) {
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		f.queries.push_back(query);
+	}
+	return f.queries[f.used_queries++];
+}
+
+// Frame
+void GpuProfiler::beginFrame()
+{
+	frame_number++;
+	if (!enabled) return;
+
+	frame = (frame + 1) % FRAMES;
+	Frame& f = frames[frame];
+	if (f.pending) readFrame(f);
+
+	f.scopes.clear();
+	f.used_queries = 0;
+	f.number = frame_number;
+	active = true;
+
+	begin("frame");
+}
+
+void GpuProfiler::endFrame()
+{
+	if (!active) return;
+
+	// scopes left open are closed with the frame
+	while (!open_scopes.empty()) end();
+
+	frames[frame].pending = true;
+	active = false;
+	setEnabled(enabled_next);
+}
+
+void GpuProfiler::begin(const std::string& name)
+{
+	if (!active) return;
+
+	Frame& f = frames[frame];
+	Scope scope;
+	scope.depth = (int)open_scopes.size();
+	if (scope.depth <= 1) scope.name = name;
+	else scope.name = f.scopes[open_scopes.back()].name + "/" + name;
+	scope.begin_query = getQuery(f);
+	scope.end_query = getQuery(f);
+
+	if (debug_groups) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name.c_str());
+	glQueryCounter(scope.begin_query, GL_TIMESTAMP);
+
+	open_scopes.push_back(f.scopes.size());
+	f.scopes.push_back(scope);
+}
+
+void GpuProfiler::end()
+{
+	if (!active || open_scopes.empty()) return;
+
+	Frame& f = frames[frame];
+	glQueryCounter(f.scopes[open_scopes.back()].end_query, GL_TIMESTAMP);
+	if (debug_groups) glPopDebugGroup();
+	open_scopes.pop_back();
+}
+
+void GpuProfiler::readFrame(Frame& f)
+{
+	f.pending = false;
+	if (f.scopes.empty()) return;
+
+	// frame scope ends last, when it's available all are
+	GLint available = 0;
+	glGetQueryObjectiv(f.scopes.front().end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) return;
+
+	results.resize(f.scopes.size());
+	for (size_t i = 0; i < f.scopes.size(); ++i) {
+		const Scope& scope = f.scopes[i];
+		GLuint64 t_begin = 0, t_end = 0;
+		glGetQueryObjectui64v(scope.begin_query, GL_QUERY_RESULT, &t_begin);
+		glGetQueryObjectui64v(scope.end_query, GL_QUERY_RESULT, &t_end);
+
+		GpuScopeResult& result = results[i];
+		result.name = scope.name;
+		result.depth = scope.depth;
+		result.ms = t_end > t_begin ? (double)(t_end - t_begin) / 1e6 : 0.0;
+
+		// same scope drawn more times (e.g. model in two passes) has separate entries, average is per name
+		Rolling& rolling = averages[scope.name];
+		rolling.sum -= rolling.values[rolling.next];
+		rolling.values[rolling.next] = result.ms;
+		rolling.sum += result.ms;
+		rolling.next = (rolling.next + 1) % AVERAGE_FRAMES;
+		if (rolling.count < AVERAGE_FRAMES) rolling.count++;
+		result.average_ms = rolling.sum / rolling.count;
+	}
+
+	if (dump.is_open()) writeDump(f);
+}
+
+// Results
+const std::vector<GpuScopeResult>& GpuProfiler::getResults() const
+{
+	return results;
+}
+
+double GpuProfiler::getAverage(const std::string& name) const
+{
+	auto it = averages.find(name);
+	if (it == averages.end() || it->second.count == 0) return 0.0;
+	return it->second.sum / it->second.count;
+}
+
+void GpuProfiler::report() const
+{
+	if (results.empty()) {
+		std::cout << "GPU profiler: no results yet" << (enabled ? "" : " (disabled)") << std::endl;
+		return;
+	}
+
+	std::cout << "GPU profiler (ms, average of " << AVERAGE_FRAMES << " frames):" << std::endl;
+	for (const GpuScopeResult& result : results) {
+		// indented by depth, so leaf name is enough
+		std::string leaf = result.name.substr(result.name.find_last_of('/') + 1);
+		std::cout << "  " << std::string(result.depth * 2, ' ') << std::left << std::setw(31 - result.depth * 2) << leaf
+			<< " " << std::right << std::fixed << std::setprecision(3) << result.average_ms << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+// Dump
+bool GpuProfiler::openDump(const std::string& path)
+{
+	closeDump();
+
+	dump.open(path, std::ios::trunc);
+	if (!dump) {
+		std::cout << "ERROR: can't open gpu profiler dump " << path << std::endl;
+		return false;
+	}
+	dump_json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	dump_first = true;
+	if (dump_json) dump << "[";
+	else dump << "frame,scope,depth,ms\n";
+	return true;
+}
+
+void GpuProfiler::closeDump()
+{
+	if (!dump.is_open()) return;
+
+	if (dump_json) dump << "\n]\n";
+	dump.close();
+}
+
+void GpuProfiler::writeDump(const Frame& f)
+{
+	if (dump_json) {
+		nlohmann::json json;
+		json["frame"] = f.number;
+		for (const GpuScopeResult& result : results) {
+			json["scopes"].push_back({ { "name", result.name }, { "depth", result.depth }, { "ms", result.ms } });
+		}
+		dump << (dump_first ? "\n" : ",\n") << json.dump();
+		dump_first = false;
+	}
+	else {
+		for (const GpuScopeResult& result : results) {
+			dump << f.number << "," << result.name << "," << result.depth << "," << result.ms << "\n";
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/*
+	GPU time of nested scopes (passes, per-model draws, ...).
+
+	Scopes are pairs of GL_TIMESTAMP queries, so they can nest (GL_TIME_ELAPSED can't)
+	and don't collide with PassQueries. Queries of a frame are read FRAMES frames later,
+	frames whose results aren't available by then are dropped (never waits for GPU).
+	Every scope is also a KHR_debug group, so frame captures show the same names.
+
+	Results: last resolved frame & rolling averages over AVERAGE_FRAMES frames,
+	optionally dumped per frame (csv, or json array when path ends with .json).
+
+	Frame: beginFrame -> (begin, end)... -> endFrame, scope names are joined by '/'.
+	Does nothing while disabled (enable takes effect at next beginFrame). GL thread only.
+*/
+
+struct GpuScopeResult {
+	std::string name;	// path below frame scope, e.g. "opaque/matilda"
+	int depth = 0;		// 0 - frame
+	double ms = 0.0;
+	double average_ms = 0.0;
+};
+
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+
+	void init();
+	void cleanup();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	void beginFrame(); // reads oldest frame
+	void endFrame();
+	void begin(const std::string& name);
+	void end();
+
+	const std::vector<GpuScopeResult>& getResults() const; // last resolved frame, in begin order
+	double getAverage(const std::string& name) const; // ms, 0 - unknown scope
+	void report() const; // averages to stdout
+
+	bool openDump(const std::string& path);
+	void closeDump();
+
+public:
+	static const int FRAMES = 4;
+	static const int AVERAGE_FRAMES = 60;
+
+private:
+	struct Scope {
+		std::string name;
+		int depth = 0;
+		GLuint begin_query = 0;
+		GLuint end_query = 0;
+	};
+
+	struct Frame {
+		std::vector<Scope> scopes;
+		std::vector<GLuint> queries; // pool, grows with number of scopes
+		size_t used_queries = 0;
+		long long number = 0;
+		bool pending = false;
+	};
+
+	struct Rolling {
+		double values[AVERAGE_FRAMES] = {};
+		int count = 0;
+		int next = 0;
+		double sum = 0.0;
+	};
+
+	GLuint getQuery(Frame& frame);
+	void readFrame(Frame& frame);
+	void writeDump(const Frame& frame);
+
+private:
+	bool enabled = false;
+	bool enabled_next = false;
+	bool active = false; // frame is being recorded
+	bool debug_groups = false;
+
+	Frame frames[FRAMES];
+	int frame = 0;
+	long long frame_number = 0;
+
+	std::vector<size_t> open_scopes; // indices into current frame scopes
+	std::vector<GpuScopeResult> results;
+	std::map<std::string, Rolling> averages;
+
+	std::ofstream dump;
+	bool dump_json = false;
+	bool dump_first = true;
+};
+
+// Scope of the enclosing block
+class GpuScope
+{
+public:
+	GpuScope(GpuProfiler& profiler, const std::string& name) : profiler(profiler), enabled(profiler.isEnabled()) { if (enabled) profiler.begin(name); }
+	~GpuScope() { if (enabled) profiler.end(); }
+
+private:
+	GpuProfiler& profiler;
+	bool enabled;
+};
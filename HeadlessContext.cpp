@@ -0,0 +1,168 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+#include <cstring>
+
+#ifdef HEADLESS_EGL
+#include <EGL/eglext.h>
+#endif
+
+// display / glfw is shared by all contexts, terminated with the last one
+static int context_count = 0;
+
+HeadlessContext::HeadlessContext()
+{
+}
+
+#ifdef HEADLESS_EGL
+
+static bool hasEGLExtension(EGLDisplay display, const char* name)
+{
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	return extensions != nullptr && strstr(extensions, name) != nullptr;
+}
+
+bool HeadlessContext::create(int major, int minor)
+{
+	// surfaceless platform first, needs no display server
+	if (hasEGLExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint egl_major = 0, egl_minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &egl_major, &egl_minor)) {
+		std::cout << "ERROR: EGL display can't be initialized" << std::endl;
+		display = EGL_NO_DISPLAY;
+		return false;
+	}
+	context_count++;
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		std::cout << "ERROR: EGL has no desktop OpenGL" << std::endl;
+		destroy();
+		return false;
+	}
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	bool surfaceless = hasEGLExtension(display, "EGL_KHR_surfaceless_context") && hasEGLExtension(display, "EGL_KHR_no_config_context");
+	if (surfaceless) {
+		context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+	}
+	else {
+		// 1x1 pbuffer just to make context current, rendering goes to framebuffer objects
+		const EGLint config_attribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+			EGL_NONE
+		};
+		const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		EGLConfig config;
+		EGLint configs = 0;
+		if (eglChooseConfig(display, config_attribs, &config, 1, &configs) && configs > 0) {
+			surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+		}
+	}
+
+	if (context == EGL_NO_CONTEXT || (!surfaceless && surface == EGL_NO_SURFACE)) {
+		std::cout << "ERROR: EGL context " << major << "." << minor << " can't be created" << std::endl;
+		destroy();
+		return false;
+	}
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		std::cout << "ERROR: EGL context can't be made current" << std::endl;
+		destroy();
+		return false;
+	}
+
+	std::cout << "Headless EGL " << egl_major << "." << egl_minor << (surfaceless ? " (surfaceless)" : " (pbuffer)") << std::endl;
+	return true;
+}
+
+void HeadlessContext::destroy()
+{
+	if (display == EGL_NO_DISPLAY) return;
+
+	if (eglGetCurrentContext() == context) release();
+	if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+	if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+	if (--context_count == 0) eglTerminate(display);
+
+	display = EGL_NO_DISPLAY;
+	context = EGL_NO_CONTEXT;
+	surface = EGL_NO_SURFACE;
+}
+
+bool HeadlessContext::makeCurrent()
+{
+	return eglMakeCurrent(display, surface, surface, context) == EGL_TRUE;
+}
+
+void HeadlessContext::release()
+{
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+GLADloadproc HeadlessContext::getLoader() const
+{
+	return (GLADloadproc)eglGetProcAddress;
+}
+
+#else
+
+bool HeadlessContext::create(int major, int minor)
+{
+	if (!glfwInit()) {
+		std::cout << "ERROR: GLFW can't be initialized" << std::endl;
+		return false;
+	}
+	context_count++;
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	window = glfwCreateWindow(1, 1, "headless", NULL, NULL);
+	if (window == NULL) {
+		std::cout << "ERROR: hidden GLFW window " << major << "." << minor << " can't be created" << std::endl;
+		if (--context_count == 0) glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(window);
+	return true;
+}
+
+void HeadlessContext::destroy()
+{
+	if (window == nullptr) return;
+
+	glfwDestroyWindow(window);
+	window = nullptr;
+	if (--context_count == 0) glfwTerminate();
+}
+
+bool HeadlessContext::makeCurrent()
+{
+	glfwMakeContextCurrent(window);
+	return glfwGetCurrentContext() == window;
+}
+
+void HeadlessContext::release()
+{
+	glfwMakeContextCurrent(NULL);
+}
+
+GLADloadproc HeadlessContext::getLoader() const
+{
+	return (GLADloadproc)glfwGetProcAddress;
+}
+
+#endif
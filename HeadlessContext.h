@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifdef HEADLESS_EGL
+#include <EGL/egl.h>
+#endif
+
+
+/*
+	GL context without a window, for rendering into framebuffer objects (see RenderTarget).
+
+	Built with HEADLESS_EGL (link EGL): EGL surfaceless context (EGL_MESA_platform_surfaceless,
+	works on machines without display, e.g. Mesa llvmpipe), pbuffer of default display otherwise.
+	Without it: hidden GLFW window (still needs a desktop / display server).
+
+	Core profile of requested version. Context is current after create, more contexts can be created
+	for parallel rendering (one thread each, release here & makeCurrent there), objects aren't shared.
+	Create & destroy contexts on one thread.
+*/
+
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+
+	bool create(int major, int minor);
+	void destroy();
+
+	bool makeCurrent(); // on calling thread
+	void release(); // no context current on calling thread
+
+	GLADloadproc getLoader() const; // for gladLoadGLLoader & loadGLExtensions
+
+private:
+#ifdef HEADLESS_EGL
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	EGLSurface surface = EGL_NO_SURFACE; // pbuffer when surfaceless isn't supported
+#else
+	GLFWwindow* window = nullptr;
+#endif
+};
@@ -0,0 +1,479 @@
+#include "LoaderBenchmark.h"
+#include "MipChain.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "json.hpp"
+#include "tiny_gltf.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+static const char* stage_names[LOADER_STAGE_COUNT] = { "read", "json", "buffers", "gltf", "images", "vertices", "mips", "upload" };
+
+static const double MIN_REGRESSION_MS = 0.05; // differences below are noise
+
+static volatile float vertex_sink; // keeps vertex processing from being optimized away
+
+static bool isBinary(const std::string& path)
+{
+	return path.size() >= 4 && path.compare(path.size() - 4, 4, ".glb") == 0;
+}
+
+static bool isAsset(const std::string& name)
+{
+	return isBinary(name) || (name.size() >= 5 && name.compare(name.size() - 5, 5, ".gltf") == 0);
+}
+
+static std::vector<unsigned char> readFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Same as loader of GLTFModel: images stay encoded, decode is a stage of its own
+static bool storeImageAsIs(tinygltf::Image* image, const int, std::string*, std::string*,
+	int, int, const unsigned char* bytes, int size, void*)
+{
+	image->image.assign(bytes, bytes + size);
+	image->as_is = true;
+	return true;
+}
+
+// GLB: 12 byte header, JSON chunk, optional BIN chunk (chunk: u32 length, u32 type, data)
+static bool readGlbChunks(const std::vector<unsigned char>& file, const unsigned char*& json, size_t& json_size,
+	const unsigned char*& bin, size_t& bin_size)
+{
+	if (file.size() < 20 || memcmp(file.data(), "glTF", 4) != 0) return false;
+
+	uint32_t length, type;
+	memcpy(&length, &file[12], 4);
+	memcpy(&type, &file[16], 4);
+	if (type != 0x4E4F534A || 20 + (size_t)length > file.size()) return false; // "JSON"
+	json = &file[20];
+	json_size = length;
+
+	size_t bin_offset = 20 + (size_t)length;
+	if (bin_offset + 8 <= file.size()) {
+		memcpy(&length, &file[bin_offset], 4);
+		memcpy(&type, &file[bin_offset + 4], 4);
+		if (type == 0x004E4942 && bin_offset + 8 + length <= file.size()) { // "BIN"
+			bin = &file[bin_offset + 8];
+			bin_size = length;
+		}
+	}
+	return true;
+}
+
+// Position bounds & largest index of every primitive, every vertex & index is read once
+static size_t processVertices(const tinygltf::Model& model)
+{
+	size_t bytes = 0;
+	glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+	uint32_t max_index = 0;
+
+	for (const tinygltf::Mesh& mesh : model.meshes) {
+		for (const tinygltf::Primitive& primitive : mesh.primitives) {
+			auto attrib = primitive.attributes.find("POSITION");
+			if (attrib != primitive.attributes.end()) {
+				const tinygltf::Accessor& accessor = model.accessors[attrib->second];
+				if (accessor.bufferView >= 0 && accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && accessor.type == TINYGLTF_TYPE_VEC3) {
+					const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+					const std::vector<unsigned char>& data = model.buffers[view.buffer].data;
+					int stride = accessor.ByteStride(view);
+					size_t offset = view.byteOffset + accessor.byteOffset;
+					if (stride > 0 && accessor.count > 0 && offset + stride * (accessor.count - 1) + 12 <= data.size()) {
+						for (size_t i = 0; i < accessor.count; ++i) {
+							glm::vec3 p;
+							memcpy(&p, &data[offset + stride * i], 12);
+							min = glm::min(min, p);
+							max = glm::max(max, p);
+						}
+						bytes += accessor.count * 12;
+					}
+				}
+			}
+
+			if (primitive.indices < 0) continue;
+			const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
+			if (accessor.bufferView < 0) continue;
+			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+			const std::vector<unsigned char>& data = model.buffers[view.buffer].data;
+			int size = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+			size_t offset = view.byteOffset + accessor.byteOffset;
+			if (size <= 0 || offset + size * accessor.count > data.size()) continue;
+			for (size_t i = 0; i < accessor.count; ++i) {
+				uint32_t index = 0;
+				memcpy(&index, &data[offset + size * i], size); // little endian
+				max_index = std::max(max_index, index);
+			}
+			bytes += accessor.count * size;
+		}
+	}
+
+	vertex_sink = min.x + max.y + (float)max_index;
+	return bytes;
+}
+
+// Runs work (returns bytes it processed), measured iterations are recorded into stage
+template <typename Work>
+static void measure(LoaderStageResult& stage, bool measured, Work work)
+{
+	AllocationCount before = AllocationCounter::get();
+	auto start = std::chrono::steady_clock::now();
+	size_t bytes = work();
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	AllocationCount used = AllocationCounter::get() - before;
+	if (!measured) return;
+
+	stage.ms.push_back(ms);
+	stage.bytes = bytes;
+	stage.allocations.count += used.count;
+	stage.allocations.bytes += used.bytes;
+}
+
+LoaderBenchmark::LoaderBenchmark()
+{
+}
+
+static void listDir(const std::string& dir, std::vector<std::string>& paths)
+{
+#ifdef _WIN32
+	_finddata_t data;
+	intptr_t handle = _findfirst((dir + "/*").c_str(), &data);
+	if (handle == -1) return;
+	do {
+		std::string name = data.name;
+		if (name == "." || name == "..") continue;
+		std::string path = dir + "/" + name;
+		if (data.attrib & _A_SUBDIR) listDir(path, paths);
+		else if (isAsset(name)) paths.push_back(path);
+	} while (_findnext(handle, &data) == 0);
+	_findclose(handle);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (d == nullptr) return;
+	while (dirent* entry = readdir(d)) {
+		std::string name = entry->d_name;
+		if (name == "." || name == "..") continue;
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) continue;
+		if (S_ISDIR(st.st_mode)) listDir(path, paths);
+		else if (isAsset(name)) paths.push_back(path);
+	}
+	closedir(d);
+#endif
+}
+
+bool LoaderBenchmark::listAssets(const std::string& dir, std::vector<std::string>& paths)
+{
+	listDir(dir, paths);
+	std::sort(paths.begin(), paths.end());
+	return !paths.empty();
+}
+
+const char* LoaderBenchmark::getStageName(int stage)
+{
+	return stage >= 0 && stage < LOADER_STAGE_COUNT ? stage_names[stage] : "?";
+}
+
+bool LoaderBenchmark::run(const LoaderBenchmarkOptions& options)
+{
+	this->options = options;
+	results.clear();
+
+	std::vector<std::string> paths;
+	if (!listAssets(options.dir, paths)) {
+		std::cout << "ERROR: no .gltf / .glb files in " << options.dir << std::endl;
+		return false;
+	}
+	int iterations = std::max(options.iterations, 1);
+	std::cout << "Loader benchmark: " << paths.size() << " assets in " << options.dir << ", "
+		<< iterations << " iterations (+" << std::max(options.warmup, 0) << " warmup)"
+		<< (AllocationCounter::isEnabled() ? "" : ", allocations not counted (build with COUNT_ALLOCATIONS)") << std::endl;
+
+	// element array buffers are bound to a vao while uploading (core profile)
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	for (const std::string& path : paths) {
+		LoaderAssetResult asset;
+		asset.path = path;
+		asset.loaded = true;
+		for (int i = 0; i < std::max(options.warmup, 0) + iterations && asset.loaded; ++i) {
+			asset.loaded = runIteration(asset, i >= options.warmup);
+		}
+
+		for (LoaderStageResult& stage : asset.stages) {
+			size_t n = stage.ms.size();
+			if (n == 0) continue;
+			double sum = 0.0;
+			for (double ms : stage.ms) sum += ms;
+			stage.mean_ms = sum / n;
+			double variance = 0.0;
+			for (double ms : stage.ms) variance += (ms - stage.mean_ms) * (ms - stage.mean_ms);
+			stage.stddev_ms = n > 1 ? std::sqrt(variance / (n - 1)) : 0.0;
+			stage.bytes_per_s = stage.mean_ms > 0.0 ? stage.bytes / (stage.mean_ms / 1000.0) : 0.0;
+			stage.allocations.count /= n;
+			stage.allocations.bytes /= n;
+		}
+		results.push_back(asset);
+	}
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &vao);
+	return true;
+}
+
+bool LoaderBenchmark::runIteration(LoaderAssetResult& asset, bool measured)
+{
+	LoaderStageResult* stages = asset.stages;
+	const std::string& path = asset.path;
+	std::string base_dir = path.substr(0, path.find_last_of("/\\") + 1);
+	bool binary = isBinary(path);
+
+	std::vector<unsigned char> file;
+	measure(stages[LOADER_READ], measured, [&]() {
+		file = readFile(path);
+		return file.size();
+	});
+	if (file.empty()) {
+		std::cout << "ERROR: can't read " << path << std::endl;
+		return false;
+	}
+
+	// JSON is the whole file or first chunk of GLB
+	const unsigned char* json_data = file.data();
+	size_t json_size = file.size();
+	const unsigned char* bin_data = nullptr;
+	size_t bin_size = 0;
+	if (binary && !readGlbChunks(file, json_data, json_size, bin_data, bin_size)) {
+		std::cout << "ERROR: " << path << " is not a valid GLB" << std::endl;
+		return false;
+	}
+
+	nlohmann::json json;
+	measure(stages[LOADER_JSON], measured, [&]() {
+		json = nlohmann::json::parse(json_data, json_data + json_size, nullptr, false);
+		return json_size;
+	});
+	if (json.is_discarded()) {
+		std::cout << "ERROR: " << path << " has invalid JSON" << std::endl;
+		return false;
+	}
+
+	measure(stages[LOADER_BUFFERS], measured, [&]() {
+		size_t bytes = 0;
+		if (!json.contains("buffers")) return bytes;
+		for (auto& buffer : json["buffers"]) {
+			std::vector<unsigned char> data;
+			std::string uri = buffer.contains("uri") ? buffer["uri"].get<std::string>() : std::string();
+			size_t length = buffer.contains("byteLength") ? buffer["byteLength"].get<size_t>() : 0;
+			if (uri.empty()) data.assign(bin_data, bin_data + bin_size);
+			else if (tinygltf::IsDataURI(uri)) {
+				std::string mime_type;
+				tinygltf::DecodeDataURI(&data, mime_type, uri, length, true);
+			}
+			else data = readFile(base_dir + uri);
+			bytes += data.size();
+		}
+		return bytes;
+	});
+
+	tinygltf::Model model;
+	bool loaded = false;
+	std::string err;
+	measure(stages[LOADER_GLTF], measured, [&]() {
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(storeImageAsIs, nullptr);
+		std::string warn;
+		loaded = binary ? loader.LoadBinaryFromMemory(&model, &err, &warn, file.data(), (unsigned int)file.size(), base_dir)
+			: loader.LoadASCIIFromString(&model, &err, &warn, (const char*)file.data(), (unsigned int)file.size(), base_dir);
+		return file.size();
+	});
+	if (!loaded) {
+		while (!err.empty() && err.back() == '\n') err.pop_back();
+		std::cout << "ERROR: tinygltf can't load " << path << (err.empty() ? "" : ": " + err) << std::endl;
+		return false;
+	}
+
+	std::vector<tinygltf::Image> images(model.images.size());
+	measure(stages[LOADER_IMAGES], measured, [&]() {
+		size_t bytes = 0;
+		for (size_t i = 0; i < model.images.size(); ++i) {
+			const tinygltf::Image& encoded = model.images[i];
+			if (!encoded.as_is || encoded.image.empty()) continue;
+			std::string image_err, image_warn;
+			tinygltf::LoadImageData(&images[i], (int)i, &image_err, &image_warn, 0, 0, encoded.image.data(), (int)encoded.image.size(), nullptr);
+			bytes += encoded.image.size();
+		}
+		return bytes;
+	});
+
+	measure(stages[LOADER_VERTICES], measured, [&]() {
+		return processVertices(model);
+	});
+
+	measure(stages[LOADER_MIPS], measured, [&]() {
+		size_t bytes = 0;
+		for (const tinygltf::Image& image : images) {
+			if (image.image.empty()) continue;
+			MipChain chain;
+			chain.build(image);
+			bytes += image.image.size();
+		}
+		return bytes;
+	});
+
+	std::vector<GLuint> buffers, textures;
+	measure(stages[LOADER_UPLOAD], measured, [&]() {
+		size_t bytes = 0;
+		for (const tinygltf::BufferView& view : model.bufferViews) {
+			if (view.target == 0) continue; // images & other data
+			GLuint buffer;
+			glGenBuffers(1, &buffer);
+			glBindBuffer(view.target, buffer);
+			glBufferData(view.target, view.byteLength, model.buffers[view.buffer].data.data() + view.byteOffset, GL_STATIC_DRAW);
+			buffers.push_back(buffer);
+			bytes += view.byteLength;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (const tinygltf::Image& image : images) {
+			if (image.image.empty() || image.bits != 8) continue;
+			GLenum format = GL_RGBA, internal_format = GL_RGBA8;
+			if (image.component == 1) format = GL_RED, internal_format = GL_R8;
+			else if (image.component == 2) format = GL_RG, internal_format = GL_RG8;
+			else if (image.component == 3) format = GL_RGB, internal_format = GL_RGB8;
+
+			GLuint texture;
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, internal_format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.image.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			textures.push_back(texture);
+			bytes += image.image.size();
+		}
+		glFinish();
+		return bytes;
+	});
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures((GLsizei)textures.size(), textures.data());
+	glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+	return true;
+}
+
+void LoaderBenchmark::report() const
+{
+	// own stream, so cout formatting isn't changed
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(3);
+	for (const LoaderAssetResult& asset : results) {
+		out << asset.path << (asset.loaded ? "" : " (failed)") << "\n";
+		if (!asset.loaded) continue;
+
+		out << "  " << std::left << std::setw(10) << "stage" << std::right << std::setw(10) << "mean ms" << std::setw(9) << "stddev"
+			<< std::setw(9) << "MB" << std::setw(12) << "MB/s" << std::setw(9) << "allocs" << std::setw(10) << "alloc MB" << "\n";
+		double total_ms = 0.0;
+		for (int s = 0; s < LOADER_STAGE_COUNT; ++s) {
+			const LoaderStageResult& stage = asset.stages[s];
+			out << "  " << std::left << std::setw(10) << stage_names[s] << std::right
+				<< std::setw(10) << stage.mean_ms << std::setw(9) << stage.stddev_ms
+				<< std::setw(9) << stage.bytes / (1024.0 * 1024.0) << std::setw(12) << std::setprecision(1) << stage.bytes_per_s / (1024.0 * 1024.0)
+				<< std::setw(9) << stage.allocations.count << std::setw(10) << std::setprecision(3) << stage.allocations.bytes / (1024.0 * 1024.0) << "\n";
+			if (s != LOADER_JSON && s != LOADER_BUFFERS) total_ms += stage.mean_ms; // both are part of gltf
+		}
+		out << "  total " << total_ms << " ms (read, gltf, images, vertices, mips, upload)\n";
+	}
+	std::cout << out.str();
+}
+
+const std::vector<LoaderAssetResult>& LoaderBenchmark::getResults() const
+{
+	return results;
+}
+
+size_t LoaderBenchmark::getFailedCount() const
+{
+	size_t failed = 0;
+	for (const LoaderAssetResult& asset : results) {
+		if (!asset.loaded) failed++;
+	}
+	return failed;
+}
+
+bool LoaderBenchmark::writeBaseline(const std::string& path) const
+{
+	nlohmann::json json;
+	json["iterations"] = options.iterations;
+	json["assets"] = nlohmann::json::object();
+	for (const LoaderAssetResult& asset : results) {
+		if (!asset.loaded) continue;
+		nlohmann::json stages;
+		for (int s = 0; s < LOADER_STAGE_COUNT; ++s) {
+			stages[stage_names[s]] = { { "mean_ms", asset.stages[s].mean_ms }, { "stddev_ms", asset.stages[s].stddev_ms } };
+		}
+		json["assets"][asset.path] = stages;
+	}
+
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "ERROR: can't write loader baseline " << path << std::endl;
+		return false;
+	}
+	file << json.dump(4);
+	std::cout << "Loader baseline -> " << path << std::endl;
+	return true;
+}
+
+int LoaderBenchmark::compareBaseline(const std::string& path) const
+{
+	std::ifstream file(path);
+	nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+	if (!file || json.is_discarded() || !json.contains("assets")) {
+		std::cout << "ERROR: can't read loader baseline " << path << std::endl;
+		return -1;
+	}
+
+	// slower by threshold and by more than noise of both runs
+	int regressions = 0;
+	size_t compared = 0;
+	for (const LoaderAssetResult& asset : results) {
+		if (!asset.loaded || !json["assets"].contains(asset.path)) continue;
+		const nlohmann::json& stages = json["assets"][asset.path];
+		for (int s = 0; s < LOADER_STAGE_COUNT; ++s) {
+			if (!stages.contains(stage_names[s])) continue;
+			double base_mean = stages[stage_names[s]].value("mean_ms", 0.0);
+			double base_stddev = stages[stage_names[s]].value("stddev_ms", 0.0);
+			const LoaderStageResult& stage = asset.stages[s];
+			compared++;
+
+			double slower = stage.mean_ms - base_mean;
+			double noise = 2.0 * std::max(stage.stddev_ms, base_stddev);
+			if (slower > base_mean * options.regression_threshold && slower > noise && slower > MIN_REGRESSION_MS) {
+				std::cout << "REGRESSION: " << asset.path << " " << stage_names[s] << ": " << stage.mean_ms << " ms, baseline "
+					<< base_mean << " ms (+" << (base_mean > 0.0 ? slower / base_mean * 100.0 : 0.0) << "%)" << std::endl;
+				regressions++;
+			}
+		}
+	}
+	std::cout << "Loader baseline " << path << ": " << compared << " stages compared, " << regressions << " regressions" << std::endl;
+	return regressions;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AllocationCounter.h"
+
+#include <string>
+#include <vector>
+
+
+/*
+	Loader microbenchmark: where startup time of an asset goes. Every .gltf / .glb under a folder
+	is loaded stage by stage, each stage timed separately:
+		read		- file into memory
+		json		- JSON parse (same parser as tinygltf)
+		buffers		- external .bin reads, base64 data URIs (DecodeDataURI), GLB binary chunk
+		gltf		- complete tinygltf load (json, buffers, model structures), images kept encoded
+		images		- image decode (stb_image through tinygltf)
+		vertices	- accessor walk: position bounds & index range (what loader checks on cpu)
+		mips		- mip chains of decoded images (texture streaming)
+		upload		- buffer views & textures with mipmaps to GL, until glFinish (headless or null GL context)
+
+	Warmup iterations first (file cache), then measured ones: mean / stddev ms, MB/s of the stage's input,
+	allocations per iteration (COUNT_ALLOCATIONS builds, see AllocationCounter).
+	Results can be stored as baseline json and later runs compared to it, slower stages are reported as regressions.
+	GL thread, context must be current & glad loaded.
+*/
+
+enum LoaderStage {
+	LOADER_READ,
+	LOADER_JSON,
+	LOADER_BUFFERS,
+	LOADER_GLTF,
+	LOADER_IMAGES,
+	LOADER_VERTICES,
+	LOADER_MIPS,
+	LOADER_UPLOAD,
+	LOADER_STAGE_COUNT
+};
+
+struct LoaderStageResult {
+	std::vector<double> ms;			// per measured iteration
+	double mean_ms = 0.0;
+	double stddev_ms = 0.0;
+	size_t bytes = 0;				// stage input per iteration
+	double bytes_per_s = 0.0;
+	AllocationCount allocations;	// per iteration (mean)
+};
+
+struct LoaderAssetResult {
+	std::string path;
+	bool loaded = false;
+	LoaderStageResult stages[LOADER_STAGE_COUNT];
+};
+
+struct LoaderBenchmarkOptions {
+	std::string dir = "./models";
+	int iterations = 5;
+	int warmup = 1;
+	double regression_threshold = 0.10; // slower than baseline by this fraction (and by more than noise)
+};
+
+class LoaderBenchmark
+{
+public:
+	LoaderBenchmark();
+
+	bool run(const LoaderBenchmarkOptions& options); // false - no assets found
+	void report() const;
+	const std::vector<LoaderAssetResult>& getResults() const;
+	size_t getFailedCount() const; // assets which didn't load
+
+	// Baseline: mean & stddev per asset & stage
+	bool writeBaseline(const std::string& path) const;
+	int compareBaseline(const std::string& path) const; // regressions (printed), -1 - baseline can't be read
+
+	static bool listAssets(const std::string& dir, std::vector<std::string>& paths); // recursive, sorted
+	static const char* getStageName(int stage);
+
+private:
+	bool runIteration(LoaderAssetResult& asset, bool measured);
+
+private:
+	LoaderBenchmarkOptions options;
+	std::vector<LoaderAssetResult> results;
+};
@@ -0,0 +1,156 @@
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const char* category_names[MEMORY_CATEGORY_COUNT] = {
+	"cpu buffers", "cpu images", "cpu mips", "cpu metadata",
+	"gpu vertex", "gpu index", "gpu material", "gpu texture", "gpu mips"
+};
+
+static void grow(MemoryCounter& counter, size_t bytes, size_t blocks, size_t allocations)
+{
+	counter.current += bytes;
+	counter.blocks += blocks;
+	counter.allocations += allocations;
+	if (counter.current > counter.peak) counter.peak = counter.current;
+}
+
+static void shrink(MemoryCounter& counter, size_t bytes, size_t blocks)
+{
+	counter.current -= std::min(bytes, counter.current);
+	counter.blocks -= std::min(blocks, counter.blocks);
+}
+
+MemoryAccounting::MemoryAccounting()
+{
+	total.name = "total";
+}
+
+void MemoryAccounting::setName(const void* owner, const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	owners[owner].name = name;
+}
+
+void MemoryAccounting::retire(const void* owner)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = owners.find(owner);
+	if (it == owners.end()) return;
+
+	MemoryUsage& usage = it->second;
+	for (int c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+		MemoryCounter left = usage.categories[c];
+		remove(usage, (MemoryCategory)c, left.current, left.blocks);
+		remove(total, (MemoryCategory)c, left.current, left.blocks);
+	}
+	retired.push_back(usage);
+	owners.erase(it);
+}
+
+// Counters
+void MemoryAccounting::add(MemoryUsage& usage, MemoryCategory category, size_t bytes, size_t blocks, size_t allocations)
+{
+	grow(usage.categories[category], bytes, blocks, allocations);
+	grow(isGpu(category) ? usage.gpu : usage.cpu, bytes, blocks, allocations);
+}
+
+void MemoryAccounting::remove(MemoryUsage& usage, MemoryCategory category, size_t bytes, size_t blocks)
+{
+	shrink(usage.categories[category], bytes, blocks);
+	shrink(isGpu(category) ? usage.gpu : usage.cpu, bytes, blocks);
+}
+
+void MemoryAccounting::allocate(const void* owner, MemoryCategory category, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	add(owners[owner], category, bytes, 1, 1);
+	add(total, category, bytes, 1, 1);
+}
+
+void MemoryAccounting::release(const void* owner, MemoryCategory category, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = owners.find(owner);
+	if (it == owners.end()) return;
+
+	remove(it->second, category, bytes, 1);
+	remove(total, category, bytes, 1);
+}
+
+void MemoryAccounting::set(const void* owner, MemoryCategory category, size_t bytes, size_t blocks)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	MemoryUsage& usage = owners[owner];
+	MemoryCounter old = usage.categories[category];
+	if (old.current == bytes && old.blocks == blocks) return;
+
+	// re-accounting isn't an allocation, only blocks added are
+	size_t allocations = blocks > old.blocks ? blocks - old.blocks : 0;
+	remove(usage, category, old.current, old.blocks);
+	remove(total, category, old.current, old.blocks);
+	add(usage, category, bytes, blocks, allocations);
+	add(total, category, bytes, blocks, allocations);
+}
+
+MemoryUsage MemoryAccounting::getTotal() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return total;
+}
+
+std::vector<MemoryUsage> MemoryAccounting::getOwners() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<MemoryUsage> result;
+	for (auto& it : owners) result.push_back(it.second);
+	result.insert(result.end(), retired.begin(), retired.end());
+	return result;
+}
+
+// Report
+static void printCounter(std::ostream& out, const char* name, const MemoryCounter& counter)
+{
+	const double MB = 1024.0 * 1024.0;
+	out << "    " << std::left << std::setw(14) << name << std::right
+		<< std::setw(11) << counter.current / MB << std::setw(11) << counter.peak / MB
+		<< std::setw(9) << counter.blocks << std::setw(9) << counter.allocations << "\n";
+}
+
+static void printUsage(std::ostream& out, const MemoryUsage& usage)
+{
+	out << "  " << (usage.name.empty() ? "(unnamed)" : usage.name) << "\n"
+		<< "    category       current MB    peak MB   blocks   allocs\n";
+	for (int c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+		if (usage.categories[c].allocations == 0) continue;
+		printCounter(out, category_names[c], usage.categories[c]);
+	}
+	printCounter(out, "cpu", usage.cpu);
+	printCounter(out, "gpu", usage.gpu);
+}
+
+void MemoryAccounting::report() const
+{
+	MemoryUsage total = getTotal();
+	std::vector<MemoryUsage> usages = getOwners();
+
+	// own stream, so cout formatting isn't changed
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(3) << "Memory:\n";
+	printUsage(out, total);
+	for (const MemoryUsage& usage : usages) printUsage(out, usage);
+	std::cout << out.str();
+}
+
+const char* MemoryAccounting::getCategoryName(int category)
+{
+	return category >= 0 && category < MEMORY_CATEGORY_COUNT ? category_names[category] : "?";
+}
+
+bool MemoryAccounting::isGpu(int category)
+{
+	return category >= MEMORY_GPU_VERTEX;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/*
+	RAM & VRAM of the scene per owner (model) and category.
+
+	GPU side is fed by ResidencyManager: every tracked buffer & texture, re-specification of a resource
+	(eviction, streamed mips) counts as release + new allocation.
+	CPU side is set by models: bytes held by tinygltf::Model (buffers, images, metadata parsed from json)
+	and CPU mip copies, updated whenever they change (after parse, after image decode, after mip builds).
+
+	Current & peak bytes, live blocks and allocations made, per category, per owner and in total.
+	Owners which are gone stay in the report with their peaks.
+	Renderer's own buffers (frame ring, draw data) aren't owned by models and aren't counted.
+
+	Thread safe (CPU side is updated from loader threads).
+*/
+
+enum MemoryCategory {
+	MEMORY_CPU_BUFFERS,		// tinygltf buffers
+	MEMORY_CPU_IMAGES,		// tinygltf images (encoded until decoded)
+	MEMORY_CPU_MIPS,		// mip chains & texture array layers waiting for upload
+	MEMORY_CPU_METADATA,	// accessors, nodes, meshes, materials, names... (vectors & strings, extras not included)
+	MEMORY_GPU_VERTEX,		// vertex buffers
+	MEMORY_GPU_INDEX,		// index buffers
+	MEMORY_GPU_MATERIAL,	// material buffer (bindless)
+	MEMORY_GPU_TEXTURE,		// finest resident level of textures
+	MEMORY_GPU_MIPS,		// coarser levels (generated or streamed)
+	MEMORY_CATEGORY_COUNT
+};
+
+struct MemoryCounter {
+	size_t current = 0;
+	size_t peak = 0;
+	size_t blocks = 0;		// live allocations (buffers, textures, cpu arrays)
+	size_t allocations = 0;	// made so far
+};
+
+struct MemoryUsage {
+	std::string name;
+	MemoryCounter categories[MEMORY_CATEGORY_COUNT];
+	MemoryCounter cpu;	// sum of cpu categories (its own peak)
+	MemoryCounter gpu;
+};
+
+class MemoryAccounting
+{
+public:
+	MemoryAccounting();
+
+	void setName(const void* owner, const std::string& name);
+	void retire(const void* owner); // owner is gone, what's left is released
+
+	// GPU resources
+	void allocate(const void* owner, MemoryCategory category, size_t bytes);
+	void release(const void* owner, MemoryCategory category, size_t bytes);
+
+	// CPU data of owner: bytes in blocks arrays, replaces previous value of category (only new blocks count as allocations)
+	void set(const void* owner, MemoryCategory category, size_t bytes, size_t blocks);
+
+	MemoryUsage getTotal() const;
+	std::vector<MemoryUsage> getOwners() const; // live ones, then retired
+	void report() const;
+
+	static const char* getCategoryName(int category);
+	static bool isGpu(int category);
+
+private:
+	void add(MemoryUsage& usage, MemoryCategory category, size_t bytes, size_t blocks, size_t allocations);
+	void remove(MemoryUsage& usage, MemoryCategory category, size_t bytes, size_t blocks);
+
+private:
+	mutable std::mutex mutex;
+	std::map<const void*, MemoryUsage> owners;
+	std::vector<MemoryUsage> retired;
+	MemoryUsage total;
+};
@@ -0,0 +1,89 @@
+#include "MipChain.h"
+
+#include <algorithm>
+
+// 2x box filter (edges are clamped for odd sizes)
+template<typename T>
+static void downsample(const T* src, int src_w, int src_h, int comp, T* dst, int dst_w, int dst_h)
+{
+	for (int y = 0; y < dst_h; ++y) {
+		int y0 = std::min(y * 2, src_h - 1);
+		int y1 = std::min(y * 2 + 1, src_h - 1);
+
+		for (int x = 0; x < dst_w; ++x) {
+			int x0 = std::min(x * 2, src_w - 1);
+			int x1 = std::min(x * 2 + 1, src_w - 1);
+
+			for (int c = 0; c < comp; ++c) {
+				unsigned int sum = src[(y0 * src_w + x0) * comp + c] + src[(y0 * src_w + x1) * comp + c]
+					+ src[(y1 * src_w + x0) * comp + c] + src[(y1 * src_w + x1) * comp + c];
+				dst[(y * dst_w + x) * comp + c] = (T)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+MipChain::MipChain()
+{
+}
+
+void MipChain::build(const tinygltf::Image& image)
+{
+	levels.clear();
+	built = true;
+	if (image.image.empty() || image.width < 1 || image.height < 1) return;
+
+	size_t channel_size = image.bits == 16 ? 2 : 1;
+	int width = image.width;
+	int height = image.height;
+	const unsigned char* src = image.image.data();
+
+	while (width > 1 || height > 1) {
+		MipLevel mip;
+		mip.width = std::max(1, width / 2);
+		mip.height = std::max(1, height / 2);
+		mip.data.resize((size_t)mip.width * mip.height * image.component * channel_size);
+
+		if (channel_size == 2)
+			downsample((const unsigned short*)src, width, height, image.component, (unsigned short*)mip.data.data(), mip.width, mip.height);
+		else
+			downsample(src, width, height, image.component, mip.data.data(), mip.width, mip.height);
+
+		levels.push_back(std::move(mip));
+		width = levels.back().width;
+		height = levels.back().height;
+		src = levels.back().data.data();
+	}
+}
+
+bool MipChain::isBuilt() const
+{
+	return built;
+}
+
+int MipChain::getLevelCount() const
+{
+	return (int)levels.size() + 1;
+}
+
+size_t MipChain::getBytes() const
+{
+	size_t bytes = 0;
+	for (const MipLevel& mip : levels) bytes += mip.data.capacity();
+	return bytes;
+}
+
+const unsigned char* MipChain::getLevel(const tinygltf::Image& image, int level, int& width, int& height) const
+{
+	level = std::min(level, (int)levels.size());
+	if (level <= 0) {
+		width = image.width;
+		height = image.height;
+		return image.image.data();
+	}
+
+	const MipLevel& mip = levels[level - 1];
+	width = mip.width;
+	height = mip.height;
+	return mip.data.data();
+}
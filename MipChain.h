@@ -0,0 +1,34 @@
+#pragma once
+
+#include "tiny_gltf.h"
+
+#include <vector>
+
+
+/*
+	CPU copy of image mips (box filtered), used for texture streaming and eviction.
+	Level 0 is the image itself and is not duplicated.
+*/
+
+struct MipLevel {
+	int width;
+	int height;
+	std::vector<unsigned char> data;
+};
+
+class MipChain
+{
+public:
+	MipChain();
+
+	void build(const tinygltf::Image& image);
+	bool isBuilt() const;
+
+	int getLevelCount() const;
+	size_t getBytes() const; // cpu copies (levels 1..n)
+	const unsigned char* getLevel(const tinygltf::Image& image, int level, int& width, int& height) const;
+
+private:
+	std::vector<MipLevel> levels; // level 1..n
+	bool built = false;
+};
@@ -0,0 +1,494 @@
+#include "NullGL.h"
+#include "GLExtensions.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+// Object kinds, for live object counts
+enum NullObject {
+	NULL_BUFFER,
+	NULL_TEXTURE,
+	NULL_VERTEX_ARRAY,
+	NULL_SAMPLER,
+	NULL_SHADER,
+	NULL_PROGRAM,
+	NULL_QUERY,
+	NULL_FRAMEBUFFER,
+	NULL_RENDERBUFFER,
+	NULL_SYNC,
+	NULL_OBJECT_COUNT
+};
+
+static const char* object_names[NULL_OBJECT_COUNT] = {
+	"buffers", "textures", "vertex arrays", "samplers", "shaders",
+	"programs", "queries", "framebuffers", "renderbuffers", "syncs"
+};
+
+// Buffer memory is allocated only when mapped
+struct NullBuffer {
+	GLsizeiptr size = 0;
+	std::vector<unsigned char> storage;
+};
+
+static const char* extension_names[] = { "GL_ARB_buffer_storage", "GL_KHR_debug" };
+static const GLint EXTENSION_COUNT = sizeof(extension_names) / sizeof(extension_names[0]);
+
+static struct {
+	bool recording = false;
+	bool logging = false;
+	std::vector<GLCall> calls;
+	std::unordered_map<const char*, size_t> counts; // by name literal
+	size_t call_count = 0;
+	size_t state_changes = 0;
+
+	GLuint next_id = 1; // ids are unique over all kinds (easier to read in logs)
+	int live[NULL_OBJECT_COUNT] = {};
+	std::map<GLuint, NullBuffer> buffers;
+	std::map<GLenum, GLuint> bound_buffers; // by target
+} null_gl;
+
+static void record(const char* name, bool state_change, int arg_count = 0,
+	GLuint64 a = 0, GLuint64 b = 0, GLuint64 c = 0, GLuint64 d = 0)
+{
+	null_gl.call_count++;
+	null_gl.counts[name]++;
+	if (state_change) null_gl.state_changes++;
+	if (!null_gl.recording && !null_gl.logging) return;
+
+	GLCall call{ name, { a, b, c, d }, arg_count, state_change };
+	if (null_gl.recording) null_gl.calls.push_back(call);
+	if (null_gl.logging) {
+		std::cout << name << "(";
+		for (int i = 0; i < arg_count; ++i) std::cout << (i > 0 ? ", " : "") << call.args[i];
+		std::cout << ")" << std::endl;
+	}
+}
+
+static void generate(NullObject kind, GLsizei n, GLuint* ids)
+{
+	for (GLsizei i = 0; i < n; ++i) ids[i] = null_gl.next_id++;
+	null_gl.live[kind] += n;
+}
+
+static void release(NullObject kind, GLsizei n, const GLuint* ids)
+{
+	for (GLsizei i = 0; i < n; ++i) {
+		if (ids[i] == 0) continue;
+		null_gl.live[kind]--;
+		if (kind == NULL_BUFFER) null_gl.buffers.erase(ids[i]);
+	}
+}
+
+static NullBuffer* boundBuffer(GLenum target)
+{
+	auto bound = null_gl.bound_buffers.find(target);
+	if (bound == null_gl.bound_buffers.end() || bound->second == 0) return nullptr;
+	return &null_gl.buffers[bound->second];
+}
+
+// State
+static void APIENTRY null_glActiveTexture(GLenum texture) { record("glActiveTexture", true, 1, texture); }
+static void APIENTRY null_glBlendFunc(GLenum sfactor, GLenum dfactor) { record("glBlendFunc", true, 2, sfactor, dfactor); }
+static void APIENTRY null_glColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) { record("glColorMask", true, 4, r, g, b, a); }
+static void APIENTRY null_glCullFace(GLenum mode) { record("glCullFace", true, 1, mode); }
+static void APIENTRY null_glDepthFunc(GLenum func) { record("glDepthFunc", true, 1, func); }
+static void APIENTRY null_glDepthMask(GLboolean flag) { record("glDepthMask", true, 1, flag); }
+static void APIENTRY null_glDisable(GLenum cap) { record("glDisable", true, 1, cap); }
+static void APIENTRY null_glEnable(GLenum cap) { record("glEnable", true, 1, cap); }
+static void APIENTRY null_glPixelStorei(GLenum pname, GLint param) { record("glPixelStorei", true, 2, pname, param); }
+static void APIENTRY null_glPolygonMode(GLenum face, GLenum mode) { record("glPolygonMode", true, 2, face, mode); }
+static void APIENTRY null_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) { record("glViewport", true, 4, x, y, width, height); }
+static void APIENTRY null_glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) { record("glClearColor", true); }
+static void APIENTRY null_glClear(GLbitfield mask) { record("glClear", false, 1, mask); }
+static void APIENTRY null_glFinish() { record("glFinish", false); }
+static GLenum APIENTRY null_glGetError() { record("glGetError", false); return GL_NO_ERROR; }
+
+static const GLubyte* APIENTRY null_glGetString(GLenum name)
+{
+	record("glGetString", false, 1, name);
+	switch (name) {
+	case GL_VENDOR: return (const GLubyte*)"OpenGL_scene";
+	case GL_RENDERER: return (const GLubyte*)"Null GL";
+	case GL_VERSION: return (const GLubyte*)"3.3 (Null GL)";
+	case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"3.30";
+	}
+	return nullptr;
+}
+
+static const GLubyte* APIENTRY null_glGetStringi(GLenum name, GLuint index)
+{
+	record("glGetStringi", false, 2, name, index);
+	if (name != GL_EXTENSIONS || index >= (GLuint)EXTENSION_COUNT) return nullptr;
+	return (const GLubyte*)extension_names[index];
+}
+
+static void APIENTRY null_glGetIntegerv(GLenum pname, GLint* data)
+{
+	record("glGetIntegerv", false, 1, pname);
+	switch (pname) {
+	case GL_MAJOR_VERSION: *data = 3; break;
+	case GL_MINOR_VERSION: *data = 3; break;
+	case GL_NUM_EXTENSIONS: *data = EXTENSION_COUNT; break;
+	case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+	case GL_MAX_ARRAY_TEXTURE_LAYERS: *data = 2048; break;
+	case GL_MAX_TEXTURE_BUFFER_SIZE: *data = 1 << 27; break;
+	case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+	default: *data = 0; // e.g. no program binary formats
+	}
+}
+
+// Buffers
+static void APIENTRY null_glGenBuffers(GLsizei n, GLuint* ids) { record("glGenBuffers", false, 1, n); generate(NULL_BUFFER, n, ids); }
+static void APIENTRY null_glDeleteBuffers(GLsizei n, const GLuint* ids) { record("glDeleteBuffers", false, 1, n); release(NULL_BUFFER, n, ids); }
+
+static void APIENTRY null_glBindBuffer(GLenum target, GLuint buffer)
+{
+	record("glBindBuffer", true, 2, target, buffer);
+	null_gl.bound_buffers[target] = buffer;
+}
+
+static void APIENTRY null_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	record("glBindBufferBase", true, 3, target, index, buffer);
+	null_gl.bound_buffers[target] = buffer;
+}
+
+static void APIENTRY null_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr)
+{
+	record("glBindBufferRange", true, 4, target, index, buffer, offset);
+	null_gl.bound_buffers[target] = buffer;
+}
+
+static void APIENTRY null_glBufferData(GLenum target, GLsizeiptr size, const void*, GLenum usage)
+{
+	record("glBufferData", false, 3, target, size, usage);
+	NullBuffer* buffer = boundBuffer(target);
+	if (buffer == nullptr) return;
+	buffer->size = size;
+	buffer->storage.clear();
+}
+
+static void APIENTRY null_glBufferStorage(GLenum target, GLsizeiptr size, const void*, GLbitfield flags)
+{
+	record("glBufferStorage", false, 3, target, size, flags);
+	NullBuffer* buffer = boundBuffer(target);
+	if (buffer != nullptr) buffer->size = size;
+}
+
+static void APIENTRY null_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void*) { record("glBufferSubData", false, 3, target, offset, size); }
+
+static void* APIENTRY null_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	record("glMapBufferRange", false, 4, target, offset, length, access);
+	NullBuffer* buffer = boundBuffer(target);
+	if (buffer == nullptr || offset + length > buffer->size) return nullptr;
+	if (buffer->storage.size() < (size_t)buffer->size) buffer->storage.resize(buffer->size); // stays put once allocated (persistent maps)
+	return buffer->storage.data() + offset;
+}
+
+static void APIENTRY null_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) { record("glFlushMappedBufferRange", false, 3, target, offset, length); }
+static GLboolean APIENTRY null_glUnmapBuffer(GLenum target) { record("glUnmapBuffer", false, 1, target); return GL_TRUE; }
+
+// Vertex arrays
+static void APIENTRY null_glGenVertexArrays(GLsizei n, GLuint* ids) { record("glGenVertexArrays", false, 1, n); generate(NULL_VERTEX_ARRAY, n, ids); }
+static void APIENTRY null_glDeleteVertexArrays(GLsizei n, const GLuint* ids) { record("glDeleteVertexArrays", false, 1, n); release(NULL_VERTEX_ARRAY, n, ids); }
+static void APIENTRY null_glBindVertexArray(GLuint array) { record("glBindVertexArray", true, 1, array); }
+static void APIENTRY null_glEnableVertexAttribArray(GLuint index) { record("glEnableVertexAttribArray", false, 1, index); }
+static void APIENTRY null_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean, GLsizei, const void* pointer)
+{
+	record("glVertexAttribPointer", false, 4, index, size, type, (GLuint64)(size_t)pointer);
+}
+
+// Textures & samplers
+static void APIENTRY null_glGenTextures(GLsizei n, GLuint* ids) { record("glGenTextures", false, 1, n); generate(NULL_TEXTURE, n, ids); }
+static void APIENTRY null_glDeleteTextures(GLsizei n, const GLuint* ids) { record("glDeleteTextures", false, 1, n); release(NULL_TEXTURE, n, ids); }
+static void APIENTRY null_glBindTexture(GLenum target, GLuint texture) { record("glBindTexture", true, 2, target, texture); }
+static void APIENTRY null_glTexParameteri(GLenum target, GLenum pname, GLint param) { record("glTexParameteri", false, 3, target, pname, param); }
+static void APIENTRY null_glTexParameterf(GLenum target, GLenum pname, GLfloat) { record("glTexParameterf", false, 2, target, pname); }
+static void APIENTRY null_glTexImage2D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum, GLenum, const void*)
+{
+	record("glTexImage2D", false, 4, target, level, width, height);
+}
+static void APIENTRY null_glTexImage3D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLsizei, GLint, GLenum, GLenum, const void*)
+{
+	record("glTexImage3D", false, 4, target, level, width, height);
+}
+static void APIENTRY null_glTexSubImage3D(GLenum target, GLint, GLint, GLint, GLint zoffset, GLsizei width, GLsizei height, GLsizei, GLenum, GLenum, const void*)
+{
+	record("glTexSubImage3D", false, 4, target, zoffset, width, height);
+}
+static void APIENTRY null_glTexBuffer(GLenum target, GLenum internalformat, GLuint buffer) { record("glTexBuffer", false, 3, target, internalformat, buffer); }
+static void APIENTRY null_glGenerateMipmap(GLenum target) { record("glGenerateMipmap", false, 1, target); }
+static void APIENTRY null_glGenSamplers(GLsizei n, GLuint* ids) { record("glGenSamplers", false, 1, n); generate(NULL_SAMPLER, n, ids); }
+static void APIENTRY null_glDeleteSamplers(GLsizei n, const GLuint* ids) { record("glDeleteSamplers", false, 1, n); release(NULL_SAMPLER, n, ids); }
+static void APIENTRY null_glBindSampler(GLuint unit, GLuint sampler) { record("glBindSampler", true, 2, unit, sampler); }
+static void APIENTRY null_glSamplerParameteri(GLuint sampler, GLenum pname, GLint param) { record("glSamplerParameteri", false, 3, sampler, pname, param); }
+
+// Shaders & programs (always compiled & linked)
+static GLuint APIENTRY null_glCreateShader(GLenum type)
+{
+	record("glCreateShader", false, 1, type);
+	GLuint id;
+	generate(NULL_SHADER, 1, &id);
+	return id;
+}
+static void APIENTRY null_glDeleteShader(GLuint shader) { record("glDeleteShader", false, 1, shader); release(NULL_SHADER, 1, &shader); }
+static void APIENTRY null_glShaderSource(GLuint shader, GLsizei count, const GLchar* const*, const GLint*) { record("glShaderSource", false, 2, shader, count); }
+static void APIENTRY null_glCompileShader(GLuint shader) { record("glCompileShader", false, 1, shader); }
+static void APIENTRY null_glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+	record("glGetShaderiv", false, 2, shader, pname);
+	*params = (pname == GL_COMPILE_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+static void APIENTRY null_glGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* log)
+{
+	record("glGetShaderInfoLog", false, 1, shader);
+	if (length != nullptr) *length = 0;
+	if (size > 0) log[0] = '\0';
+}
+
+static GLuint APIENTRY null_glCreateProgram()
+{
+	record("glCreateProgram", false);
+	GLuint id;
+	generate(NULL_PROGRAM, 1, &id);
+	return id;
+}
+static void APIENTRY null_glDeleteProgram(GLuint program) { record("glDeleteProgram", false, 1, program); release(NULL_PROGRAM, 1, &program); }
+static void APIENTRY null_glAttachShader(GLuint program, GLuint shader) { record("glAttachShader", false, 2, program, shader); }
+static void APIENTRY null_glLinkProgram(GLuint program) { record("glLinkProgram", false, 1, program); }
+static void APIENTRY null_glUseProgram(GLuint program) { record("glUseProgram", true, 1, program); }
+static void APIENTRY null_glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+	record("glGetProgramiv", false, 2, program, pname);
+	*params = (pname == GL_LINK_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+static void APIENTRY null_glGetProgramInfoLog(GLuint program, GLsizei size, GLsizei* length, GLchar* log)
+{
+	record("glGetProgramInfoLog", false, 1, program);
+	if (length != nullptr) *length = 0;
+	if (size > 0) log[0] = '\0';
+}
+static GLint APIENTRY null_glGetUniformLocation(GLuint program, const GLchar*) { record("glGetUniformLocation", false, 1, program); return 0; }
+static GLuint APIENTRY null_glGetUniformBlockIndex(GLuint program, const GLchar*) { record("glGetUniformBlockIndex", false, 1, program); return 0; }
+static void APIENTRY null_glUniformBlockBinding(GLuint program, GLuint index, GLuint binding) { record("glUniformBlockBinding", false, 3, program, index, binding); }
+
+// Uniforms
+static void APIENTRY null_glUniform1i(GLint location, GLint v0) { record("glUniform1i", false, 2, location, v0); }
+static void APIENTRY null_glUniform1f(GLint location, GLfloat) { record("glUniform1f", false, 1, location); }
+static void APIENTRY null_glUniform2f(GLint location, GLfloat, GLfloat) { record("glUniform2f", false, 1, location); }
+static void APIENTRY null_glUniform3f(GLint location, GLfloat, GLfloat, GLfloat) { record("glUniform3f", false, 1, location); }
+static void APIENTRY null_glUniform4f(GLint location, GLfloat, GLfloat, GLfloat, GLfloat) { record("glUniform4f", false, 1, location); }
+static void APIENTRY null_glUniform2fv(GLint location, GLsizei count, const GLfloat*) { record("glUniform2fv", false, 2, location, count); }
+static void APIENTRY null_glUniform3fv(GLint location, GLsizei count, const GLfloat*) { record("glUniform3fv", false, 2, location, count); }
+static void APIENTRY null_glUniform4fv(GLint location, GLsizei count, const GLfloat*) { record("glUniform4fv", false, 2, location, count); }
+static void APIENTRY null_glUniformMatrix2fv(GLint location, GLsizei count, GLboolean, const GLfloat*) { record("glUniformMatrix2fv", false, 2, location, count); }
+static void APIENTRY null_glUniformMatrix3fv(GLint location, GLsizei count, GLboolean, const GLfloat*) { record("glUniformMatrix3fv", false, 2, location, count); }
+static void APIENTRY null_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean, const GLfloat*) { record("glUniformMatrix4fv", false, 2, location, count); }
+
+// Draws
+static void APIENTRY null_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	record("glDrawElements", false, 4, mode, count, type, (GLuint64)(size_t)indices);
+}
+
+// Framebuffers
+static void APIENTRY null_glGenFramebuffers(GLsizei n, GLuint* ids) { record("glGenFramebuffers", false, 1, n); generate(NULL_FRAMEBUFFER, n, ids); }
+static void APIENTRY null_glDeleteFramebuffers(GLsizei n, const GLuint* ids) { record("glDeleteFramebuffers", false, 1, n); release(NULL_FRAMEBUFFER, n, ids); }
+static void APIENTRY null_glBindFramebuffer(GLenum target, GLuint framebuffer) { record("glBindFramebuffer", true, 2, target, framebuffer); }
+static void APIENTRY null_glGenRenderbuffers(GLsizei n, GLuint* ids) { record("glGenRenderbuffers", false, 1, n); generate(NULL_RENDERBUFFER, n, ids); }
+static void APIENTRY null_glDeleteRenderbuffers(GLsizei n, const GLuint* ids) { record("glDeleteRenderbuffers", false, 1, n); release(NULL_RENDERBUFFER, n, ids); }
+static void APIENTRY null_glBindRenderbuffer(GLenum target, GLuint renderbuffer) { record("glBindRenderbuffer", true, 2, target, renderbuffer); }
+static void APIENTRY null_glRenderbufferStorage(GLenum target, GLenum format, GLsizei width, GLsizei height) { record("glRenderbufferStorage", false, 4, target, format, width, height); }
+static void APIENTRY null_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum, GLuint renderbuffer) { record("glFramebufferRenderbuffer", false, 3, target, attachment, renderbuffer); }
+static GLenum APIENTRY null_glCheckFramebufferStatus(GLenum target) { record("glCheckFramebufferStatus", false, 1, target); return GL_FRAMEBUFFER_COMPLETE; }
+
+static void APIENTRY null_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum, GLenum, void* pixels)
+{
+	record("glReadPixels", false, 4, x, y, width, height);
+	// into pack buffer (offset) or client memory, which is cleared (RGBA8 assumed)
+	if (boundBuffer(GL_PIXEL_PACK_BUFFER) == nullptr && pixels != nullptr)
+		memset(pixels, 0, (size_t)width * height * 4);
+}
+
+// Queries & syncs (results are zeros, always available)
+static void APIENTRY null_glGenQueries(GLsizei n, GLuint* ids) { record("glGenQueries", false, 1, n); generate(NULL_QUERY, n, ids); }
+static void APIENTRY null_glDeleteQueries(GLsizei n, const GLuint* ids) { record("glDeleteQueries", false, 1, n); release(NULL_QUERY, n, ids); }
+static void APIENTRY null_glBeginQuery(GLenum target, GLuint id) { record("glBeginQuery", false, 2, target, id); }
+static void APIENTRY null_glEndQuery(GLenum target) { record("glEndQuery", false, 1, target); }
+static void APIENTRY null_glQueryCounter(GLuint id, GLenum target) { record("glQueryCounter", false, 2, id, target); }
+static void APIENTRY null_glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params)
+{
+	record("glGetQueryObjectiv", false, 2, id, pname);
+	*params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+static void APIENTRY null_glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+	record("glGetQueryObjectui64v", false, 2, id, pname);
+	*params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static GLsync APIENTRY null_glFenceSync(GLenum condition, GLbitfield flags)
+{
+	record("glFenceSync", false, 2, condition, flags);
+	null_gl.live[NULL_SYNC]++;
+	return (GLsync)(size_t)null_gl.next_id++;
+}
+static void APIENTRY null_glDeleteSync(GLsync sync)
+{
+	record("glDeleteSync", false, 1, (GLuint64)(size_t)sync);
+	if (sync != 0) null_gl.live[NULL_SYNC]--;
+}
+static GLenum APIENTRY null_glClientWaitSync(GLsync sync, GLbitfield, GLuint64) { record("glClientWaitSync", false, 1, (GLuint64)(size_t)sync); return GL_ALREADY_SIGNALED; }
+static void APIENTRY null_glGetSynciv(GLsync sync, GLenum pname, GLsizei count, GLsizei* length, GLint* values)
+{
+	record("glGetSynciv", false, 2, (GLuint64)(size_t)sync, pname);
+	if (length != nullptr) *length = count > 0 ? 1 : 0;
+	if (count > 0) values[0] = pname == GL_SYNC_STATUS ? GL_SIGNALED : 0;
+}
+
+// KHR_debug
+static void APIENTRY null_glPushDebugGroup(GLenum source, GLuint id, GLsizei, const GLchar*) { record("glPushDebugGroup", false, 2, source, id); }
+static void APIENTRY null_glPopDebugGroup() { record("glPopDebugGroup", false); }
+
+// Loader table, signatures are checked against glad's pointers
+struct NullProc {
+	const char* name;
+	void* proc;
+};
+
+#define NULL_GL_PROC(name) { #name, (void*)static_cast<decltype(glad_##name)>(null_##name) }
+#define NULL_GLEXT_PROC(name) { #name, (void*)static_cast<decltype(glext_##name)>(null_##name) }
+
+static const NullProc procs[] = {
+	NULL_GL_PROC(glActiveTexture), NULL_GL_PROC(glBlendFunc), NULL_GL_PROC(glColorMask), NULL_GL_PROC(glCullFace),
+	NULL_GL_PROC(glDepthFunc), NULL_GL_PROC(glDepthMask), NULL_GL_PROC(glDisable), NULL_GL_PROC(glEnable),
+	NULL_GL_PROC(glPixelStorei), NULL_GL_PROC(glPolygonMode), NULL_GL_PROC(glViewport), NULL_GL_PROC(glClearColor),
+	NULL_GL_PROC(glClear), NULL_GL_PROC(glFinish), NULL_GL_PROC(glGetError), NULL_GL_PROC(glGetString), NULL_GL_PROC(glGetStringi),
+	NULL_GL_PROC(glGetIntegerv),
+
+	NULL_GL_PROC(glGenBuffers), NULL_GL_PROC(glDeleteBuffers), NULL_GL_PROC(glBindBuffer), NULL_GL_PROC(glBindBufferBase),
+	NULL_GL_PROC(glBindBufferRange), NULL_GL_PROC(glBufferData), NULL_GL_PROC(glBufferSubData), NULL_GL_PROC(glMapBufferRange),
+	NULL_GL_PROC(glFlushMappedBufferRange), NULL_GL_PROC(glUnmapBuffer), NULL_GLEXT_PROC(glBufferStorage),
+
+	NULL_GL_PROC(glGenVertexArrays), NULL_GL_PROC(glDeleteVertexArrays), NULL_GL_PROC(glBindVertexArray),
+	NULL_GL_PROC(glEnableVertexAttribArray), NULL_GL_PROC(glVertexAttribPointer),
+
+	NULL_GL_PROC(glGenTextures), NULL_GL_PROC(glDeleteTextures), NULL_GL_PROC(glBindTexture), NULL_GL_PROC(glTexParameteri),
+	NULL_GL_PROC(glTexParameterf), NULL_GL_PROC(glTexImage2D), NULL_GL_PROC(glTexImage3D), NULL_GL_PROC(glTexSubImage3D),
+	NULL_GL_PROC(glTexBuffer), NULL_GL_PROC(glGenerateMipmap), NULL_GL_PROC(glGenSamplers), NULL_GL_PROC(glDeleteSamplers),
+	NULL_GL_PROC(glBindSampler), NULL_GL_PROC(glSamplerParameteri),
+
+	NULL_GL_PROC(glCreateShader), NULL_GL_PROC(glDeleteShader), NULL_GL_PROC(glShaderSource), NULL_GL_PROC(glCompileShader),
+	NULL_GL_PROC(glGetShaderiv), NULL_GL_PROC(glGetShaderInfoLog), NULL_GL_PROC(glCreateProgram), NULL_GL_PROC(glDeleteProgram),
+	NULL_GL_PROC(glAttachShader), NULL_GL_PROC(glLinkProgram), NULL_GL_PROC(glUseProgram), NULL_GL_PROC(glGetProgramiv),
+	NULL_GL_PROC(glGetProgramInfoLog), NULL_GL_PROC(glGetUniformLocation), NULL_GL_PROC(glGetUniformBlockIndex),
+	NULL_GL_PROC(glUniformBlockBinding),
+
+	NULL_GL_PROC(glUniform1i), NULL_GL_PROC(glUniform1f), NULL_GL_PROC(glUniform2f), NULL_GL_PROC(glUniform3f),
+	NULL_GL_PROC(glUniform4f), NULL_GL_PROC(glUniform2fv), NULL_GL_PROC(glUniform3fv), NULL_GL_PROC(glUniform4fv),
+	NULL_GL_PROC(glUniformMatrix2fv), NULL_GL_PROC(glUniformMatrix3fv), NULL_GL_PROC(glUniformMatrix4fv),
+
+	NULL_GL_PROC(glDrawElements),
+
+	NULL_GL_PROC(glGenFramebuffers), NULL_GL_PROC(glDeleteFramebuffers), NULL_GL_PROC(glBindFramebuffer),
+	NULL_GL_PROC(glGenRenderbuffers), NULL_GL_PROC(glDeleteRenderbuffers), NULL_GL_PROC(glBindRenderbuffer),
+	NULL_GL_PROC(glRenderbufferStorage), NULL_GL_PROC(glFramebufferRenderbuffer), NULL_GL_PROC(glCheckFramebufferStatus),
+	NULL_GL_PROC(glReadPixels),
+
+	NULL_GL_PROC(glGenQueries), NULL_GL_PROC(glDeleteQueries), NULL_GL_PROC(glBeginQuery), NULL_GL_PROC(glEndQuery),
+	NULL_GL_PROC(glQueryCounter), NULL_GL_PROC(glGetQueryObjectiv), NULL_GL_PROC(glGetQueryObjectui64v),
+	NULL_GL_PROC(glFenceSync), NULL_GL_PROC(glDeleteSync), NULL_GL_PROC(glClientWaitSync), NULL_GL_PROC(glGetSynciv),
+
+	NULL_GLEXT_PROC(glPushDebugGroup), NULL_GLEXT_PROC(glPopDebugGroup)
+};
+
+static void* getProcAddress(const char* name)
+{
+	for (const NullProc& proc : procs) {
+		if (strcmp(proc.name, name) == 0) return proc.proc;
+	}
+	return nullptr;
+}
+
+GLADloadproc NullGL::getLoader()
+{
+	return getProcAddress;
+}
+
+void NullGL::setRecording(bool enabled)
+{
+	null_gl.recording = enabled;
+}
+
+void NullGL::setLogging(bool enabled)
+{
+	null_gl.logging = enabled;
+}
+
+const std::vector<GLCall>& NullGL::getCalls()
+{
+	return null_gl.calls;
+}
+
+void NullGL::clearCalls()
+{
+	null_gl.calls.clear();
+	null_gl.counts.clear();
+	null_gl.call_count = 0;
+	null_gl.state_changes = 0;
+}
+
+size_t NullGL::getCallCount()
+{
+	return null_gl.call_count;
+}
+
+size_t NullGL::getCallCount(const std::string& name)
+{
+	size_t count = 0;
+	for (auto& c : null_gl.counts) {
+		if (name == c.first) count += c.second;
+	}
+	return count;
+}
+
+size_t NullGL::getStateChanges()
+{
+	return null_gl.state_changes;
+}
+
+size_t NullGL::getLiveObjects()
+{
+	size_t count = 0;
+	for (int kind = 0; kind < NULL_OBJECT_COUNT; ++kind) count += null_gl.live[kind];
+	return count;
+}
+
+void NullGL::report(int frames)
+{
+	if (frames <= 0) frames = 1;
+
+	// most frequent first
+	std::vector<std::pair<const char*, size_t>> counts(null_gl.counts.begin(), null_gl.counts.end());
+	std::sort(counts.begin(), counts.end(), [](const std::pair<const char*, size_t>& a, const std::pair<const char*, size_t>& b) {
+		return a.second != b.second ? a.second > b.second : strcmp(a.first, b.first) < 0;
+	});
+
+	std::cout << "Null GL: " << null_gl.call_count << " calls, " << null_gl.state_changes << " state changes in "
+		<< frames << " frames, per frame:" << std::endl;
+	for (auto& c : counts) {
+		std::cout << "  " << std::left << std::setw(28) << c.first << std::right
+			<< (double)c.second / frames << std::endl;
+	}
+
+	std::cout << "Null GL live objects:";
+	for (int kind = 0; kind < NULL_OBJECT_COUNT; ++kind) {
+		if (null_gl.live[kind] != 0) std::cout << " " << object_names[kind] << " " << null_gl.live[kind];
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/*
+	GL without GPU: a loader whose functions only count & record calls.
+	For measuring CPU cost of the render loop and checking its call stream on machines without GPU.
+
+	Use getLoader() instead of a context's loader (gladLoadGLLoader & loadGLExtensions),
+	then everything runs as usual: object ids are generated, shaders always compile & link,
+	buffers get cpu memory for mapping, queries return zeros, nothing is drawn.
+	Reports GL 3.3 core with GL_ARB_buffer_storage & GL_KHR_debug.
+
+	Only functions the renderer uses are provided, the rest stay nullptr in glad.
+	Global (there is one set of glad pointers), single thread.
+*/
+
+// Recorded call, integer arguments only (enums, ids, counts; floats & pointers aren't kept)
+struct GLCall {
+	const char* name;	// "glBindTexture"
+	GLuint64 args[4];
+	int arg_count;
+	bool state_change;	// binds, program switches, enable/disable & other fixed-function state
+};
+
+class NullGL
+{
+public:
+	static GLADloadproc getLoader();
+
+	// Call stream: every call is counted, kept only while recording
+	static void setRecording(bool enabled);
+	static void setLogging(bool enabled); // prints every call
+	static const std::vector<GLCall>& getCalls();
+	static void clearCalls(); // and counters
+
+	// Since clearCalls
+	static size_t getCallCount();
+	static size_t getCallCount(const std::string& name);
+	static size_t getStateChanges();
+
+	static size_t getLiveObjects(); // created & not deleted yet (all kinds)
+	static void report(int frames); // calls per frame by function, live objects
+};
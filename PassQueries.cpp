@@ -0,0 +1,113 @@
+#include "PassQueries.h"
+
+#include <iostream>
+
+PassQueries::PassQueries()
+{
+}
+
+void PassQueries::init(int passes)
+{
+	this->passes = passes;
+	for (Frame& f : frames) {
+		f.time_queries.resize(passes);
+		f.sample_queries.resize(passes);
+		f.used.assign(passes, false);
+		glGenQueries(passes, f.time_queries.data());
+		glGenQueries(passes, f.sample_queries.data());
+	}
+	results.assign(passes, PassResult());
+}
+
+void PassQueries::cleanup()
+{
+	for (Frame& f : frames) {
+		if (!f.time_queries.empty()) glDeleteQueries((GLsizei)f.time_queries.size(), f.time_queries.data());
+		if (!f.sample_queries.empty()) glDeleteQueries((GLsizei)f.sample_queries.size(), f.sample_queries.data());
+		f.time_queries.clear();
+		f.sample_queries.clear();
+		f.pending = false;
+	}
+	active = -1;
+}
+
+// Frame
+void PassQueries::beginFrame()
+{
+	if (active != -1) {
+		std::cout << "WARN: pass " << active << " queries weren't ended in the last frame" << std::endl;
+		end(active);
+	}
+
+	frame = (frame + 1) % FRAMES;
+	new_results = false;
+
+	// queries of this slot were issued FRAMES frames ago
+	Frame& f = frames[frame];
+	if (f.pending) readFrame(f);
+
+	f.used.assign(passes, false);
+	f.pending = false;
+}
+
+void PassQueries::begin(int pass)
+{
+	if (active != -1) {
+		std::cout << "WARN: pass " << pass << " queries begin inside pass " << active << ", not measured" << std::endl;
+		return;
+	}
+	active = pass;
+
+	Frame& f = frames[frame];
+	glBeginQuery(GL_TIME_ELAPSED, f.time_queries[pass]);
+	glBeginQuery(GL_SAMPLES_PASSED, f.sample_queries[pass]);
+	f.used[pass] = true;
+	f.pending = true;
+}
+
+void PassQueries::end(int pass)
+{
+	if (pass != active) {
+		std::cout << "WARN: pass " << pass << " queries end, but active pass is " << active << std::endl;
+		return;
+	}
+	active = -1;
+
+	glEndQuery(GL_SAMPLES_PASSED);
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+void PassQueries::readFrame(Frame& f)
+{
+	// all queries are done when the last used one is
+	GLuint last = 0;
+	for (int i = 0; i < passes; ++i) {
+		if (f.used[i]) last = f.time_queries[i];
+	}
+
+	GLint available = 0;
+	glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) return; // dropped, never wait
+
+	for (int i = 0; i < passes; ++i) {
+		results[i] = PassResult();
+		if (!f.used[i]) continue;
+
+		GLuint64 time_ns = 0;
+		glGetQueryObjectui64v(f.time_queries[i], GL_QUERY_RESULT, &time_ns);
+		glGetQueryObjectui64v(f.sample_queries[i], GL_QUERY_RESULT, &results[i].samples);
+		results[i].ms = time_ns / 1000000.0;
+		results[i].valid = true;
+	}
+	new_results = true;
+}
+
+bool PassQueries::hasNewResults() const
+{
+	return new_results;
+}
+
+const std::vector<PassResult>& PassQueries::getResults() const
+{
+	return results;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+
+
+/*
+	GPU time (GL_TIME_ELAPSED) & samples passed (GL_SAMPLES_PASSED) of render passes.
+
+	Queries of a frame are read FRAMES frames later, so reading never waits for GPU
+	(results which aren't available by then are dropped). Passes which didn't run
+	in a frame have invalid results.
+
+	Passes can't be nested (one query of each type can be active), begin & end of a pass
+	have to pair up (mismatches are reported and ignored). GL thread only.
+*/
+
+struct PassResult {
+	bool valid = false;
+	double ms = 0.0;
+	GLuint64 samples = 0;
+};
+
+class PassQueries
+{
+public:
+	PassQueries();
+
+	void init(int passes);
+	void cleanup();
+
+	// Frame: beginFrame -> (begin, end)... per pass
+	void beginFrame(); // reads results of the oldest frame
+	void begin(int pass);
+	void end(int pass);
+
+	bool hasNewResults() const; // read in this beginFrame
+	const std::vector<PassResult>& getResults() const; // latest frame with results
+
+public:
+	static const int FRAMES = 3;
+
+private:
+	struct Frame {
+		std::vector<GLuint> time_queries;
+		std::vector<GLuint> sample_queries;
+		std::vector<bool> used;
+		bool pending = false;
+	};
+
+	void readFrame(Frame& frame);
+
+private:
+	Frame frames[FRAMES];
+	int frame = 0;
+	int passes = 0;
+	int active = -1; // pass between begin & end
+
+	std::vector<PassResult> results;
+	bool new_results = false;
+};
@@ -0,0 +1,162 @@
+#include "ProgramBinaryCache.h"
+#include "GLExtensions.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+ProgramBinaryCache::ProgramBinaryCache()
+{
+}
+
+void ProgramBinaryCache::init(const std::string& directory)
+{
+	enabled = getGLExtensions().program_binary;
+	if (!enabled) {
+		std::cout << "WARN: program binaries are not supported, shaders are compiled every run" << std::endl;
+		return;
+	}
+
+	this->directory = directory;
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	const char* version = (const char*)glGetString(GL_VERSION);
+	driver = std::string(renderer ? renderer : "") + "\n" + (version ? version : "");
+}
+
+bool ProgramBinaryCache::isEnabled() const
+{
+	return enabled;
+}
+
+uint64_t ProgramBinaryCache::getKey(const std::string& vertex_code, const std::string& fragment_code) const
+{
+	// FNV-1a, sources already contain injected defines
+	uint64_t hash = 14695981039346656037ull;
+	for (const std::string* part : { &vertex_code, &fragment_code, &driver }) {
+		for (unsigned char c : *part) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		hash ^= 0xff;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+std::string ProgramBinaryCache::getPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return directory + "/" + name;
+}
+
+// Load & store
+GLuint ProgramBinaryCache::load(uint64_t key, const std::string& name)
+{
+	if (!enabled) return 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::ifstream file(getPath(key), std::ios::binary);
+	Header header;
+	if (!file || !file.read((char*)&header, sizeof(header)) || header.magic != MAGIC) {
+		stats.misses++;
+		std::cout << "Program binary cache: miss " << name << std::endl;
+		return 0;
+	}
+
+	// length is checked against the file before the binary is allocated
+	std::streamoff end = file.seekg(0, std::ios::end).tellg();
+	file.seekg(sizeof(header));
+	if (end < 0 || header.length > (uint64_t)end - sizeof(header)) {
+		stats.misses++;
+		std::cout << "Program binary cache: miss " << name << " (truncated file)" << std::endl;
+		return 0;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), binary.size())) {
+		stats.misses++;
+		std::cout << "Program binary cache: miss " << name << " (truncated file)" << std::endl;
+		return 0;
+	}
+
+	// driver may reject binary (format or driver changed), program then fails to link
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glDeleteProgram(program);
+		stats.misses++;
+		std::cout << "Program binary cache: miss " << name << " (binary rejected by driver)" << std::endl;
+		return 0;
+	}
+
+	double load_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	stats.hits++;
+	stats.saved_ms += header.compile_ms - load_ms;
+	std::cout << "Program binary cache: hit " << name << ", loaded in " << load_ms
+		<< " ms, saved " << header.compile_ms - load_ms << " ms" << std::endl;
+	return program;
+}
+
+void ProgramBinaryCache::store(uint64_t key, const std::string& name, GLuint program, double compile_ms)
+{
+	if (!enabled) return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	Header header;
+	header.magic = MAGIC;
+	header.format = format;
+	header.length = (uint32_t)length;
+	header.compile_ms = (float)compile_ms;
+
+	// written aside & renamed, so other processes / contexts never load half written file
+	std::string path = getPath(key);
+	std::string temp_path = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), length);
+	file.close();
+
+	bool stored = !file.fail();
+	if (stored && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+		std::remove(path.c_str()); // rename doesn't replace on windows
+		stored = std::rename(temp_path.c_str(), path.c_str()) == 0;
+	}
+	if (!stored) {
+		std::remove(temp_path.c_str());
+		std::cout << "WARN: can't write program binary of " << name << " to " << directory << std::endl;
+	}
+	else std::cout << "Program binary cache: stored " << name << ", compiled in " << compile_ms << " ms" << std::endl;
+}
+
+const ProgramBinaryStats& ProgramBinaryCache::getStats() const
+{
+	return stats;
+}
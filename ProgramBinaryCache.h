@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+
+/*
+	Linked programs stored on disk (glGetProgramBinary), so next runs skip GLSL compilation.
+
+	Key is a hash of final sources (defines included) and GL_RENDERER & GL_VERSION,
+	so a driver update or another gpu never gets a stale binary. Driver can still
+	reject a binary (glProgramBinary fails to link) - then program is compiled and binary replaced.
+
+	One file per program in the cache directory. Needs GL 4.1 / GL_ARB_get_program_binary,
+	otherwise every load is a miss and nothing is stored.
+
+	GL thread only.
+*/
+
+struct ProgramBinaryStats {
+	size_t hits = 0;
+	size_t misses = 0;
+	double saved_ms = 0.0; // GL thread compile time of cached programs minus their load time
+};
+
+class ProgramBinaryCache
+{
+public:
+	ProgramBinaryCache();
+
+	void init(const std::string& directory); // call after loadGLExtensions
+	bool isEnabled() const;
+
+	uint64_t getKey(const std::string& vertex_code, const std::string& fragment_code) const;
+
+	// Creates program from cached binary, 0 - miss (compile & store)
+	GLuint load(uint64_t key, const std::string& name);
+	void store(uint64_t key, const std::string& name, GLuint program, double compile_ms);
+
+	const ProgramBinaryStats& getStats() const;
+
+private:
+	std::string getPath(uint64_t key) const;
+
+	// File header, binary follows
+	struct Header {
+		uint32_t magic;
+		uint32_t format;
+		uint32_t length;
+		float compile_ms;
+	};
+	static const uint32_t MAGIC = 0x4E494250; // "PBIN"
+
+private:
+	bool enabled = false;
+	std::string directory;
+	std::string driver; // GL_RENDERER & GL_VERSION, part of the key
+
+	ProgramBinaryStats stats;
+};
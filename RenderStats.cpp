@@ -0,0 +1,92 @@
+#include "RenderStats.h"
+
+#include <glad/glad.h>
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+void RenderStats::countDraw(unsigned int mode, size_t index_count)
+{
+	draw_calls++;
+	vertices += index_count;
+	if (mode == GL_TRIANGLES) triangles += index_count / 3;
+	else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && index_count > 2) triangles += index_count - 2;
+}
+
+void RenderStats::reset()
+{
+	*this = RenderStats();
+}
+
+RenderStats& RenderStats::operator+=(const RenderStats& other)
+{
+	draw_calls += other.draw_calls;
+	triangles += other.triangles;
+	vertices += other.vertices;
+	program_binds += other.program_binds;
+	vao_binds += other.vao_binds;
+	texture_binds += other.texture_binds;
+	uniform_uploads += other.uniform_uploads;
+	buffer_bytes += other.buffer_bytes;
+	texture_bytes += other.texture_bytes;
+	primitives_visible += other.primitives_visible;
+	primitives_culled += other.primitives_culled;
+	return *this;
+}
+
+RenderStats& RenderStats::current()
+{
+	static thread_local RenderStats stats;
+	return stats;
+}
+
+RenderStatsLog::RenderStatsLog()
+{
+}
+
+void RenderStatsLog::setInterval(int frames)
+{
+	interval = frames > 0 ? frames : 0;
+	this->frames = 0;
+	sum.reset();
+}
+
+int RenderStatsLog::getInterval() const
+{
+	return interval;
+}
+
+void RenderStatsLog::add(const RenderStats& frame)
+{
+	if (interval == 0) return;
+
+	sum += frame;
+	if (++frames < interval) return;
+
+	print(sum, frames);
+	frames = 0;
+	sum.reset();
+}
+
+void RenderStatsLog::print(const RenderStats& sum, int frames)
+{
+	if (frames <= 0) return;
+	double n = (double)frames;
+
+	// own stream, so cout formatting isn't changed
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(1)
+		<< "Render stats (average of " << frames << " frames): "
+		<< sum.draw_calls / n << " draws, "
+		<< sum.triangles / n << " triangles, "
+		<< sum.vertices / n << " vertices, "
+		<< sum.program_binds / n << " programs, "
+		<< sum.vao_binds / n << " vaos, "
+		<< sum.texture_binds / n << " textures, "
+		<< sum.uniform_uploads / n << " uniforms, "
+		<< sum.buffer_bytes / n / 1024.0 << " KB buffers, "
+		<< sum.texture_bytes / n / 1024.0 << " KB textures, "
+		<< "primitives " << sum.primitives_visible / n << " visible / " << sum.primitives_culled / n << " culled";
+	std::cout << line.str() << std::endl;
+}
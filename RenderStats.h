@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+
+
+/*
+	Renderer statistics of a frame: draws, state changes & uploads.
+
+	Counted where GL calls are issued into current() - one instance per thread,
+	so every GL thread (batch jobs have one each) counts its own frames.
+	Scene takes it at the end of a frame (GLTFScene::getRenderStats) and resets it,
+	so counting is just an increment (no locks, no queries).
+
+	RenderStatsLog prints average per frame every N frames.
+*/
+
+struct RenderStats {
+	size_t draw_calls = 0;
+	size_t triangles = 0;
+	size_t vertices = 0;			// indices drawn (vertex shader invocations before post-transform cache)
+	size_t program_binds = 0;
+	size_t vao_binds = 0;
+	size_t texture_binds = 0;
+	size_t uniform_uploads = 0;		// glUniform* calls
+	size_t buffer_bytes = 0;		// buffer uploads & per-frame data written
+	size_t texture_bytes = 0;		// texture uploads
+	size_t primitives_visible = 0;	// frustum test in GLTFModel::writeDrawData
+	size_t primitives_culled = 0;
+
+	void countDraw(unsigned int mode, size_t index_count);
+	void reset();
+	RenderStats& operator+=(const RenderStats& other);
+
+	static RenderStats& current(); // this thread
+};
+
+class RenderStatsLog
+{
+public:
+	RenderStatsLog();
+
+	void setInterval(int frames); // 0 - off
+	int getInterval() const;
+	void add(const RenderStats& frame); // prints summary every interval frames
+
+	static void print(const RenderStats& sum, int frames);
+
+private:
+	int interval = 0;
+	int frames = 0;
+	RenderStats sum;
+};
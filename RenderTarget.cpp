@@ -0,0 +1,172 @@
+#include "RenderTarget.h"
+#include "stb_image_write.h" // implementation is in tiny_gltf.cpp
+
+#include <cstring>
+#include <iostream>
+
+RenderTarget::RenderTarget()
+{
+}
+
+bool RenderTarget::init(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	glGenRenderbuffers(1, &color_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depth_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+
+	for (ReadSlot& slot : read_slots) {
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR: framebuffer " << width << "x" << height << " is incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+		cleanup();
+		return false;
+	}
+	return true;
+}
+
+void RenderTarget::cleanup()
+{
+	if (fbo) glDeleteFramebuffers(1, &fbo);
+	if (color_rb) glDeleteRenderbuffers(1, &color_rb);
+	if (depth_rb) glDeleteRenderbuffers(1, &depth_rb);
+	fbo = color_rb = depth_rb = 0;
+
+	for (ReadSlot& slot : read_slots) {
+		if (slot.fence) glDeleteSync(slot.fence);
+		if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+		slot = ReadSlot();
+	}
+}
+
+void RenderTarget::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+}
+
+void RenderTarget::readPixels(std::vector<unsigned char>& pixels)
+{
+	std::vector<unsigned char> raw((size_t)width * height * 4);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, raw.data());
+
+	copyFlipped(raw.data(), pixels);
+}
+
+// GL rows are bottom up
+void RenderTarget::copyFlipped(const unsigned char* src, std::vector<unsigned char>& pixels) const
+{
+	size_t row = (size_t)width * 4;
+	pixels.resize(row * height);
+	for (int y = 0; y < height; ++y) {
+		memcpy(&pixels[y * row], src + (height - 1 - y) * row, row);
+	}
+}
+
+bool RenderTarget::savePNG(const std::string& path)
+{
+	std::vector<unsigned char> pixels;
+	readPixels(pixels);
+	return writePNG(path, width, height, pixels);
+}
+
+bool RenderTarget::writePNG(const std::string& path, int width, int height, std::vector<unsigned char>& pixels)
+{
+	// blended draws write alpha too, image is opaque
+	for (size_t i = 3; i < pixels.size(); i += 4) pixels[i] = 255;
+
+	if (!stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4)) {
+		std::cout << "ERROR: can't write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Async readback
+int RenderTarget::beginRead()
+{
+	int index = -1;
+	for (int i = 0; i < READ_SLOTS; ++i) {
+		if (!read_slots[i].busy) {
+			index = i;
+			break;
+		}
+	}
+	if (index < 0) return -1;
+
+	ReadSlot& slot = read_slots[index];
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // into pbo, returns right away
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.busy = true;
+	return index;
+}
+
+bool RenderTarget::isReadDone(int index) const
+{
+	const ReadSlot& slot = read_slots[index];
+	if (!slot.busy) return false;
+
+	GLint status = GL_UNSIGNALED;
+	glGetSynciv(slot.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+	return status == GL_SIGNALED;
+}
+
+void RenderTarget::finishRead(int index, std::vector<unsigned char>& pixels)
+{
+	ReadSlot& slot = read_slots[index];
+	if (!slot.busy) return;
+
+	glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+	slot.busy = false;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	const unsigned char* src = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+	if (src != nullptr) {
+		copyFlipped(src, pixels);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else {
+		std::cout << "ERROR: pixel buffer can't be mapped" << std::endl;
+		pixels.assign((size_t)width * height * 4, 0);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+int RenderTarget::getWidth() const
+{
+	return width;
+}
+
+int RenderTarget::getHeight() const
+{
+	return height;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+
+/*
+	Offscreen framebuffer: RGBA8 color & depth-stencil renderbuffers.
+	Frames rendered into it are read back and written as PNG (stb_image_write).
+
+	Async readback: beginRead copies the frame into a pixel buffer (READ_SLOTS of them, fenced),
+	finishRead maps it later, so rendering of next frames isn't stalled by the copy.
+
+	GL thread only.
+*/
+
+class RenderTarget
+{
+public:
+	RenderTarget();
+
+	bool init(int width, int height);
+	void cleanup();
+
+	void bind(); // also sets viewport
+
+	// RGBA, top row first
+	void readPixels(std::vector<unsigned char>& pixels);
+	bool savePNG(const std::string& path);
+	static bool writePNG(const std::string& path, int width, int height, std::vector<unsigned char>& pixels); // any thread
+
+	int beginRead(); // slot, -1 - all slots are in flight (finish one first)
+	bool isReadDone(int slot) const;
+	void finishRead(int slot, std::vector<unsigned char>& pixels); // waits when not done yet, frees slot
+
+	int getWidth() const;
+	int getHeight() const;
+
+public:
+	static const int READ_SLOTS = 3;
+
+private:
+	void copyFlipped(const unsigned char* src, std::vector<unsigned char>& pixels) const;
+
+	struct ReadSlot {
+		GLuint pbo = 0;
+		GLsync fence = 0;
+		bool busy = false;
+	};
+
+private:
+	GLuint fbo = 0;
+	GLuint color_rb = 0;
+	GLuint depth_rb = 0;
+	int width = 0;
+	int height = 0;
+
+	ReadSlot read_slots[READ_SLOTS];
+};
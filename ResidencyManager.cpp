@@ -0,0 +1,253 @@
+#include "ResidencyManager.h"
+
+#include <iostream>
+
+// Owners drawn in this many last frames (the current one included) are never evicted
+static const unsigned long long PROTECTED_FRAMES = 2;
+
+ResidencyManager::ResidencyManager()
+{
+}
+
+// Owners
+void ResidencyManager::registerOwner(const void* owner, const std::string& name, std::function<void(int)> evict, std::function<void()> restore)
+{
+	Owner& o = owners[owner];
+	o.name = name;
+	o.evict = evict;
+	o.restore = restore;
+	o.last_drawn = frame;
+	accounting.setName(owner, name);
+}
+
+void ResidencyManager::unregisterOwner(const void* owner)
+{
+	auto it = owners.find(owner);
+	if (it == owners.end()) return;
+
+	for (auto& resource : it->second.buffers) account(owner, resource.second, false);
+	for (auto& resource : it->second.textures) account(owner, resource.second, false);
+	stats.buffer_bytes -= it->second.buffer_bytes;
+	stats.texture_bytes -= it->second.texture_bytes;
+	owners.erase(it);
+
+	updateUsage();
+}
+
+// Accounting
+void ResidencyManager::track(const void* owner, std::map<GLuint, Resource>& resources, size_t& owner_bytes, size_t& total_bytes, GLuint id, const Resource& resource)
+{
+	auto it = resources.find(id);
+	if (it != resources.end()) {
+		const Resource& old = it->second;
+		if (old.bytes == resource.bytes && old.mip_bytes == resource.mip_bytes && old.category == resource.category) return;
+
+		owner_bytes -= old.bytes;
+		total_bytes -= old.bytes;
+		account(owner, old, false);
+	}
+
+	resources[id] = resource;
+	owner_bytes += resource.bytes;
+	total_bytes += resource.bytes;
+	account(owner, resource, true);
+
+	updateUsage();
+}
+
+void ResidencyManager::release(const void* owner, std::map<GLuint, Resource>& resources, size_t& owner_bytes, size_t& total_bytes, GLuint id)
+{
+	auto it = resources.find(id);
+	if (it == resources.end()) return;
+
+	owner_bytes -= it->second.bytes;
+	total_bytes -= it->second.bytes;
+	account(owner, it->second, false);
+	resources.erase(it);
+
+	updateUsage();
+}
+
+// Resource goes to accounting as its category & mips (GPU_MIPS)
+void ResidencyManager::account(const void* owner, const Resource& resource, bool allocated)
+{
+	size_t bytes = resource.bytes - resource.mip_bytes;
+	if (allocated) {
+		accounting.allocate(owner, resource.category, bytes);
+		if (resource.mip_bytes > 0) accounting.allocate(owner, MEMORY_GPU_MIPS, resource.mip_bytes);
+	}
+	else {
+		accounting.release(owner, resource.category, bytes);
+		if (resource.mip_bytes > 0) accounting.release(owner, MEMORY_GPU_MIPS, resource.mip_bytes);
+	}
+}
+
+void ResidencyManager::trackBuffer(const void* owner, GLuint id, size_t bytes, MemoryCategory category)
+{
+	Resource resource;
+	resource.bytes = bytes;
+	resource.category = category;
+
+	Owner& o = owners[owner];
+	track(owner, o.buffers, o.buffer_bytes, stats.buffer_bytes, id, resource);
+}
+
+void ResidencyManager::trackTexture(const void* owner, GLuint id, size_t bytes, size_t mip_bytes)
+{
+	Resource resource;
+	resource.bytes = bytes + mip_bytes;
+	resource.mip_bytes = mip_bytes;
+	resource.category = MEMORY_GPU_TEXTURE;
+
+	Owner& o = owners[owner];
+	track(owner, o.textures, o.texture_bytes, stats.texture_bytes, id, resource);
+}
+
+void ResidencyManager::releaseBuffer(const void* owner, GLuint id)
+{
+	Owner& o = owners[owner];
+	release(owner, o.buffers, o.buffer_bytes, stats.buffer_bytes, id);
+}
+
+void ResidencyManager::releaseTexture(const void* owner, GLuint id)
+{
+	Owner& o = owners[owner];
+	release(owner, o.textures, o.texture_bytes, stats.texture_bytes, id);
+}
+
+void ResidencyManager::transferTexture(const void* from, const void* to, GLuint id)
+{
+	auto it = owners.find(from);
+	if (it == owners.end()) return;
+	auto resource = it->second.textures.find(id);
+	if (resource == it->second.textures.end()) return;
+
+	Resource moved = resource->second;
+	release(from, it->second.textures, it->second.texture_bytes, stats.texture_bytes, id);
+	Owner& o = owners[to];
+	track(to, o.textures, o.texture_bytes, stats.texture_bytes, id, moved);
+}
+
+void ResidencyManager::updateUsage()
+{
+	stats.used = stats.buffer_bytes + stats.texture_bytes;
+	if (stats.used > stats.peak) stats.peak = stats.used;
+}
+
+// Usage
+void ResidencyManager::touch(const void* owner)
+{
+	auto it = owners.find(owner);
+	if (it == owners.end()) return;
+
+	Owner& o = it->second;
+	o.last_drawn = frame;
+
+	// evicted owner is drawn again - restore it
+	if (o.level > 0 && !o.restoring && o.restore) {
+		o.restoring = true;
+		o.restore_start = std::chrono::steady_clock::now();
+		o.restore();
+	}
+}
+
+void ResidencyManager::restored(const void* owner)
+{
+	auto it = owners.find(owner);
+	if (it == owners.end()) return;
+
+	Owner& o = it->second;
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - o.restore_start).count();
+	o.level = 0;
+	o.restoring = false;
+
+	stats.restores++;
+	stats.restore_ms_last = ms;
+	stats.restore_ms_avg += (ms - stats.restore_ms_avg) / stats.restores;
+	if (ms > stats.restore_ms_max) stats.restore_ms_max = ms;
+}
+
+ResidencyManager::Owner* ResidencyManager::findVictim()
+{
+	// least recently drawn owner, which still has something to evict.
+	// Owners drawn in the last PROTECTED_FRAMES frames are skipped (would be restored right away)
+	Owner* victim = nullptr;
+	for (auto& it : owners) {
+		Owner& o = it.second;
+		if (!o.evict || o.restoring || o.level >= EVICT_FULL || o.texture_bytes == 0) continue;
+		if (frame - o.last_drawn < PROTECTED_FRAMES) continue;
+
+		if (victim == nullptr || o.last_drawn < victim->last_drawn) victim = &o;
+	}
+	return victim;
+}
+
+void ResidencyManager::update()
+{
+	if (stats.budget > 0) {
+		while (stats.used > stats.budget) {
+			Owner* victim = findVictim();
+			if (victim == nullptr) {
+				if (!warned_over_budget) {
+					std::cout << "WARN: gpu memory over budget, nothing to evict (used: " << stats.used / (1024 * 1024)
+						<< " MB, budget: " << stats.budget / (1024 * 1024) << " MB)" << std::endl;
+					warned_over_budget = true;
+				}
+				break;
+			}
+
+			int level = victim->level == 0 ? evict_mip_drop : EVICT_FULL;
+			victim->evict(level);
+			victim->level = level;
+			stats.evictions++;
+
+			std::cout << "Residency: evict " << victim->name << " (level " << level << "), used: "
+				<< stats.used / (1024 * 1024) << " MB" << std::endl;
+		}
+
+		if (stats.used <= stats.budget) warned_over_budget = false;
+	}
+
+	frame++;
+}
+
+// Settings
+void ResidencyManager::setBudget(size_t bytes)
+{
+	stats.budget = bytes;
+}
+
+size_t ResidencyManager::getBudget() const
+{
+	return stats.budget;
+}
+
+void ResidencyManager::setEvictMipDrop(int level)
+{
+	evict_mip_drop = level;
+}
+
+// Counters
+const ResidencyStats& ResidencyManager::getStats() const
+{
+	return stats;
+}
+
+size_t ResidencyManager::getOwnerUsage(const void* owner) const
+{
+	auto it = owners.find(owner);
+	if (it == owners.end()) return 0;
+	return it->second.buffer_bytes + it->second.texture_bytes;
+}
+
+int ResidencyManager::getOwnerLevel(const void* owner) const
+{
+	auto it = owners.find(owner);
+	if (it == owners.end()) return 0;
+	return it->second.level;
+}
+
+MemoryAccounting& ResidencyManager::getAccounting()
+{
+	return accounting;
+}
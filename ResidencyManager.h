@@ -0,0 +1,112 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "MemoryAccounting.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+
+/*
+	GPU memory accounting and LRU eviction.
+
+	Every GL buffer and texture is tracked by size and by owner (model),
+	and fed to MemoryAccounting by category (vertex, index, texture, mips...).
+	When usage is over the budget, textures of least recently drawn owners
+	are evicted: first down to a lower mip (evict_mip_drop), then fully (1x1).
+	Evicted owner is restored on demand (next time it's drawn) from CPU copies.
+
+	GL thread only.
+*/
+
+// Eviction level is the number of dropped mips, EVICT_FULL drops everything down to 1x1
+const int EVICT_FULL = 16;
+
+struct ResidencyStats {
+	size_t budget = 0;		// 0 - unlimited
+	size_t used = 0;
+	size_t peak = 0;
+	size_t buffer_bytes = 0;
+	size_t texture_bytes = 0;
+
+	size_t evictions = 0;
+	size_t restores = 0;
+	double restore_ms_last = 0.0;
+	double restore_ms_avg = 0.0;
+	double restore_ms_max = 0.0;
+};
+
+class ResidencyManager
+{
+public:
+	ResidencyManager();
+
+	// Owner callbacks: evict(level) must re-specify textures at given level,
+	// restore() must bring them back to level 0 and then call restored()
+	void registerOwner(const void* owner, const std::string& name, std::function<void(int)> evict, std::function<void()> restore);
+	void unregisterOwner(const void* owner); // releases all tracked resources of owner
+
+	// Accounting (tracking the same id again updates its size)
+	void trackBuffer(const void* owner, GLuint id, size_t bytes, MemoryCategory category);
+	void trackTexture(const void* owner, GLuint id, size_t bytes, size_t mip_bytes); // finest level & the rest
+	void releaseBuffer(const void* owner, GLuint id);
+	void releaseTexture(const void* owner, GLuint id);
+	void transferTexture(const void* from, const void* to, GLuint id); // shared texture outlives its owner
+
+	// Usage
+	void touch(const void* owner); // owner is drawn this frame
+	void restored(const void* owner);
+	void update(); // once per frame, evicts while over budget
+
+	// Settings
+	void setBudget(size_t bytes);
+	size_t getBudget() const;
+	void setEvictMipDrop(int level);
+
+	// Counters
+	const ResidencyStats& getStats() const;
+	size_t getOwnerUsage(const void* owner) const;
+	int getOwnerLevel(const void* owner) const;
+	MemoryAccounting& getAccounting(); // cpu side can be set from any thread
+
+private:
+	struct Resource {
+		size_t bytes = 0; // with mips
+		size_t mip_bytes = 0;
+		MemoryCategory category = MEMORY_GPU_VERTEX; // of bytes without mips
+	};
+
+	struct Owner {
+		std::string name;
+		std::map<GLuint, Resource> buffers;
+		std::map<GLuint, Resource> textures;
+		size_t buffer_bytes = 0;
+		size_t texture_bytes = 0;
+
+		std::function<void(int)> evict;
+		std::function<void()> restore;
+
+		unsigned long long last_drawn = 0;
+		int level = 0; // current eviction level
+		bool restoring = false;
+		std::chrono::steady_clock::time_point restore_start;
+	};
+
+	void track(const void* owner, std::map<GLuint, Resource>& resources, size_t& owner_bytes, size_t& total_bytes, GLuint id, const Resource& resource);
+	void release(const void* owner, std::map<GLuint, Resource>& resources, size_t& owner_bytes, size_t& total_bytes, GLuint id);
+	void account(const void* owner, const Resource& resource, bool allocated);
+	void updateUsage();
+	Owner* findVictim();
+
+private:
+	std::map<const void*, Owner> owners;
+	ResidencyStats stats;
+	MemoryAccounting accounting;
+
+	unsigned long long frame = 1;
+	int evict_mip_drop = 2; // first step of eviction (1/16 of memory)
+	bool warned_over_budget = false;
+};
@@ -0,0 +1,191 @@
+#include "ScalingBenchmark.h"
+#include "GLTFScene.h"
+#include "RenderTarget.h"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+static const double FRAME_TIME = 1.0 / 60.0;
+static const double LOAD_TIMEOUT = 300.0; // seconds per scene
+
+ScalingBenchmark::ScalingBenchmark()
+{
+}
+
+bool ScalingBenchmark::load(const std::string& path)
+{
+	std::ifstream f(path);
+	if (!f) {
+		std::cout << "ERROR: can't read scaling benchmark " << path << std::endl;
+		return false;
+	}
+	nlohmann::json json = nlohmann::json::parse(f, nullptr, false);
+	if (json.is_discarded() || !json.contains("nodes") || json["nodes"].empty()) {
+		std::cout << "ERROR: scaling benchmark " << path << " is not valid (needs \"nodes\")" << std::endl;
+		return false;
+	}
+
+	node_counts = json["nodes"].get<std::vector<int>>();
+	if (json.contains("frames")) frames = std::max(json["frames"].get<int>(), 1);
+	if (json.contains("output_dir")) output_dir = json["output_dir"].get<std::string>();
+	if (json.contains("result")) result_path = json["result"].get<std::string>();
+
+	if (json.contains("depth")) generator.depth = json["depth"].get<int>();
+	if (json.contains("meshes")) generator.meshes = json["meshes"].get<int>();
+	if (json.contains("materials")) generator.materials = json["materials"].get<int>();
+	if (json.contains("textures")) generator.textures = json["textures"].get<int>();
+	if (json.contains("texture_size")) generator.texture_size = json["texture_size"].get<int>();
+	if (json.contains("mesh_segments")) generator.mesh_segments = json["mesh_segments"].get<int>();
+	if (json.contains("instances")) generator.instances = json["instances"].get<int>();
+	if (json.contains("spacing")) generator.spacing = json["spacing"].get<float>();
+	if (json.contains("binary")) generator.binary = json["binary"].get<bool>();
+	if (json.contains("seed")) generator.seed = json["seed"].get<unsigned int>();
+
+	std::cout << "Scaling benchmark: " << path << ", " << node_counts.size() << " scenes, " << frames << " frames each" << std::endl;
+	return true;
+}
+
+bool ScalingBenchmark::run(RenderTarget& target, int width, int height)
+{
+	results.clear();
+	for (int nodes : node_counts) {
+		SceneGeneratorOptions options = generator;
+		options.nodes = nodes;
+
+		GeneratedScene scene;
+		if (!SceneGenerator::generate(options, output_dir, scene)) return false;
+
+		ScalingResult result;
+		result.nodes = scene.nodes;
+		result.triangles = scene.triangles;
+		result.file_bytes = scene.file_bytes;
+		result.generate_s = scene.seconds;
+		runScene(scene, target, width, height, result);
+		results.push_back(result);
+	}
+
+	// own stream, so cout formatting isn't changed
+	std::ostringstream table;
+	table << std::fixed << std::setprecision(2)
+		<< "Scaling: nodes, triangles, file MB, load s, cpu MB, gpu MB, draws, cpu ms, frame ms\n";
+	for (const ScalingResult& r : results) {
+		table << "  " << std::setw(8) << r.nodes << std::setw(12) << r.triangles
+			<< std::setw(10) << r.file_bytes / (1024.0 * 1024.0) << std::setw(9) << r.load_s
+			<< std::setw(10) << r.cpu_bytes / (1024.0 * 1024.0) << std::setw(10) << r.gpu_bytes / (1024.0 * 1024.0)
+			<< std::setw(9) << r.draws << std::setw(10) << r.cpu_ms << std::setw(10) << r.frame_ms
+			<< (r.loaded ? "" : "  (not loaded)") << "\n";
+	}
+	std::cout << table.str();
+	return true;
+}
+
+void ScalingBenchmark::runScene(const GeneratedScene& generated, RenderTarget& target, int width, int height, ScalingResult& result)
+{
+	size_t memory_before = getProcessMemory();
+	auto start = std::chrono::steady_clock::now();
+
+	GLTFScene* scene = new GLTFScene();
+	scene->scene_json_file = generated.scene_path;
+	scene->init();
+	scene->render_setup();
+	scene->scene_init();
+
+	// whole scene in view: instances are in a row along X, each centered on its origin
+	int instances = std::max(generator.instances, 1);
+	float row = instances * (generated.extent + generator.spacing) - generator.spacing;
+	float distance = std::max(row, generated.extent) + generator.spacing;
+	float center = (instances - 1) * (generated.extent + generator.spacing) * 0.5f;
+	scene->getCamera().SetPose(glm::vec3(center, distance * 0.5f, generated.extent * 0.5f + distance * 0.6f), -90.0f, -35.0f);
+	scene->setDepthRange(0.1f, distance * 4.0f);
+
+	long long frame = 0;
+	result.loaded = true;
+	do {
+		target.bind();
+		scene->render(width, height, frame++ * FRAME_TIME);
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > LOAD_TIMEOUT) {
+			std::cout << "WARN: " << generated.scene_path << " still loading after " << LOAD_TIMEOUT << " s, measuring anyway" << std::endl;
+			result.loaded = false;
+			break;
+		}
+	} while (scene->isLoading());
+	glFinish();
+	result.load_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	size_t memory_after = getProcessMemory();
+	result.cpu_bytes = memory_after > memory_before ? memory_after - memory_before : 0;
+	result.gpu_bytes = scene->getResidencyManager().getStats().used;
+
+	double cpu_ms = 0.0;
+	double frame_ms = 0.0;
+	for (int i = 0; i < frames; ++i) {
+		target.bind();
+		auto frame_start = std::chrono::steady_clock::now();
+		scene->render(width, height, frame++ * FRAME_TIME);
+		auto render_end = std::chrono::steady_clock::now();
+		glFinish();
+		auto frame_end = std::chrono::steady_clock::now();
+
+		cpu_ms += std::chrono::duration<double, std::milli>(render_end - frame_start).count();
+		frame_ms += std::chrono::duration<double, std::milli>(frame_end - frame_start).count();
+	}
+	result.cpu_ms = cpu_ms / frames;
+	result.frame_ms = frame_ms / frames;
+	result.draws = scene->getRenderStats().draw_calls;
+
+	scene->cleanup();
+	delete scene;
+}
+
+bool ScalingBenchmark::writeResult() const
+{
+	std::ofstream file(result_path);
+	if (!file) {
+		std::cout << "ERROR: can't write scaling result " << result_path << std::endl;
+		return false;
+	}
+
+	file << "nodes,triangles,file_bytes,generate_s,load_s,cpu_bytes,gpu_bytes,draws,cpu_ms,frame_ms,loaded\n";
+	for (const ScalingResult& r : results) {
+		file << r.nodes << "," << r.triangles << "," << r.file_bytes << "," << r.generate_s << "," << r.load_s << ","
+			<< r.cpu_bytes << "," << r.gpu_bytes << "," << r.draws << "," << r.cpu_ms << "," << r.frame_ms << ","
+			<< (r.loaded ? 1 : 0) << "\n";
+	}
+	std::cout << "Scaling result -> " << result_path << std::endl;
+	return true;
+}
+
+const std::vector<ScalingResult>& ScalingBenchmark::getResults() const
+{
+	return results;
+}
+
+size_t ScalingBenchmark::getProcessMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.WorkingSetSize;
+#else
+	// second field of statm is resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0, resident = 0;
+	if (!(statm >> pages >> resident)) return 0;
+	return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
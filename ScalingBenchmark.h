@@ -0,0 +1,59 @@
+#pragma once
+
+#include "SceneGenerator.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class RenderTarget;
+
+
+/*
+	Scaling benchmark: synthetic scenes of growing node counts (SceneGenerator) are loaded
+	and rendered one after another. Per scene: generation & load time (until nothing is loading),
+	process memory & gpu memory (ResidencyManager) after loading, draws and frame times.
+	Printed as table & written as CSV (one row per scene), for plotting against scene size.
+
+	Config (see scaling_benchmark.json): "nodes" - node counts, "frames" - measured frames per scene,
+	"output_dir" - generated files, "result" - CSV, other keys are SceneGeneratorOptions.
+	Camera looks at the whole scene from above. Headless, context must be current & glad loaded.
+*/
+
+struct ScalingResult {
+	size_t nodes = 0;
+	size_t triangles = 0;
+	size_t file_bytes = 0;
+	double generate_s = 0.0;
+	double load_s = 0.0;
+	size_t cpu_bytes = 0;	// process memory grown by loading
+	size_t gpu_bytes = 0;	// buffers & textures (ResidencyManager)
+	size_t draws = 0;		// per frame
+	double cpu_ms = 0.0;	// GLTFScene::render, mean
+	double frame_ms = 0.0;	// render & glFinish, mean
+	bool loaded = false;
+};
+
+class ScalingBenchmark
+{
+public:
+	ScalingBenchmark();
+
+	bool load(const std::string& path);
+	bool run(RenderTarget& target, int width, int height); // false - a scene couldn't be generated
+	bool writeResult() const; // CSV
+	const std::vector<ScalingResult>& getResults() const;
+
+	static size_t getProcessMemory(); // resident bytes, 0 if unknown
+
+private:
+	void runScene(const GeneratedScene& scene, RenderTarget& target, int width, int height, ScalingResult& result);
+
+private:
+	SceneGeneratorOptions generator;
+	std::vector<int> node_counts;
+	int frames = 60;
+	std::string output_dir = "generated";
+	std::string result_path = "scaling_result.csv";
+	std::vector<ScalingResult> results;
+};
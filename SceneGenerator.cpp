@@ -0,0 +1,290 @@
+#include "SceneGenerator.h"
+#include "tiny_gltf.h"
+#include "stb_image_write.h" // implementation is in tiny_gltf.cpp
+
+#include "json.hpp"
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const float PI = 3.14159265358979f;
+
+// xorshift, same sequence on every platform
+static float random01(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state & 0xFFFFFF) / float(0x1000000);
+}
+
+static size_t getFileSize(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	return file ? (size_t)file.tellg() : 0;
+}
+
+// Checker of two shades of color, RGBA
+static bool writeTexture(const std::string& path, int size, const float color[3])
+{
+	std::vector<unsigned char> pixels((size_t)size * size * 4);
+	int cell = std::max(size / 8, 1);
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			float shade = ((x / cell + y / cell) % 2 == 0) ? 1.0f : 0.55f;
+			unsigned char* p = &pixels[((size_t)y * size + x) * 4];
+			for (int c = 0; c < 3; ++c) p[c] = (unsigned char)(255.0f * color[c] * shade);
+			p[3] = 255;
+		}
+	}
+	if (!stbi_write_png(path.c_str(), size, size, 4, pixels.data(), size * 4)) {
+		std::cout << "ERROR: can't write texture " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// UV sphere, interleaved position / normal / uv (8 floats), indices local to the sphere
+static void addSphere(float radius, int segments, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+	int rings = std::max(segments / 2, 2);
+	for (int r = 0; r <= rings; ++r) {
+		float theta = PI * r / rings;
+		for (int s = 0; s <= segments; ++s) {
+			float phi = 2.0f * PI * s / segments;
+			float n[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			vertices.insert(vertices.end(), { n[0] * radius, n[1] * radius, n[2] * radius, n[0], n[1], n[2],
+				(float)s / segments, (float)r / rings });
+		}
+	}
+	// counter-clockwise from outside
+	for (int r = 0; r < rings; ++r) {
+		for (int s = 0; s < segments; ++s) {
+			uint32_t a = r * (segments + 1) + s;
+			uint32_t b = a + segments + 1;
+			indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+		}
+	}
+}
+
+static void makeDir(const std::string& dir)
+{
+#ifdef _WIN32
+	_mkdir(dir.c_str());
+#else
+	mkdir(dir.c_str(), 0755);
+#endif
+}
+
+bool SceneGenerator::generate(const SceneGeneratorOptions& options, const std::string& dir, GeneratedScene& result)
+{
+	auto start = std::chrono::steady_clock::now();
+	makeDir(dir);
+
+	int node_count = std::max(options.nodes, 2);
+	int depth = std::max(options.depth, 1);
+	int mesh_count = std::max(options.meshes, 1);
+	int material_count = std::max(options.materials, 1);
+	int texture_count = std::max(options.textures, 0);
+	int segments = std::max(options.mesh_segments, 3);
+	uint32_t random = options.seed != 0 ? options.seed : 1;
+
+	std::string name = "nodes_" + std::to_string(node_count);
+	result = GeneratedScene();
+	result.model_path = dir + "/" + name + (options.binary ? ".glb" : ".gltf");
+	result.scene_path = dir + "/scene_" + std::to_string(node_count) + ".json";
+	result.nodes = node_count;
+
+	tinygltf::Model model;
+	model.asset.version = "2.0";
+	model.asset.generator = "OpenGL_scene SceneGenerator";
+
+	// Geometry: one vertex view & one index view, accessors per mesh
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<size_t> mesh_triangles;
+	int rings = std::max(segments / 2, 2);
+	bool short_indices = (segments + 1) * (rings + 1) <= 65536;
+	size_t index_size = short_indices ? 2 : 4;
+
+	for (int m = 0; m < mesh_count; ++m) {
+		size_t first_vertex = vertices.size() / 8;
+		size_t first_index = indices.size();
+		float radius = 0.5f * (0.6f + 0.4f * random01(random)) * options.spacing * 0.8f;
+		addSphere(radius, segments, vertices, indices);
+
+		tinygltf::Accessor position;
+		position.bufferView = 0;
+		position.byteOffset = first_vertex * 32;
+		position.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+		position.count = vertices.size() / 8 - first_vertex;
+		position.type = TINYGLTF_TYPE_VEC3;
+		position.minValues = { -radius, -radius, -radius };
+		position.maxValues = { radius, radius, radius };
+
+		tinygltf::Accessor normal = position;
+		normal.byteOffset += 12;
+		normal.minValues.clear();
+		normal.maxValues.clear();
+
+		tinygltf::Accessor uv = normal;
+		uv.byteOffset += 24;
+		uv.type = TINYGLTF_TYPE_VEC2;
+
+		tinygltf::Accessor index;
+		index.bufferView = 1;
+		index.byteOffset = first_index * index_size;
+		index.componentType = short_indices ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+		index.count = indices.size() - first_index;
+		index.type = TINYGLTF_TYPE_SCALAR;
+
+		tinygltf::Primitive primitive;
+		primitive.attributes["POSITION"] = (int)model.accessors.size();
+		primitive.attributes["NORMAL"] = (int)model.accessors.size() + 1;
+		primitive.attributes["TEXCOORD_0"] = (int)model.accessors.size() + 2;
+		primitive.indices = (int)model.accessors.size() + 3;
+		primitive.material = m % material_count;
+		primitive.mode = TINYGLTF_MODE_TRIANGLES;
+		model.accessors.insert(model.accessors.end(), { position, normal, uv, index });
+
+		tinygltf::Mesh mesh;
+		mesh.name = "sphere_" + std::to_string(m);
+		mesh.primitives.push_back(primitive);
+		model.meshes.push_back(mesh);
+		mesh_triangles.push_back(index.count / 3);
+	}
+
+	tinygltf::Buffer buffer;
+	size_t vertex_bytes = vertices.size() * sizeof(float);
+	size_t index_bytes = indices.size() * index_size;
+	buffer.data.resize(vertex_bytes + index_bytes);
+	memcpy(buffer.data.data(), vertices.data(), vertex_bytes);
+	for (size_t i = 0; i < indices.size(); ++i) {
+		unsigned char* out = buffer.data.data() + vertex_bytes + i * index_size;
+		if (short_indices) {
+			uint16_t value = (uint16_t)indices[i];
+			memcpy(out, &value, 2);
+		}
+		else memcpy(out, &indices[i], 4);
+	}
+	model.buffers.push_back(buffer);
+
+	tinygltf::BufferView vertex_view;
+	vertex_view.buffer = 0;
+	vertex_view.byteLength = vertex_bytes;
+	vertex_view.byteStride = 32;
+	vertex_view.target = TINYGLTF_TARGET_ARRAY_BUFFER;
+	tinygltf::BufferView index_view;
+	index_view.buffer = 0;
+	index_view.byteOffset = vertex_bytes;
+	index_view.byteLength = index_bytes;
+	index_view.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
+	model.bufferViews.insert(model.bufferViews.end(), { vertex_view, index_view });
+
+	// Textures: PNG files next to the model
+	if (texture_count > 0) {
+		tinygltf::Sampler sampler;
+		sampler.minFilter = TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR;
+		sampler.magFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
+		model.samplers.push_back(sampler);
+	}
+	for (int t = 0; t < texture_count; ++t) {
+		float color[3] = { 0.3f + 0.7f * random01(random), 0.3f + 0.7f * random01(random), 0.3f + 0.7f * random01(random) };
+		std::string file = name + "_tex" + std::to_string(t) + ".png";
+		if (!writeTexture(dir + "/" + file, std::max(options.texture_size, 1), color)) return false;
+		result.file_bytes += getFileSize(dir + "/" + file);
+
+		tinygltf::Image image;
+		image.uri = file;
+		model.images.push_back(image);
+
+		tinygltf::Texture texture;
+		texture.sampler = 0;
+		texture.source = t;
+		model.textures.push_back(texture);
+	}
+
+	for (int m = 0; m < material_count; ++m) {
+		tinygltf::Material material;
+		material.name = "material_" + std::to_string(m);
+		material.pbrMetallicRoughness.baseColorFactor = { 0.5 + 0.5 * random01(random), 0.5 + 0.5 * random01(random),
+			0.5 + 0.5 * random01(random), 1.0 };
+		material.pbrMetallicRoughness.metallicFactor = 0.0;
+		material.pbrMetallicRoughness.roughnessFactor = 0.8;
+		if (texture_count > 0) material.pbrMetallicRoughness.baseColorTexture.index = m % texture_count;
+		model.materials.push_back(material);
+	}
+
+	// Nodes: heap ordered tree (parent of i is (i - 1) / branching), mesh nodes on a grid
+	int branching = std::max(2, (int)std::ceil(std::pow((double)(node_count - 1), 1.0 / depth)));
+	int side = (int)std::ceil(std::sqrt((double)(node_count - 1)));
+	result.extent = side * options.spacing;
+
+	std::vector<glm::vec3> positions(node_count, glm::vec3(0.0f)); // world, root at origin
+	model.nodes.resize(node_count);
+	model.nodes[0].name = "root";
+	for (int i = 1; i < node_count; ++i) {
+		int cell = i - 1;
+		positions[i] = glm::vec3((cell % side - side * 0.5f + 0.5f) * options.spacing, 0.0f,
+			(cell / side - side * 0.5f + 0.5f) * options.spacing);
+
+		int parent = (i - 1) / branching;
+		model.nodes[parent].children.push_back(i);
+
+		tinygltf::Node& node = model.nodes[i];
+		glm::vec3 local = positions[i] - positions[parent];
+		node.translation = { local.x, local.y, local.z };
+		node.mesh = (int)(random01(random) * mesh_count) % mesh_count;
+		result.triangles += mesh_triangles[node.mesh];
+	}
+	result.triangles *= std::max(options.instances, 1);
+
+	tinygltf::Scene scene;
+	scene.nodes.push_back(0);
+	model.scenes.push_back(scene);
+	model.defaultScene = 0;
+
+	tinygltf::TinyGLTF writer;
+	if (!writer.WriteGltfSceneToFile(&model, result.model_path, false, false, false, options.binary)) {
+		std::cout << "ERROR: can't write generated model " << result.model_path << std::endl;
+		return false;
+	}
+	result.file_bytes += getFileSize(result.model_path);
+	if (!options.binary) result.file_bytes += getFileSize(dir + "/" + name + ".bin");
+
+	// Scene file: instances in a row along X
+	nlohmann::json json;
+	json["_comment"] = "generated by SceneGenerator, " + std::to_string(node_count) + " nodes";
+	json["models"] = nlohmann::json::array();
+	json["transform"] = nlohmann::json::array();
+	for (int i = 0; i < std::max(options.instances, 1); ++i) {
+		json["models"].push_back(result.model_path);
+		float x = i * (result.extent + options.spacing);
+		json["transform"].push_back({ { "pos", { x, 0, 0 } }, { "rot", { 0, 0, 0 } }, { "scl", { 1, 1, 1 } } });
+	}
+	std::ofstream scene_file(result.scene_path);
+	if (!scene_file) {
+		std::cout << "ERROR: can't write generated scene " << result.scene_path << std::endl;
+		return false;
+	}
+	scene_file << json.dump(4);
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Generated " << result.model_path << ": " << node_count << " nodes (branching " << branching << "), "
+		<< mesh_count << " meshes, " << material_count << " materials, " << texture_count << " textures, "
+		<< result.file_bytes / (1024.0 * 1024.0) << " MB in " << result.seconds << " s" << std::endl;
+	return true;
+}
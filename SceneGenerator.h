@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+/*
+	Synthetic scenes for scalability testing: one glTF / GLB model with a node hierarchy
+	of given size and a scene file (scene_setup.json format) placing instances of it.
+
+	Nodes form a tree of about `depth` levels under one root (equal branching), every other node
+	has one of `meshes` meshes (UV spheres of `mesh_segments`), mesh i uses material i % materials,
+	material i samples texture i % textures (checker PNGs written next to the model).
+	Mesh nodes are laid out on a grid in XZ plane (`spacing` apart), instances are placed along X.
+	Same options & seed give the same files.
+*/
+
+struct SceneGeneratorOptions {
+	int nodes = 1000;		// including root, up to ~1M
+	int depth = 4;			// levels under root
+	int meshes = 16;
+	int materials = 8;
+	int textures = 4;		// 0 - untextured materials
+	int texture_size = 256;
+	int mesh_segments = 16;	// sphere detail (rings are half of it)
+	int instances = 1;		// models in scene file
+	float spacing = 2.0f;	// grid step of mesh nodes
+	bool binary = true;		// .glb, otherwise .gltf + .bin
+	unsigned int seed = 1;	// colors & sizes
+};
+
+struct GeneratedScene {
+	std::string model_path;
+	std::string scene_path;
+	size_t nodes = 0;
+	size_t triangles = 0;	// of all mesh nodes & instances
+	size_t file_bytes = 0;	// model & textures
+	float extent = 0.0f;	// size of one instance in XZ
+	double seconds = 0.0;	// generation time
+};
+
+class SceneGenerator
+{
+public:
+	// Files go into dir (created if missing), named by node count: nodes_<N>.glb, scene_<N>.json
+	static bool generate(const SceneGeneratorOptions& options, const std::string& dir, GeneratedScene& result);
+};
@@ -1,6 +1,12 @@
 #include "Shader.h"
+#include "GLExtensions.h"
+#include "RenderStats.h"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+#include <chrono>
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines,
+	ProgramBinaryCache* binary_cache, bool async)
+	: binary_cache(binary_cache)
 {
 	// Stage 1: read source code of frag/vert shader from filePath
 	std::string vertexCode;
@@ -34,100 +40,192 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
+	vertexCode = injectDefines(vertexCode, defines);
+	fragmentCode = injectDefines(fragmentCode, defines);
+
+	// Linked program from previous run
+	name = std::string(vertexPath) + " + " + fragmentPath;
+	for (auto& define : defines) name += " " + define;
+	if (binary_cache != nullptr) {
+		binary_key = binary_cache->getKey(vertexCode, fragmentCode);
+		ID = binary_cache->load(binary_key, name);
+		if (ID != 0) {
+			finished = linked = true;
+			return;
+		}
+	}
+	auto submit_start = std::chrono::high_resolution_clock::now();
+
 	const char* vShaderCode = vertexCode.c_str();
 	const char* fShaderCode = fragmentCode.c_str();
 
-	// Stage 2: Compile shaders
-	unsigned int vertex, fragment;
-	int success;
-	char infoLog[512];
+	// Stage 2: Compile shaders (status is checked in finish, any query waits for the compiler)
 
 	// Vertex shader
 	vertex = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex, 1, &vShaderCode, NULL);
 	glCompileShader(vertex);
-	checkCompileErrors(vertex, "VERTEX");
 
 	// Fragment shader
 	fragment = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(fragment, 1, &fShaderCode, NULL);
 	glCompileShader(fragment);
-	checkCompileErrors(vertex, "FRAGMENT");
 
 	// Shader program
 	ID = glCreateProgram();
 	glAttachShader(ID, vertex);
 	glAttachShader(ID, fragment);
+	if (binary_cache != nullptr && binary_cache->isEnabled())
+		glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ID);
+	compile_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - submit_start).count();
+
+	// async - caller polls isCompiled() and calls finish() later
+	if (!async) finish();
+}
+
+bool Shader::isCompiled() const
+{
+	// without parallel compile there is nothing to poll, finish() just waits
+	if (finished || !getGLExtensions().parallel_shader_compile) return true;
+
+	int completed = 0;
+	glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed != 0;
+}
+
+void Shader::finish()
+{
+	if (finished) return;
+	finished = true;
+	auto finish_start = std::chrono::high_resolution_clock::now();
+
+	// Show compile & linking errors if any
+	checkCompileErrors(vertex, "VERTEX");
+	checkCompileErrors(fragment, "FRAGMENT");
+	checkCompileErrors(ID, "PROGRAM");
 
-	// Show linking error if any
-	checkCompileErrors(vertex, "PROGRAM");
+	int success = 0;
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	linked = success != 0;
+
+	// Store for next run (only programs which linked)
+	compile_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - finish_start).count();
+	if (binary_cache != nullptr && linked) binary_cache->store(binary_key, name, ID, compile_ms);
 
 	// After we have associated the shaders with our program, we delete them, since we no longer need them
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+	vertex = fragment = 0;
+}
+
+bool Shader::isFinished() const
+{
+	return finished;
+}
+
+std::string Shader::injectDefines(const std::string& code, const std::vector<std::string>& defines)
+{
+	if (defines.empty()) return code;
+
+	std::string define_lines;
+	for (auto& define : defines)
+		define_lines += "#define " + define + "\n";
+
+	// #version must stay the first line
+	size_t pos = code.find("#version");
+	if (pos != std::string::npos) {
+		pos = code.find('\n', pos);
+		pos = pos == std::string::npos ? code.size() : pos + 1;
+	}
+	else pos = 0;
+	return code.substr(0, pos) + define_lines + code.substr(pos);
 }
 
 void Shader::use()
 {
 	glUseProgram(ID);
+	RenderStats::current().program_binds++;
+}
+
+bool Shader::isValid() const
+{
+	return linked;
+}
+
+void Shader::setUniformBlock(const std::string& name, unsigned int binding) const
+{
+	unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+	if (index != GL_INVALID_INDEX) glUniformBlockBinding(ID, index, binding);
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
 	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	RenderStats::current().uniform_uploads++;
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
 	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	RenderStats::current().uniform_uploads++;
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
 	glUniform1f(glGetUniformLocation(ID, name.c_str()), (float)value);
+	RenderStats::current().uniform_uploads++;
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const
 {
 	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	RenderStats::current().uniform_uploads++;
 }
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
 	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	RenderStats::current().uniform_uploads++;
 }
 // ------------------------------------------------------------------------
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
 	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	RenderStats::current().uniform_uploads++;
 }
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
 	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	RenderStats::current().uniform_uploads++;
 }
 // ------------------------------------------------------------------------
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
 	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	RenderStats::current().uniform_uploads++;
 }
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 {
 	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	RenderStats::current().uniform_uploads++;
 }
 // ------------------------------------------------------------------------
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
 	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	RenderStats::current().uniform_uploads++;
 }
 // ------------------------------------------------------------------------
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
 	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	RenderStats::current().uniform_uploads++;
 }
 // ------------------------------------------------------------------------
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
 	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	RenderStats::current().uniform_uploads++;
 }
 
 
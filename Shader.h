@@ -4,10 +4,13 @@
 
 #include <glm/glm.hpp>
 
+#include "ProgramBinaryCache.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 class Shader
 {
@@ -15,11 +18,20 @@ public:
 	// ID - program id
 	unsigned int ID;
 
-	// read data and construct shader
-	Shader(const char* vertexPath, const char* fragmentPath);
+	// read data and construct shader, defines are injected after #version
+	// with binary cache linked program is loaded from disk when sources didn't change
+	// async - compile & link are only submitted, poll isCompiled() and call finish() before use
+	Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {},
+		ProgramBinaryCache* binary_cache = nullptr, bool async = false);
+
+	bool isCompiled() const; // finish() won't wait (GL_KHR_parallel_shader_compile, always true without it)
+	void finish(); // checks errors, waits for compiler if needed
+	bool isFinished() const;
 
 	// ctivate shader
 	void use();
+	bool isValid() const; // finished & linked successfully
+	void setUniformBlock(const std::string& name, unsigned int binding) const;
 
 	// Set uniforms
 	void setBool(const std::string& name, bool value) const;
@@ -39,7 +51,21 @@ public:
 	void setMat4(const std::string& name, const glm::mat4& value) const;
 
 private:
+	static std::string injectDefines(const std::string& code, const std::vector<std::string>& defines);
+
 	// Compile checker
 	void checkCompileErrors(unsigned int shader, std::string type);
+
+private:
+	// pending compile (until finish)
+	unsigned int vertex = 0;
+	unsigned int fragment = 0;
+	bool finished = false;
+	bool linked = false;
+
+	ProgramBinaryCache* binary_cache = nullptr;
+	uint64_t binary_key = 0;
+	std::string name; // sources & defines, for logs
+	double compile_ms = 0.0; // GL thread blocked by submit & finish (frames between them aren't counted)
 };
 
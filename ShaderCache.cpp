@@ -0,0 +1,162 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+ShaderCache::ShaderCache()
+{
+}
+
+void ShaderCache::addProgram(const std::string& name, const std::string& vertex_path, const std::string& fragment_path)
+{
+	Program& program = programs[name];
+	releaseVariants(program);
+
+	program.vertex_path = vertex_path;
+	program.fragment_path = fragment_path;
+
+	// fallback is the only variant compiled synchronously, everything else waits for it
+	program.fallback = compile(name, 0, false);
+}
+
+void ShaderCache::setSetup(std::function<void(Shader&)> setup)
+{
+	this->setup = setup;
+}
+
+void ShaderCache::setBinaryCache(ProgramBinaryCache* cache)
+{
+	binary_cache = cache;
+}
+
+// Variants
+Shader* ShaderCache::precompile(const std::string& name, ShaderFeatures features)
+{
+	auto it = programs.find(name);
+	if (it == programs.end()) return nullptr;
+
+	auto variant = it->second.variants.find(hashDefines(getDefines(features)));
+	if (variant != it->second.variants.end()) return variant->second;
+
+	return compile(name, features, true);
+}
+
+Shader* ShaderCache::get(const std::string& name, ShaderFeatures features)
+{
+	auto it = programs.find(name);
+	if (it == programs.end()) return nullptr;
+
+	auto variant = it->second.variants.find(hashDefines(getDefines(features)));
+	if (variant != it->second.variants.end()) {
+		if (!variant->second->isFinished()) finishVariant(*variant->second); // waits for compiler
+		return variant->second;
+	}
+
+	std::cout << "WARN: shader variant " << name << " (" << features << ") was not precompiled" << std::endl;
+	return compile(name, features, false);
+}
+
+Shader* ShaderCache::getFallback(const std::string& name)
+{
+	auto it = programs.find(name);
+	return it != programs.end() ? it->second.fallback : nullptr;
+}
+
+void ShaderCache::update()
+{
+	// finish variants which are compiled, the rest is polled next frame
+	// (finishVariant removes from pending, so ready ones are collected first)
+	std::vector<Shader*> ready;
+	for (Shader* shader : pending) {
+		if (shader->isCompiled()) ready.push_back(shader);
+	}
+	for (Shader* shader : ready) finishVariant(*shader);
+}
+
+size_t ShaderCache::getPendingCount() const
+{
+	return pending.size();
+}
+
+Shader* ShaderCache::compile(const std::string& name, ShaderFeatures features, bool async)
+{
+	Program& program = programs[name];
+	std::vector<std::string> defines = getDefines(features);
+
+	Shader* shader = new Shader(program.vertex_path.c_str(), program.fragment_path.c_str(), defines, binary_cache, async);
+	program.variants[hashDefines(defines)] = shader;
+
+	// program binary is finished right away
+	if (!shader->isFinished()) pending.push_back(shader);
+	else runSetup(*shader);
+	return shader;
+}
+
+void ShaderCache::finishVariant(Shader& shader)
+{
+	pending.erase(std::remove(pending.begin(), pending.end(), &shader), pending.end());
+	shader.finish();
+	runSetup(shader);
+}
+
+void ShaderCache::runSetup(Shader& shader)
+{
+	if (!setup || !shader.isValid()) return;
+
+	shader.use();
+	setup(shader);
+}
+
+std::vector<std::string> ShaderCache::getDefines(ShaderFeatures features)
+{
+	static const char* names[SHADER_FEATURE_COUNT] = {
+		"HAS_BASE_COLOR_TEXTURE",
+		"ALPHA_TEST",
+		"TEXTURE_ARRAY"
+	};
+
+	// always in bit order, so the same features give the same hash
+	std::vector<std::string> defines;
+	for (unsigned int i = 0; i < SHADER_FEATURE_COUNT; ++i) {
+		if (features & (1u << i)) defines.push_back(names[i]);
+	}
+	return defines;
+}
+
+uint64_t ShaderCache::hashDefines(const std::vector<std::string>& defines)
+{
+	// FNV-1a, defines are separated by new line (as they are injected)
+	uint64_t hash = 14695981039346656037ull;
+	for (auto& define : defines) {
+		for (unsigned char c : define) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		hash ^= '\n';
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+size_t ShaderCache::getVariantCount() const
+{
+	size_t count = 0;
+	for (auto& program : programs) count += program.second.variants.size();
+	return count;
+}
+
+void ShaderCache::cleanup()
+{
+	for (auto& program : programs) releaseVariants(program.second);
+}
+
+void ShaderCache::releaseVariants(Program& program)
+{
+	program.fallback = nullptr;
+	for (auto& variant : program.variants) {
+		pending.erase(std::remove(pending.begin(), pending.end(), variant.second), pending.end());
+		glDeleteProgram(variant.second->ID);
+		delete variant.second;
+	}
+	program.variants.clear();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/*
+	Shader permutations: every program is compiled once per set of features
+	(features are injected as #defines) and cached by hash of its defines.
+
+	Materials ask for the features they use only, so a feature they don't use
+	isn't even compiled into their variant (no uniform branches at runtime).
+	Models precompile their variants when their geometry is uploaded,
+	variant missing at draw time is compiled there (with a warning).
+
+	Precompiled variants are only submitted to the driver (GL_KHR_parallel_shader_compile
+	compiles them on its threads), update() finishes the ones which are done.
+	Until then the fallback variant (no features, compiled in addProgram) is drawn instead.
+
+	GL thread only.
+*/
+
+// Feature bits, see getDefines for #define names
+enum ShaderFeature : unsigned int {
+	SHADER_BASE_COLOR_TEXTURE = 1 << 0,	// material has base color texture
+	SHADER_ALPHA_TEST = 1 << 1,			// discard below alpha_cutoff (alphaMode MASK & BLEND)
+	SHADER_TEXTURE_ARRAY = 1 << 2,		// textures are in texture array (TextureAtlas)
+	SHADER_FEATURE_COUNT = 3
+};
+typedef unsigned int ShaderFeatures;
+
+class ShaderCache
+{
+public:
+	ShaderCache();
+
+	// Program sources, replaces (deletes) variants compiled from previous ones, compiles fallback
+	void addProgram(const std::string& name, const std::string& vertex_path, const std::string& fragment_path);
+	// Called once for every new variant (program is in use), e.g. to bind samplers & uniform blocks. Before addProgram
+	void setSetup(std::function<void(Shader&)> setup);
+	void setBinaryCache(ProgramBinaryCache* cache); // linked programs from disk, nullptr - always compile. Before addProgram
+
+	Shader* precompile(const std::string& name, ShaderFeatures features); // async, not valid until finished
+	Shader* get(const std::string& name, ShaderFeatures features); // finished variant (waits/compiles), nullptr - unknown program
+	Shader* getFallback(const std::string& name); // use while variant isn't valid yet
+
+	void update(); // once per frame, finishes compiled variants
+	size_t getPendingCount() const;
+
+	static std::vector<std::string> getDefines(ShaderFeatures features);
+	static uint64_t hashDefines(const std::vector<std::string>& defines);
+
+	size_t getVariantCount() const;
+	void cleanup();
+
+private:
+	Shader* compile(const std::string& name, ShaderFeatures features, bool async);
+	void finishVariant(Shader& shader);
+	void runSetup(Shader& shader);
+
+	struct Program {
+		std::string vertex_path;
+		std::string fragment_path;
+		std::map<uint64_t, Shader*> variants; // by hash of defines
+		Shader* fallback = nullptr;
+	};
+	void releaseVariants(Program& program);
+
+private:
+	std::map<std::string, Program> programs;
+	std::vector<Shader*> pending; // submitted, not finished yet
+	std::function<void(Shader&)> setup;
+	ProgramBinaryCache* binary_cache = nullptr;
+};
@@ -0,0 +1,211 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+void TextureAtlas::build(const std::vector<tinygltf::Image>& images, std::vector<MipChain>& mips,
+	const std::vector<int>& image_indices, int max_layer_size)
+{
+	regions.assign(images.size(), AtlasRegion());
+	layers.clear();
+	layer_count = 0;
+
+	// Layer size - biggest image (limited)
+	layer_size = 0;
+	for (int ii : image_indices) {
+		if (images[ii].image.empty()) continue;
+		layer_size = std::max(layer_size, std::max(images[ii].width, images[ii].height));
+	}
+	layer_size = std::min(layer_size, max_layer_size);
+	if (layer_size == 0) return;
+
+	// Pick level of each image which fits into a layer
+	struct Item { int image; int level; int width; int height; };
+	std::vector<Item> items;
+	for (int ii : image_indices) {
+		const tinygltf::Image& image = images[ii];
+		if (image.image.empty()) continue;
+
+		Item item{ ii, 0, image.width, image.height };
+		while (item.width > layer_size || item.height > layer_size ||
+			((item.width < layer_size || item.height < layer_size) && (item.width + 2 * PADDING > layer_size || item.height + 2 * PADDING > layer_size))) {
+			item.level++;
+			item.width = std::max(1, image.width >> item.level);
+			item.height = std::max(1, image.height >> item.level);
+		}
+		items.push_back(item);
+	}
+
+	// Tall first, packs shelves better
+	std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.height > b.height; });
+
+	int atlas_layer = -1; // current atlas layer
+	int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+
+	for (auto& item : items) {
+		const tinygltf::Image& image = images[item.image];
+		if (item.level > 0 && !mips[item.image].isBuilt()) mips[item.image].build(image);
+		int width, height;
+		const unsigned char* data = mips[item.image].getLevel(image, item.level, width, height);
+
+		AtlasRegion& region = regions[item.image];
+
+		// whole layer
+		if (item.width == layer_size && item.height == layer_size) {
+			region.layer = layer_count++;
+			region.uv_transform = glm::vec4(1.0, 1.0, 0.0, 0.0);
+			layers.emplace_back((size_t)layer_size * layer_size * 4, 0);
+			copyImage(region.layer, 0, 0, data, item.width, item.height, image.component, image.bits);
+			continue;
+		}
+
+		// atlas: next shelf / next layer if doesn't fit
+		int padded_width = item.width + 2 * PADDING;
+		int padded_height = item.height + 2 * PADDING;
+		if (atlas_layer >= 0 && shelf_x + padded_width > layer_size) {
+			shelf_x = 0;
+			shelf_y += shelf_height;
+			shelf_height = 0;
+		}
+		if (atlas_layer < 0 || shelf_y + padded_height > layer_size) {
+			atlas_layer = layer_count++;
+			layers.emplace_back((size_t)layer_size * layer_size * 4, 0);
+			shelf_x = shelf_y = shelf_height = 0;
+		}
+
+		int x = shelf_x + PADDING;
+		int y = shelf_y + PADDING;
+		shelf_x += padded_width;
+		shelf_height = std::max(shelf_height, padded_height);
+
+		region.layer = atlas_layer;
+		region.uv_transform = glm::vec4((float)item.width / layer_size, (float)item.height / layer_size,
+			(float)x / layer_size, (float)y / layer_size);
+		copyImage(atlas_layer, x, y, data, item.width, item.height, image.component, image.bits);
+	}
+}
+
+void TextureAtlas::copyImage(int layer, int x, int y, const unsigned char* src, int width, int height, int component, int bits)
+{
+	std::vector<unsigned char>& dst = layers[layer];
+	int channel_size = bits == 16 ? 2 : 1;
+	int pad = (width == layer_size && height == layer_size) ? 0 : PADDING;
+
+	// edge texels are repeated into padding
+	for (int dy = -pad; dy < height + pad; ++dy) {
+		int ty = y + dy;
+		if (ty < 0 || ty >= layer_size) continue;
+		int sy = std::min(std::max(dy, 0), height - 1);
+
+		for (int dx = -pad; dx < width + pad; ++dx) {
+			int tx = x + dx;
+			if (tx < 0 || tx >= layer_size) continue;
+			int sx = std::min(std::max(dx, 0), width - 1);
+
+			// to RGBA8 (16 bit - high byte, little endian)
+			const unsigned char* s = src + ((size_t)sy * width + sx) * component * channel_size;
+			unsigned char* d = &dst[((size_t)ty * layer_size + tx) * 4];
+			unsigned char c[4] = { 0, 0, 0, 255 };
+			for (int i = 0; i < component; ++i) c[i] = s[i * channel_size + channel_size - 1];
+			if (component == 1) c[1] = c[2] = c[0];
+			if (component == 2) { c[3] = c[1]; c[1] = c[2] = c[0]; }
+
+			d[0] = c[0]; d[1] = c[1]; d[2] = c[2]; d[3] = c[3];
+		}
+	}
+}
+
+void TextureAtlas::upload()
+{
+	if (layer_count == 0 || complete) return;
+
+	for (int layer = 0; layer < layer_count; ++layer) {
+		uploadRows(layer, 0, layer_size);
+	}
+	finishUpload();
+}
+
+void TextureAtlas::uploadRows(int layer, int y, int rows)
+{
+	if (complete || layer >= (int)layers.size()) return;
+
+	if (texture == 0) {
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layer_size, layer_size, layer_count, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	else glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, y, layer, layer_size, rows, 1,
+		GL_RGBA, GL_UNSIGNED_BYTE, layers[layer].data() + (size_t)y * layer_size * 4);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureAtlas::finishUpload()
+{
+	if (texture == 0 || complete) return;
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	// wrapping is done in shader (regions), hardware wrap only matters for whole layers
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	complete = true;
+
+	// cpu copy isn't needed anymore (images are still in the model)
+	layers.clear();
+	layers.shrink_to_fit();
+}
+
+void TextureAtlas::release()
+{
+	if (texture != 0) glDeleteTextures(1, &texture);
+	texture = 0;
+	complete = false;
+}
+
+GLuint TextureAtlas::getTexture() const
+{
+	return complete ? texture : 0;
+}
+
+const AtlasRegion& TextureAtlas::getRegion(int image_index) const
+{
+	static const AtlasRegion none;
+	if (image_index < 0 || image_index >= (int)regions.size()) return none;
+	return regions[image_index];
+}
+
+int TextureAtlas::getLayerCount() const
+{
+	return layer_count;
+}
+
+int TextureAtlas::getLayerSize() const
+{
+	return layer_size;
+}
+
+size_t TextureAtlas::getBytes() const
+{
+	return (size_t)layer_size * layer_size * 4 * layer_count + getMipBytes();
+}
+
+size_t TextureAtlas::getMipBytes() const
+{
+	return (size_t)layer_size * layer_size * 4 * layer_count / 3;
+}
+
+size_t TextureAtlas::getUploadBytes() const
+{
+	return (size_t)layer_size * layer_size * 4 * layers.size();
+}
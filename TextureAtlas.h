@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "tiny_gltf.h"
+#include "MipChain.h"
+
+#include <vector>
+
+
+/*
+	All images of a model in one GL_TEXTURE_2D_ARRAY, so materials can be
+	drawn without texture binds (material = layer + uv transform).
+
+	Layers are square (size of the biggest image, max_layer_size at most).
+	Images of layer size take a whole layer, smaller ones are packed into
+	atlas layers (shelf packing, with padding), bigger ones use a smaller mip.
+
+	build() is CPU only (can run on loader thread), upload() is GL thread.
+	Upload can also be split into uploadRows calls (one upload job each) and finishUpload,
+	the texture isn't returned by getTexture until it is complete.
+*/
+
+struct AtlasRegion {
+	int layer = -1; // -1 - image is not in atlas
+	glm::vec4 uv_transform = glm::vec4(1.0, 1.0, 0.0, 0.0); // scale.xy, offset.zw
+};
+
+class TextureAtlas
+{
+public:
+	TextureAtlas();
+
+	void build(const std::vector<tinygltf::Image>& images, std::vector<MipChain>& mips,
+		const std::vector<int>& image_indices, int max_layer_size);
+	void upload();
+	void uploadRows(int layer, int y, int rows); // first call creates the texture
+	void finishUpload(); // mips, cpu layers are released
+	void release();
+
+	GLuint getTexture() const; // 0 until upload is finished
+	const AtlasRegion& getRegion(int image_index) const;
+	int getLayerCount() const;
+	int getLayerSize() const;
+	size_t getBytes() const; // gpu memory (with mips)
+	size_t getMipBytes() const; // part of getBytes
+	size_t getUploadBytes() const; // cpu data waiting for upload
+
+private:
+	void copyImage(int layer, int x, int y, const unsigned char* src, int width, int height, int component, int bits);
+
+private:
+	static const int PADDING = 4; // texels around atlas regions (filtering & mips)
+
+	std::vector<AtlasRegion> regions; // per image
+	std::vector<std::vector<unsigned char>> layers; // RGBA8, released after upload
+
+	int layer_size = 0;
+	int layer_count = 0;
+	GLuint texture = 0;
+	bool complete = false;
+};
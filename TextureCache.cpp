@@ -0,0 +1,168 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+
+TextureCache::TextureCache()
+{
+}
+
+void TextureCache::setResidencyManager(ResidencyManager* manager)
+{
+	residency = manager;
+}
+
+// FNV-1a (64 bit) of decoded pixels, check is a multiply-rotate hash (unrelated to FNV) of the same bytes
+ImageHash TextureCache::hashImage(const tinygltf::Image& image)
+{
+	ImageHash hash;
+	hash.key = 14695981039346656037ull;
+	hash.check = 0x9E3779B97F4A7C15ull;
+	for (unsigned char byte : image.image) {
+		hash.key ^= byte;
+		hash.key *= 1099511628211ull;
+
+		hash.check = (hash.check + byte + 1) * 0xC2B2AE3D27D4EB4Full;
+		hash.check = (hash.check << 31) | (hash.check >> 33);
+	}
+	return hash;
+}
+
+TextureCache::ImageKey TextureCache::getImageKey(uint64_t hash, const tinygltf::Image& image)
+{
+	return ImageKey(hash, image.width, image.height, image.component, image.bits);
+}
+
+// Textures
+GLuint TextureCache::acquire(const ImageHash& hash, const tinygltf::Image& image, const void* user)
+{
+	auto it = textures.find(getImageKey(hash.key, image));
+	if (it == textures.end()) return 0;
+
+	// key collision, different image
+	Entry& entry = entries[it->second];
+	if (entry.check != hash.check) return 0;
+
+	entry.users.push_back(user);
+
+	stats.shared++;
+	stats.saved_bytes += entry.bytes;
+	return it->second;
+}
+
+void TextureCache::insert(const ImageHash& hash, const tinygltf::Image& image, GLuint texture, const void* owner, size_t bytes)
+{
+	// key collision: texture stays private (release deletes it as not shared)
+	ImageKey key = getImageKey(hash.key, image);
+	if (textures.count(key) != 0) return;
+
+	Entry& entry = entries[texture];
+	entry.key = key;
+	entry.check = hash.check;
+	entry.owner = owner;
+	entry.holder = owner;
+	entry.users.assign(1, owner);
+	entry.bytes = bytes;
+	textures[entry.key] = texture;
+
+	stats.textures++;
+}
+
+void TextureCache::release(GLuint texture, const void* user)
+{
+	auto it = entries.find(texture);
+	if (it == entries.end()) {
+		glDeleteTextures(1, &texture); // not shared
+		return;
+	}
+
+	Entry& entry = it->second;
+	auto user_it = std::find(entry.users.begin(), entry.users.end(), user);
+	if (user_it != entry.users.end()) entry.users.erase(user_it);
+
+	if (!entry.users.empty()) {
+		stats.shared--;
+		stats.saved_bytes -= entry.bytes;
+		bool still_used = std::find(entry.users.begin(), entry.users.end(), user) != entry.users.end();
+		if (still_used) return;
+
+		// without owner texture stays at its current mips (nobody streams it anymore)
+		if (entry.owner == user) entry.owner = nullptr;
+
+		// texture stays alive, so its memory is accounted under a remaining user
+		if (entry.holder == user) {
+			entry.holder = entry.users.front();
+			if (residency != nullptr) residency->transferTexture(user, entry.holder, texture);
+		}
+		return;
+	}
+
+	textures.erase(entry.key);
+	entries.erase(it);
+	glDeleteTextures(1, &texture);
+
+	stats.textures--;
+}
+
+const void* TextureCache::getOwner(GLuint texture) const
+{
+	auto it = entries.find(texture);
+	if (it == entries.end()) return nullptr;
+	return it->second.owner;
+}
+
+// Streaming
+void TextureCache::request(GLuint texture, int level)
+{
+	auto it = entries.find(texture);
+	if (it == entries.end()) return;
+	it->second.requested = std::min(it->second.requested, level);
+}
+
+int TextureCache::takeRequest(GLuint texture)
+{
+	auto it = entries.find(texture);
+	if (it == entries.end()) return INT_MAX;
+
+	int level = it->second.requested;
+	it->second.requested = INT_MAX;
+	return level;
+}
+
+// Samplers
+GLuint TextureCache::getSampler(const tinygltf::Sampler& sampler, bool mipmapped)
+{
+	// without mips, mipmap filters would make texture incomplete
+	int min_filter = sampler.minFilter == -1 ? GL_LINEAR_MIPMAP_LINEAR : sampler.minFilter;
+	if (!mipmapped) min_filter = (min_filter == GL_NEAREST || min_filter == GL_NEAREST_MIPMAP_NEAREST
+		|| min_filter == GL_NEAREST_MIPMAP_LINEAR) ? GL_NEAREST : GL_LINEAR;
+	int mag_filter = sampler.magFilter == -1 ? GL_LINEAR : sampler.magFilter;
+
+	SamplerKey key(min_filter, mag_filter, sampler.wrapS, sampler.wrapT);
+	auto it = samplers.find(key);
+	if (it != samplers.end()) return it->second;
+
+	GLuint id;
+	glGenSamplers(1, &id);
+	glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, min_filter);
+	glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, mag_filter);
+	glSamplerParameteri(id, GL_TEXTURE_WRAP_S, sampler.wrapS);
+	glSamplerParameteri(id, GL_TEXTURE_WRAP_T, sampler.wrapT);
+
+	samplers[key] = id;
+	stats.samplers++;
+	return id;
+}
+
+void TextureCache::cleanup()
+{
+	for (auto& it : samplers) {
+		glDeleteSamplers(1, &it.second);
+	}
+	samplers.clear();
+	stats.samplers = 0;
+}
+
+const TextureCacheStats& TextureCache::getStats() const
+{
+	return stats;
+}
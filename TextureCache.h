@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "tiny_gltf.h"
+
+#include "ResidencyManager.h"
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+
+/*
+	Scene-wide sharing of textures and samplers.
+
+	Textures are keyed by a hash of decoded image data (plus size & format),
+	so identical images of different models (or different URIs) are uploaded once.
+	A hit is confirmed by a second, independent hash; on a collision the texture isn't shared.
+	First model which uploads an image owns the texture (streaming & eviction),
+	others borrow it and forward their mip requests to the owner.
+	Texture is deleted when its last user releases it.
+	Its memory is accounted (ResidencyManager) under the owner, when the owner releases it first
+	the accounting moves to one of the remaining users.
+
+	Every distinct tinygltf::Sampler maps to one GL sampler object.
+
+	GL thread only (hashImage can be called from any thread).
+*/
+
+// Hashes of decoded pixels: key finds the texture, check confirms it's the same image
+struct ImageHash {
+	uint64_t key = 0;
+	uint64_t check = 0;
+};
+
+struct TextureCacheStats {
+	size_t textures = 0;	// unique textures
+	size_t shared = 0;		// borrowed references
+	size_t samplers = 0;
+	size_t saved_bytes = 0;	// uploads avoided by sharing (full resolution)
+};
+
+class TextureCache
+{
+public:
+	TextureCache();
+
+	void setResidencyManager(ResidencyManager* manager); // shared texture accounting moves between users
+
+	static ImageHash hashImage(const tinygltf::Image& image);
+
+	// Textures
+	GLuint acquire(const ImageHash& hash, const tinygltf::Image& image, const void* user); // 0 - not cached, upload and insert it
+	void insert(const ImageHash& hash, const tinygltf::Image& image, GLuint texture, const void* owner, size_t bytes);
+	void release(GLuint texture, const void* user); // deletes texture when nobody uses it
+	const void* getOwner(GLuint texture) const;
+
+	// Streaming of shared textures: borrowers request, owner takes the finest requested level
+	void request(GLuint texture, int level);
+	int takeRequest(GLuint texture); // INT_MAX - no request
+
+	// Samplers
+	GLuint getSampler(const tinygltf::Sampler& sampler, bool mipmapped);
+
+	void cleanup(); // samplers, textures are released by their users
+
+	const TextureCacheStats& getStats() const;
+
+private:
+	typedef std::tuple<uint64_t, int, int, int, int> ImageKey; // hash, width, height, component, bits
+	typedef std::tuple<int, int, int, int> SamplerKey; // min, mag, wrap s, wrap t
+
+	static ImageKey getImageKey(uint64_t hash, const tinygltf::Image& image);
+
+	struct Entry {
+		ImageKey key;
+		uint64_t check = 0; // ImageHash::check
+		const void* owner = nullptr;
+		const void* holder = nullptr; // accounted under (owner until it releases)
+		std::vector<const void*> users; // reference per acquire (owner included)
+		size_t bytes = 0;
+		int requested = INT_MAX;
+	};
+
+private:
+	std::map<ImageKey, GLuint> textures;
+	std::map<GLuint, Entry> entries;
+	std::map<SamplerKey, GLuint> samplers;
+
+	TextureCacheStats stats;
+	ResidencyManager* residency = nullptr;
+};
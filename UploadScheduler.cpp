@@ -0,0 +1,201 @@
+#include "UploadScheduler.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+UploadScheduler::UploadScheduler()
+{
+}
+
+UploadScheduler::~UploadScheduler()
+{
+	// GL objects must be released by cleanup() while context is alive
+}
+
+void UploadScheduler::init()
+{
+	if (queries_created) return;
+
+	for (int i = 0; i < QUERY_RING; ++i) {
+		glGenQueries(2, queries[i]);
+		query_pending[i] = false;
+	}
+	queries_created = true;
+}
+
+void UploadScheduler::cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex);
+		jobs.clear();
+	}
+
+	if (queries_created) {
+		for (int i = 0; i < QUERY_RING; ++i)
+			glDeleteQueries(2, queries[i]);
+		queries_created = false;
+	}
+}
+
+void UploadScheduler::submit(const std::string& name, size_t bytes, const void* owner, std::function<void()> run)
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex);
+	jobs.push_back({ name, bytes, owner, run });
+}
+
+void UploadScheduler::cancel(const void* owner)
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex);
+	jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+		[owner](const UploadJob& job) { return job.owner == owner; }), jobs.end());
+}
+
+size_t UploadScheduler::pending() const
+{
+	std::lock_guard<std::mutex> lock(jobs_mutex);
+	return jobs.size();
+}
+
+bool UploadScheduler::idle() const
+{
+	return pending() == 0;
+}
+
+void UploadScheduler::readQueries()
+{
+	// Read back only finished queries, never wait for the GPU
+	for (int i = 0; i < QUERY_RING; ++i) {
+		if (!query_pending[i]) continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+
+		GLuint64 t_begin = 0, t_end = 0;
+		glGetQueryObjectui64v(queries[i][0], GL_QUERY_RESULT, &t_begin);
+		glGetQueryObjectui64v(queries[i][1], GL_QUERY_RESULT, &t_end);
+		query_pending[i] = false;
+
+		last_gpu_ms = (t_end - t_begin) / 1000000.0;
+		if (query_bytes[i] > 0) {
+			double sample = last_gpu_ms / query_bytes[i];
+			gpu_ms_per_byte = gpu_ms_per_byte == 0.0 ? sample : gpu_ms_per_byte * 0.8 + sample * 0.2;
+		}
+	}
+}
+
+void UploadScheduler::process()
+{
+	PROFILE_ZONE("UploadScheduler::process");
+	last_jobs = 0;
+	last_bytes = 0;
+	last_cpu_ms = 0.0;
+
+	if (queries_created) readQueries();
+	if (idle()) return;
+
+	// if the ring is full, skip gpu timing this frame (cpu timing still works)
+	int slot = query_index;
+	bool timed = queries_created && !query_pending[slot];
+	if (timed) glQueryCounter(queries[slot][0], GL_TIMESTAMP);
+
+	auto t_start = std::chrono::steady_clock::now();
+	while (true) {
+		UploadJob job;
+		{
+			std::lock_guard<std::mutex> lock(jobs_mutex);
+			if (jobs.empty()) break;
+
+			// Budget check (always let the first job through)
+			if (last_jobs > 0) {
+				double predicted_ms = last_cpu_ms + cpu_ms_per_byte * jobs.front().bytes + gpu_ms_per_byte * (last_bytes + jobs.front().bytes);
+				if (predicted_ms > time_budget_ms) break;
+				if (last_bytes + jobs.front().bytes > byte_budget) break;
+			}
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		double job_start_ms = last_cpu_ms;
+		job.run();
+
+		last_jobs++;
+		last_bytes += job.bytes;
+		last_cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+
+		// small jobs are mostly call overhead
+		if (job.bytes >= 4096) {
+			double sample = (last_cpu_ms - job_start_ms) / job.bytes;
+			cpu_ms_per_byte = cpu_ms_per_byte == 0.0 ? sample : cpu_ms_per_byte * 0.8 + sample * 0.2;
+		}
+	}
+	updateChunkBytes();
+
+	if (timed) {
+		glQueryCounter(queries[slot][1], GL_TIMESTAMP);
+		query_bytes[slot] = last_bytes;
+		query_pending[slot] = true;
+		query_index = (query_index + 1) % QUERY_RING;
+	}
+}
+
+// Budget
+void UploadScheduler::setTimeBudget(double ms)
+{
+	time_budget_ms = ms;
+	updateChunkBytes();
+}
+
+void UploadScheduler::setByteBudget(size_t bytes)
+{
+	byte_budget = bytes;
+	updateChunkBytes();
+}
+
+void UploadScheduler::updateChunkBytes()
+{
+	// a quarter of the budget, in bytes and in predicted time (small until the cost is measured)
+	size_t chunk = byte_budget / 4;
+	double ms_per_byte = cpu_ms_per_byte + gpu_ms_per_byte;
+	if (ms_per_byte > 0.0) chunk = std::min(chunk, (size_t)(time_budget_ms / 4.0 / ms_per_byte));
+	else chunk = std::min<size_t>(chunk, 256 * 1024);
+	chunk_bytes = std::max<size_t>(chunk, 64 * 1024);
+}
+
+double UploadScheduler::getTimeBudget() const
+{
+	return time_budget_ms;
+}
+
+size_t UploadScheduler::getByteBudget() const
+{
+	return byte_budget;
+}
+
+size_t UploadScheduler::getChunkBytes() const
+{
+	return chunk_bytes;
+}
+
+// Stats
+size_t UploadScheduler::getLastJobs() const
+{
+	return last_jobs;
+}
+
+size_t UploadScheduler::getLastBytes() const
+{
+	return last_bytes;
+}
+
+double UploadScheduler::getLastCpuTime() const
+{
+	return last_cpu_ms;
+}
+
+double UploadScheduler::getLastGpuTime() const
+{
+	return last_gpu_ms;
+}
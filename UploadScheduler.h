@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+
+/*
+	Frame-budgeted GL upload queue.
+
+	Jobs (buffer/texture/vao creation) can be submitted from any thread,
+	but they are executed only on the GL thread inside process().
+	Every frame process() runs jobs until the time or byte budget is spent
+	(at least one job per frame, so big jobs can't stall the queue forever).
+	Submitters split big uploads into jobs of getChunkBytes (buffer ranges, texture rows),
+	so even the job which runs regardless of the budget stays small.
+
+	Cost of a frame is measured on CPU (steady_clock) and on GPU
+	(GL_TIMESTAMP queries, read back few frames later without stalling).
+	CPU & GPU cost per byte is used to predict how much more fits in the budget
+	and how big upload jobs should be.
+*/
+
+struct UploadJob
+{
+	std::string name;
+	size_t bytes;
+	const void* owner; // used to cancel all jobs of an object
+	std::function<void()> run;
+};
+
+class UploadScheduler
+{
+public:
+	UploadScheduler();
+	~UploadScheduler();
+
+	// GL thread only
+	void init();
+	void cleanup();
+	void process();
+
+	// Any thread
+	void submit(const std::string& name, size_t bytes, const void* owner, std::function<void()> run);
+	void cancel(const void* owner);
+	size_t pending() const;
+	bool idle() const;
+
+	// Budget (per frame)
+	void setTimeBudget(double ms);
+	void setByteBudget(size_t bytes);
+	double getTimeBudget() const;
+	size_t getByteBudget() const;
+	size_t getChunkBytes() const; // size of upload jobs, several fit into the byte budget
+
+	// Stats of the last processed frame
+	size_t getLastJobs() const;
+	size_t getLastBytes() const;
+	double getLastCpuTime() const; // ms
+	double getLastGpuTime() const; // ms, few frames late
+
+private:
+	void readQueries();
+	void updateChunkBytes();
+
+private:
+	static const int QUERY_RING = 4;
+
+	std::deque<UploadJob> jobs;
+	mutable std::mutex jobs_mutex;
+
+	double time_budget_ms = 2.0;
+	size_t byte_budget = 8 * 1024 * 1024;
+
+	// timestamps (begin, end) per ring slot
+	GLuint queries[QUERY_RING][2] = {};
+	size_t query_bytes[QUERY_RING] = {};
+	bool query_pending[QUERY_RING] = {};
+	int query_index = 0;
+	bool queries_created = false;
+
+	double gpu_ms_per_byte = 0.0; // running estimate from resolved queries
+	double cpu_ms_per_byte = 0.0; // running estimate from jobs
+	std::atomic<size_t> chunk_bytes{ 256 * 1024 }; // read by submitters on any thread, small until costs are measured
+
+	size_t last_jobs = 0;
+	size_t last_bytes = 0;
+	double last_cpu_ms = 0.0;
+	double last_gpu_ms = 0.0;
+};
@@ -115,6 +115,15 @@ public:
             Zoom = 45.0f;
     }
 
+    // Places camera directly (headless poses), angles in degrees
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
 private:
     //  -  ()   
     void updateCameraVectors()
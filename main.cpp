@@ -1,9 +1,23 @@
 #include <iostream>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "GLExtensions.h"
+#include "BatchRenderer.h"
+#include "Benchmark.h"
+#include "CpuProfiler.h"
 #include "GLTFScene.h"
+#include "GLTrace.h"
+#include "HeadlessContext.h"
+#include "LoaderBenchmark.h"
+#include "NullGL.h"
+#include "RenderTarget.h"
+#include "ScalingBenchmark.h"
 
 /*
 *   https://github.com/syoyo/tinygltf - glTF loader lib  
@@ -20,15 +34,112 @@ std::string WINDOW_CAPTION = "OpenGL gltf scene";
 
 GLTFScene scene;
 
+// Command line, see printUsage
+struct CameraPose {
+    glm::vec3 position;
+    float yaw = YAW;
+    float pitch = PITCH;
+};
+
+struct Options {
+    bool headless = false;
+    int width = WINDOW_WIDTH;
+    int height = WINDOW_HEIGHT;
+    int frames = 1; // per camera pose (headless)
+    std::vector<CameraPose> cameras;
+    std::string output = "frame_%04d.png";
+    std::string scene_file;
+    int gl_major = 3;
+    int gl_minor = 3;
+    bool null_gl = false; // headless without GPU, see NullGL
+    std::string capture; // GL trace of headless run, see GLTrace
+    std::string replay; // GL trace to replay & time
+    std::string scaling; // synthetic scenes config, see ScalingBenchmark
+
+    // loader microbenchmark
+    std::string loader_bench; // folder of .gltf / .glb, see LoaderBenchmark
+    int iterations = 5;
+    std::string baseline = "loader_baseline.json";
+    bool update_baseline = false;
+
+    // batch thumbnails
+    std::string batch_list;
+    int views = 8;
+    int jobs = 2;
+    std::string output_dir = "thumbnails";
+
+    // benchmark (windowed or headless)
+    std::string benchmark;
+    std::string benchmark_out = "benchmark_result.json";
+
+    std::string cpu_trace; // chrome trace of cpu zones (CPU_PROFILER builds)
+};
+
+const double HEADLESS_FRAME_TIME = 1.0 / 60.0; // fixed time step of headless frames
+const double HEADLESS_LOAD_TIMEOUT = 300.0; // seconds to wait for models of a pose
+
+bool parseOptions(int argc, char** argv, Options& options);
+bool isFramePattern(const std::string& pattern);
+void printUsage();
+int runWindow(const Options& options);
+int runHeadless(const Options& options);
+int runBatch(const Options& options);
+int runReplay(const Options& options);
+int runScaling(const Options& options);
+int runLoaderBenchmark(const Options& options);
+int runHeadlessBenchmark(const Options& options, RenderTarget& target);
+bool finishBenchmark(const Options& options, Benchmark& benchmark, int width, int height, const std::string& mode);
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 
-int main()
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return -1;
+    }
+    if (!options.scene_file.empty())
+        scene.scene_json_file = options.scene_file;
+
+    PROFILE_THREAD("main");
+
+    int result = 0;
+    if (!options.batch_list.empty())
+        result = runBatch(options);
+    else if (!options.replay.empty())
+        result = runReplay(options);
+    else if (!options.scaling.empty())
+        result = runScaling(options);
+    else if (!options.loader_bench.empty())
+        result = runLoaderBenchmark(options);
+    else if (options.headless)
+        result = runHeadless(options);
+    else
+        result = runWindow(options);
+
+    if (!options.cpu_trace.empty())
+    {
+#ifdef CPU_PROFILER
+        CpuProfiler::writeChromeTrace(options.cpu_trace);
+#else
+        std::cout << "WARN: built without CPU_PROFILER, no cpu trace written" << std::endl;
+#endif
+    }
+    return result;
+}
+
+int runWindow(const Options& options)
 {
+    WINDOW_WIDTH = options.width;
+    WINDOW_HEIGHT = options.height;
+
     // INIT GLFW
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, options.gl_major);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, options.gl_minor);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Create window
@@ -53,6 +164,7 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress); // not covered by glad
 
     // Variables
     float deltaTime = 0.f;
@@ -62,6 +174,22 @@ int main()
     scene.render_setup(); // gpu 
 
     scene.scene_init();
+    if (!options.cameras.empty())
+        scene.getCamera().SetPose(options.cameras[0].position, options.cameras[0].yaw, options.cameras[0].pitch);
+
+    // Benchmark: camera & time come from the path, no vsync
+    Benchmark benchmark;
+    bool benchmarking = !options.benchmark.empty();
+    if (benchmarking)
+    {
+        if (!benchmark.load(options.benchmark))
+        {
+            scene.cleanup();
+            glfwTerminate();
+            return -1;
+        }
+        glfwSwapInterval(0);
+    }
 
     // Loop
     while (!glfwWindowShouldClose(window))
@@ -75,19 +203,489 @@ int main()
         scene.processInput(window, deltaTime);
 
         // Rendering
-        scene.render(window);
+        if (benchmarking)
+        {
+            if (benchmark.isFinished())
+                break;
+            int width, height;
+            glfwGetWindowSize(window, &width, &height);
+            double time = benchmark.beginFrame(scene);
+            scene.render(width, height, time);
+            benchmark.endFrame(scene);
+        }
+        else
+            scene.render(window);
 
         // Events & Buffer-swap
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    int result = 0;
+    if (benchmarking)
+    {
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        if (!finishBenchmark(options, benchmark, width, height, "window"))
+            result = -1;
+        benchmark.cleanup();
+    }
+
     scene.cleanup();
 
     glfwTerminate();
+    return result;
+}
+
+// Offscreen: every camera pose is rendered until its models & textures are loaded,
+// then options.frames frames are written as PNG (output is printf pattern of frame number).
+// Null GL: same frames without GPU, nothing is written, GL calls & cpu time are reported instead
+int runHeadless(const Options& options)
+{
+    HeadlessContext context;
+    GLADloadproc loader = NullGL::getLoader();
+    if (!options.null_gl)
+    {
+        if (!context.create(options.gl_major, options.gl_minor))
+            return -1;
+        loader = context.getLoader();
+    }
+    if (!options.capture.empty())
+    {
+        if (!GLTrace::open(options.capture))
+        {
+            context.destroy();
+            return -1;
+        }
+        loader = GLTrace::wrapLoader(loader);
+    }
+
+    if (!gladLoadGLLoader(loader))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        GLTrace::close();
+        context.destroy();
+        return -1;
+    }
+    loadGLExtensions(loader);
+
+    RenderTarget target;
+    if (!target.init(options.width, options.height))
+    {
+        GLTrace::close();
+        context.destroy();
+        return -1;
+    }
+    target.bind();
+
+    scene.init();
+    scene.render_setup();
+    scene.scene_init();
+
+    if (!options.benchmark.empty())
+    {
+        int result = runHeadlessBenchmark(options, target);
+        scene.cleanup();
+        target.cleanup();
+        GLTrace::close();
+        context.destroy();
+        return result;
+    }
+
+    std::vector<CameraPose> cameras = options.cameras;
+    if (cameras.empty())
+    {
+        Camera& camera = scene.getCamera();
+        CameraPose pose;
+        pose.position = camera.Position;
+        pose.yaw = camera.Yaw;
+        pose.pitch = camera.Pitch;
+        cameras.push_back(pose);
+    }
+
+    long long frame = 0; // drives FrameData time
+    int written = 0;
+    double render_ms = 0.0; // null GL, frames after loading
+    for (const CameraPose& pose : cameras)
+    {
+        scene.getCamera().SetPose(pose.position, pose.yaw, pose.pitch);
+
+        // loading & texture streaming of this view
+        auto wait_start = std::chrono::steady_clock::now();
+        do {
+            scene.render(options.width, options.height, frame++ * HEADLESS_FRAME_TIME);
+            GLTrace::endFrame(false);
+            double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+            if (waited > HEADLESS_LOAD_TIMEOUT)
+            {
+                std::cout << "WARN: scene still loading after " << HEADLESS_LOAD_TIMEOUT << " s, writing frames anyway" << std::endl;
+                break;
+            }
+        } while (scene.isLoading());
+
+        if (options.null_gl && written == 0)
+            NullGL::clearCalls(); // steady frames only (loading of later poses is counted)
+
+        for (int i = 0; i < options.frames; ++i)
+        {
+            auto render_start = std::chrono::steady_clock::now();
+            scene.render(options.width, options.height, frame++ * HEADLESS_FRAME_TIME);
+            render_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - render_start).count();
+            GLTrace::endFrame(true);
+
+            if (options.null_gl)
+            {
+                written++;
+                continue;
+            }
+
+            char path[1024];
+            snprintf(path, sizeof(path), options.output.c_str(), written);
+            if (!target.savePNG(path))
+            {
+                scene.cleanup();
+                target.cleanup();
+                GLTrace::close();
+                context.destroy();
+                return -1;
+            }
+            std::cout << "Frame " << written << " -> " << path << std::endl;
+            written++;
+        }
+    }
+
+    if (options.null_gl)
+    {
+        std::cout << "Null GL: " << written << " frames, cpu " << render_ms / written << " ms per frame" << std::endl;
+        NullGL::report(written);
+    }
+
+    scene.cleanup();
+    target.cleanup();
+    GLTrace::close();
+    context.destroy();
     return 0;
 }
 
+int runHeadlessBenchmark(const Options& options, RenderTarget& target)
+{
+    Benchmark benchmark;
+    if (!benchmark.load(options.benchmark))
+        return -1;
+
+    int measured = 0;
+    while (!benchmark.isFinished())
+    {
+        double time = benchmark.beginFrame(scene);
+        if (options.null_gl && benchmark.isMeasuring() && measured++ == 0)
+            NullGL::clearCalls(); // measured frames only
+        target.bind();
+        scene.render(options.width, options.height, time);
+        benchmark.endFrame(scene);
+        GLTrace::endFrame(benchmark.isMeasuring());
+    }
+    if (options.null_gl)
+        NullGL::report(measured);
+
+    bool written = finishBenchmark(options, benchmark, options.width, options.height, "headless");
+    benchmark.cleanup();
+    return written ? 0 : -1;
+}
+
+bool finishBenchmark(const Options& options, Benchmark& benchmark, int width, int height, const std::string& mode)
+{
+    if (!benchmark.isFinished())
+    {
+        std::cout << "WARN: benchmark was interrupted, no result written" << std::endl;
+        return false;
+    }
+    benchmark.report(width, height, mode);
+    if (scene.getGpuProfiler().isEnabled())
+        scene.getGpuProfiler().report();
+    return benchmark.writeReport(options.benchmark_out, width, height, mode);
+}
+
+// Thumbnails of every model in the list (always headless)
+int runBatch(const Options& options)
+{
+    BatchOptions batch;
+    if (!BatchRenderer::readList(options.batch_list, batch.models))
+        return -1;
+    batch.views = options.views;
+    batch.width = options.width;
+    batch.height = options.height;
+    batch.jobs = options.jobs;
+    batch.output_dir = options.output_dir;
+    batch.scene_file = options.scene_file;
+    batch.gl_major = options.gl_major;
+    batch.gl_minor = options.gl_minor;
+
+    BatchRenderer renderer;
+    if (!renderer.run(batch))
+        return -1;
+    return renderer.getStats().failed == 0 ? 0 : 1;
+}
+
+// Replays GL trace in headless context, prints frame times
+int runReplay(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create(options.gl_major, options.gl_minor))
+        return -1;
+    if (!gladLoadGLLoader(context.getLoader()))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        context.destroy();
+        return -1;
+    }
+    loadGLExtensions(context.getLoader());
+
+    bool replayed = GLTrace::replay(options.replay);
+    context.destroy();
+    return replayed ? 0 : -1;
+}
+
+// Synthetic scenes of growing size in headless context, load time, memory & frame time per scene
+int runScaling(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create(options.gl_major, options.gl_minor))
+        return -1;
+    if (!gladLoadGLLoader(context.getLoader()))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        context.destroy();
+        return -1;
+    }
+    loadGLExtensions(context.getLoader());
+
+    ScalingBenchmark benchmark;
+    RenderTarget target;
+    if (!benchmark.load(options.scaling) || !target.init(options.width, options.height))
+    {
+        context.destroy();
+        return -1;
+    }
+
+    bool finished = benchmark.run(target, options.width, options.height) && benchmark.writeResult();
+    target.cleanup();
+    context.destroy();
+    return finished ? 0 : -1;
+}
+
+// Stage timings of loading every asset of a folder (headless or null GL), compared to baseline file:
+// missing baseline (or --update-baseline) is written, otherwise regressions fail the run
+int runLoaderBenchmark(const Options& options)
+{
+    HeadlessContext context;
+    GLADloadproc loader = NullGL::getLoader();
+    if (!options.null_gl)
+    {
+        if (!context.create(options.gl_major, options.gl_minor))
+            return -1;
+        loader = context.getLoader();
+    }
+    if (!gladLoadGLLoader(loader))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        context.destroy();
+        return -1;
+    }
+    loadGLExtensions(loader);
+
+    LoaderBenchmarkOptions bench_options;
+    bench_options.dir = options.loader_bench;
+    bench_options.iterations = options.iterations;
+
+    LoaderBenchmark benchmark;
+    bool finished = benchmark.run(bench_options);
+    context.destroy();
+    if (!finished)
+        return -1;
+    benchmark.report();
+
+    // failed assets fail the run, baseline isn't written without them
+    size_t failed = benchmark.getFailedCount();
+    if (failed > 0)
+        std::cout << "ERROR: " << failed << " assets failed to load" << std::endl;
+
+    FILE* baseline = fopen(options.baseline.c_str(), "rb");
+    if (baseline)
+        fclose(baseline);
+    if (options.update_baseline || !baseline)
+        return failed == 0 && benchmark.writeBaseline(options.baseline) ? 0 : -1;
+
+    int regressions = benchmark.compareBaseline(options.baseline);
+    if (failed > 0 || regressions < 0)
+        return -1;
+    return regressions == 0 ? 0 : 1;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool has_value = value != nullptr;
+
+        if (arg == "--headless")
+        {
+            options.headless = true;
+            continue;
+        }
+        if (arg == "--null-gl")
+        {
+            options.headless = true;
+            options.null_gl = true;
+            continue;
+        }
+        if (arg == "--update-baseline")
+        {
+            options.update_baseline = true;
+            continue;
+        }
+        bool known = arg == "--width" || arg == "--height" || arg == "--frames" || arg == "--output"
+            || arg == "--scene" || arg == "--gl" || arg == "--camera"
+            || arg == "--batch" || arg == "--views" || arg == "--jobs" || arg == "--output-dir"
+            || arg == "--benchmark" || arg == "--benchmark-out" || arg == "--cpu-trace"
+            || arg == "--capture" || arg == "--replay" || arg == "--scaling"
+            || arg == "--loader-bench" || arg == "--iterations" || arg == "--baseline";
+        if (!known)
+        {
+            std::cout << "ERROR: unknown option " << arg << std::endl;
+            return false;
+        }
+        if (!has_value)
+        {
+            std::cout << "ERROR: " << arg << " needs a value" << std::endl;
+            return false;
+        }
+        i++;
+
+        if (arg == "--width")
+            options.width = atoi(value);
+        else if (arg == "--height")
+            options.height = atoi(value);
+        else if (arg == "--frames")
+            options.frames = atoi(value);
+        else if (arg == "--output")
+            options.output = value;
+        else if (arg == "--scene")
+            options.scene_file = value;
+        else if (arg == "--batch")
+            options.batch_list = value;
+        else if (arg == "--views")
+            options.views = atoi(value);
+        else if (arg == "--jobs")
+            options.jobs = atoi(value);
+        else if (arg == "--output-dir")
+            options.output_dir = value;
+        else if (arg == "--benchmark")
+            options.benchmark = value;
+        else if (arg == "--benchmark-out")
+            options.benchmark_out = value;
+        else if (arg == "--cpu-trace")
+            options.cpu_trace = value;
+        else if (arg == "--capture")
+        {
+            options.capture = value;
+            options.headless = true;
+        }
+        else if (arg == "--replay")
+            options.replay = value;
+        else if (arg == "--scaling")
+            options.scaling = value;
+        else if (arg == "--loader-bench")
+            options.loader_bench = value;
+        else if (arg == "--iterations")
+            options.iterations = atoi(value);
+        else if (arg == "--baseline")
+            options.baseline = value;
+        else if (arg == "--gl")
+        {
+            if (sscanf(value, "%d.%d", &options.gl_major, &options.gl_minor) != 2)
+            {
+                std::cout << "ERROR: --gl expects major.minor, got " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--camera")
+        {
+            CameraPose pose;
+            int n = sscanf(value, "%f,%f,%f,%f,%f", &pose.position.x, &pose.position.y, &pose.position.z, &pose.yaw, &pose.pitch);
+            if (n != 3 && n != 5)
+            {
+                std::cout << "ERROR: --camera expects x,y,z or x,y,z,yaw,pitch, got " << value << std::endl;
+                return false;
+            }
+            options.cameras.push_back(pose);
+        }
+    }
+
+    if (options.width <= 0 || options.height <= 0 || options.frames <= 0 || options.views <= 0 || options.jobs <= 0
+        || options.iterations <= 0)
+    {
+        std::cout << "ERROR: width, height, frames, views, jobs and iterations must be positive" << std::endl;
+        return false;
+    }
+    if (!isFramePattern(options.output))
+    {
+        std::cout << "ERROR: --output needs exactly one integer conversion (e.g. frame_%04d.png), got " << options.output << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --output is used as printf format: one %d / %i / %u (flags & width allowed), other % only as %%
+bool isFramePattern(const std::string& pattern)
+{
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        if (pattern[i] != '%')
+            continue;
+        if (++i < pattern.size() && pattern[i] == '%')
+            continue;
+
+        while (i < pattern.size() && (pattern[i] == '0' || pattern[i] == '-' || pattern[i] == '+' || pattern[i] == ' '))
+            i++;
+        while (i < pattern.size() && isdigit((unsigned char)pattern[i]))
+            i++;
+        if (i >= pattern.size() || (pattern[i] != 'd' && pattern[i] != 'i' && pattern[i] != 'u'))
+            return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: OpenGL_scene [options]\n"
+        "  --headless                  render offscreen, write frames as PNG (no window)\n"
+        "  --null-gl                   headless without GPU: GL calls are only counted, reports calls & cpu time\n"
+        "  --width N, --height N       resolution (default 800x600)\n"
+        "  --camera x,y,z[,yaw,pitch]  camera pose, repeat for more poses (degrees)\n"
+        "  --frames N                  frames written per camera pose (headless, default 1)\n"
+        "  --output PATTERN            printf pattern of frame number (default frame_%04d.png)\n"
+        "  --scene FILE                scene file (default scene_setup.json)\n"
+        "  --gl MAJOR.MINOR            context version (default 3.3)\n"
+        "  --batch LIST                thumbnails of models in LIST (one path per line), headless\n"
+        "  --views N                   turntable views per model (batch, default 8)\n"
+        "  --jobs N                    parallel contexts (batch, default 2)\n"
+        "  --output-dir DIR            thumbnails folder (batch, default thumbnails)\n"
+        "  --benchmark PATH            fly camera path PATH (json), report frame times (window or headless)\n"
+        "  --benchmark-out FILE        benchmark result (default benchmark_result.json)\n"
+        "  --cpu-trace FILE            cpu zones as chrome trace json on exit (CPU_PROFILER builds)\n"
+        "  --capture FILE              headless run, every GL call is written to trace FILE\n"
+        "  --replay FILE               replay GL trace FILE headless, report cpu & gpu frame times\n"
+        "  --scaling CONFIG            generate synthetic scenes of CONFIG (json), report load time, memory & frame time\n"
+        "  --loader-bench DIR          time load stages of every .gltf / .glb in DIR (headless, or with --null-gl)\n"
+        "  --iterations N              measured loads per asset (loader bench, default 5)\n"
+        "  --baseline FILE             loader bench baseline, written if missing (default loader_baseline.json)\n"
+        "  --update-baseline           overwrite loader bench baseline instead of comparing\n";
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
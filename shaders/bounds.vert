@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 time;
+};
+
+uniform mat4 model;
+
+void main()
+{
+    gl_Position = view_proj * model * vec4(aPos, 1.0);
+}
\ No newline at end of file
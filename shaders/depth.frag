@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth pre-pass, depth only (color writes are masked)
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// Depth pre-pass: position only, must match passthrough.vert exactly
+invariant gl_Position;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 time;
+};
+
+// Per-draw data, 8 texels per draw (see DrawDataBuffer)
+uniform samplerBuffer draw_data;
+uniform int draw_index;
+
+void main()
+{
+    int base = draw_index * 8;
+    mat4 model = mat4(texelFetch(draw_data, base), texelFetch(draw_data, base + 1),
+        texelFetch(draw_data, base + 2), texelFetch(draw_data, base + 3));
+
+    vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = view_proj * vec4(FragPos, 1.0);
+}
\ No newline at end of file
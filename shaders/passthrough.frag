@@ -6,15 +6,44 @@ in vec4 ColorFactor;
 
 out vec4 FragColor;
 
+// Variant defines (see ShaderCache): HAS_BASE_COLOR_TEXTURE, ALPHA_TEST, TEXTURE_ARRAY
+#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray tex_array;
+uniform float tex_layer = -1.0; // -1 - no texture
+uniform vec4 uv_transform = vec4(1.0, 1.0, 0.0, 0.0); // region in layer: scale.xy, offset.zw
+uniform int tex_wrap = 0; // 0 - repeat, 1 - clamp
+#else
 uniform sampler2D tex_diffuse;
+#endif
+#endif
+
+#ifdef ALPHA_TEST
+uniform float alpha_cutoff = 0.5;
+#endif
 
 void main()
 {   
-    vec4 base_color = texture(tex_diffuse, TexCoords);
-    if(base_color.a < 0.05) discard;
+    vec4 base_color = vec4(1.0);
+#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef TEXTURE_ARRAY
+    if (tex_layer >= 0.0) {
+        // wrap inside of region, gradients from unwrapped uv so mip selection doesn't jump on seams
+        vec2 uv = tex_wrap == 1 ? clamp(TexCoords, 0.0, 1.0) : fract(TexCoords);
+        uv = uv_transform.zw + uv * uv_transform.xy;
+        base_color = textureGrad(tex_array, vec3(uv, tex_layer),
+            dFdx(TexCoords) * uv_transform.xy, dFdy(TexCoords) * uv_transform.xy);
+    }
+#else
+    base_color = texture(tex_diffuse, TexCoords);
+#endif
+#endif
 
     // apply ColorFactor
     vec4 final_color = base_color * ColorFactor;
+#ifdef ALPHA_TEST
+    if(final_color.a < alpha_cutoff) discard;
+#endif
 
     FragColor = vec4(final_color);
 }
\ No newline at end of file
@@ -8,19 +8,37 @@ out vec3 FragPos;
 out vec2 TexCoords;
 
 out vec4 ColorFactor;
+flat out int MaterialIndex;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// same position as depth.vert, bit for bit (depth pre-pass draws with GL_EQUAL)
+invariant gl_Position;
 
-uniform vec4 color_factor = vec4(1.0);
+// Written once per frame (GLTFScene::render)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 camera_pos;
+    vec4 time; // x - seconds, y - delta
+};
+
+// Per-draw data, 8 texels per draw (see DrawDataBuffer)
+uniform samplerBuffer draw_data;
+uniform int draw_index;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    int base = draw_index * 8;
+    mat4 model = mat4(texelFetch(draw_data, base), texelFetch(draw_data, base + 1),
+        texelFetch(draw_data, base + 2), texelFetch(draw_data, base + 3));
+    vec4 normal0 = texelFetch(draw_data, base + 4);
+    mat3 normal_matrix = mat3(normal0.xyz, texelFetch(draw_data, base + 5).xyz, texelFetch(draw_data, base + 6).xyz);
+
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    gl_Position = view_proj * vec4(FragPos, 1.0);
+    Normal = normal_matrix * aNormal;
     TexCoords = aTexCoords;
 
-    ColorFactor = color_factor;
+    ColorFactor = texelFetch(draw_data, base + 7);
+    MaterialIndex = floatBitsToInt(normal0.w);
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#version 430 core
+#extension GL_ARB_bindless_texture : require
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+flat in int MaterialIndex;
+
+out vec4 FragColor;
+
+#ifdef ALPHA_TEST
+uniform float alpha_cutoff = 0.5;
+#endif
+
+// Same layout as GLTFModel::MaterialData (std430, 32 bytes)
+struct Material {
+    uvec2 tex_diffuse; // bindless handle, 0 - no texture
+    int has_texture;
+    int pad;
+    vec4 color_factor;
+};
+
+layout (std430, binding = 0) readonly buffer Materials {
+    Material materials[];
+};
+
+void main()
+{
+    Material material = materials[MaterialIndex];
+
+    vec4 base_color = vec4(1.0);
+#ifdef HAS_BASE_COLOR_TEXTURE
+    if (material.has_texture != 0) base_color = texture(sampler2D(material.tex_diffuse), TexCoords);
+#endif
+
+    // apply color factor
+    vec4 final_color = base_color * material.color_factor;
+#ifdef ALPHA_TEST
+    if(final_color.a < alpha_cutoff) discard;
+#endif
+
+    FragColor = vec4(final_color);
+}
\ No newline at end of file
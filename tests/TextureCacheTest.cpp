@@ -0,0 +1,95 @@
+/*
+	Shared texture accounting when the owner is released before its borrowers,
+	and a hash key collision, which must not share the texture.
+	Runs on NullGL (no GPU). Build from repo root, e.g.:
+		g++ -std=c++14 -DNDEBUG -I glad/include -I glm -I . tests/TextureCacheTest.cpp TextureCache.cpp ResidencyManager.cpp
+			MemoryAccounting.cpp NullGL.cpp tiny_gltf.cpp stb_image.cpp glad/src/glad.c -o texture_cache_test
+	Exit code 0 - passed.
+*/
+
+#include "NullGL.h"
+#include "ResidencyManager.h"
+#include "TextureCache.h"
+
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+	if (condition) return;
+	std::cout << "FAILED: " << what << std::endl;
+	failures++;
+}
+
+int main()
+{
+	if (!gladLoadGLLoader(NullGL::getLoader())) {
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 1;
+	}
+
+	ResidencyManager residency;
+	TextureCache cache;
+	cache.setResidencyManager(&residency);
+
+	int owner = 0, borrower = 0, other = 0; // stand-ins for models
+	tinygltf::Image image;
+	image.width = image.height = 4;
+	image.component = 4;
+	image.bits = 8;
+	image.image.assign(4 * 4 * 4, 128);
+	ImageHash hash = TextureCache::hashImage(image);
+
+	// owner uploads & tracks, two others borrow
+	GLuint texture;
+	glGenTextures(1, &texture);
+	cache.insert(hash, image, texture, &owner, 64);
+	residency.trackTexture(&owner, texture, 64, 0);
+	check(cache.acquire(hash, image, &borrower) == texture, "borrower gets the cached texture");
+	check(cache.acquire(hash, image, &other) == texture, "second borrower gets the cached texture");
+
+	// owner unloads first: bytes stay accounted, now under a borrower
+	cache.release(texture, &owner);
+	residency.unregisterOwner(&owner);
+	check(residency.getStats().texture_bytes == 64, "texture bytes stay accounted after owner unloads");
+	check(residency.getOwnerUsage(&owner) == 0, "owner has nothing accounted");
+	check(residency.getOwnerUsage(&borrower) == 64, "first borrower holds the texture");
+	check(residency.getAccounting().getTotal().categories[MEMORY_GPU_TEXTURE].current == 64, "memory accounting follows");
+
+	// holder unloads next, the last user takes it over
+	cache.release(texture, &borrower);
+	residency.unregisterOwner(&borrower);
+	check(residency.getOwnerUsage(&other) == 64, "last user holds the texture");
+
+	// last user releases: texture is deleted (its owner drops tracking with it)
+	cache.release(texture, &other);
+	residency.unregisterOwner(&other);
+	check(residency.getStats().texture_bytes == 0, "nothing accounted after last release");
+	check(cache.getStats().textures == 0, "texture left the cache");
+
+	// different image with the same key (forged collision): not shared, first texture stays cached
+	tinygltf::Image colliding = image;
+	colliding.image.assign(4 * 4 * 4, 64);
+	ImageHash colliding_hash = TextureCache::hashImage(colliding);
+	check(colliding_hash.check != hash.check, "check hash differs for different pixels");
+	colliding_hash.key = hash.key;
+
+	glGenTextures(1, &texture);
+	cache.insert(hash, image, texture, &owner, 64);
+	check(cache.acquire(colliding_hash, colliding, &borrower) == 0, "colliding image isn't shared");
+
+	GLuint colliding_texture;
+	glGenTextures(1, &colliding_texture);
+	cache.insert(colliding_hash, colliding, colliding_texture, &borrower, 64);
+	check(cache.acquire(hash, image, &other) == texture, "colliding insert doesn't replace the cached texture");
+	check(cache.getOwner(colliding_texture) == nullptr, "colliding texture stays private");
+
+	cache.release(colliding_texture, &borrower);
+	cache.release(texture, &other);
+	cache.release(texture, &owner);
+	check(cache.getStats().textures == 0, "texture left the cache after collision");
+
+	std::cout << (failures == 0 ? "TextureCacheTest: passed" : "TextureCacheTest: failed") << std::endl;
+	return failures == 0 ? 0 : 1;
+}